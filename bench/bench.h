@@ -0,0 +1,56 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace bench{
+
+  //prevents the optimizer from throwing away a result or assuming memory is unchanged
+  inline void escape(const void* p) {
+    asm volatile("" : : "g"(p) : "memory");
+  }
+  template <class T>
+  void keep(const T& value) {
+    escape(&value);
+  }
+
+  //makes the optimizer assume memory was changed so work is not hoisted out of the timing loop
+  inline void clobber() {
+    asm volatile("" : : : "memory");
+  }
+
+  struct suite {
+    public:
+      //initializes the benchmark suite
+      explicit suite(const std::string& suite_name) {
+        printf("%s\n", suite_name.c_str());
+      }
+      //runs the function until it has taken at least min_ms and reports the time per call
+      template <class function_t>
+      double run(const std::string& name, function_t function, double min_ms = 200.0) {
+        using clock = std::chrono::steady_clock;
+        function();
+        size_t calls = 0;
+        auto start = clock::now();
+        double elapsed = 0;
+        do {
+          clobber();
+          function();
+          ++calls;
+          elapsed = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        } while (elapsed < min_ms);
+        double per_call = elapsed / calls;
+        printf("%40s  %12.4f ms\n", name.c_str(), per_call);
+        return per_call;
+      }
+      //reports some other measurement
+      void report(const std::string& name, double value, const std::string& unit) {
+        printf("%40s  %12.4f %s\n", name.c_str(), value, unit.c_str());
+      }
+  };
+
+}
+
+#endif
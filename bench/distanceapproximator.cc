@@ -0,0 +1,54 @@
+#include "bench.h"
+#include "valhalla/midgard/distanceapproximator.h"
+#include "valhalla/midgard/constants.h"
+#include "valhalla/midgard/pointll.h"
+#include "valhalla/midgard/util.h"
+
+#include <vector>
+#include <cmath>
+
+using namespace valhalla::midgard;
+
+int main() {
+  bench::suite suite("distanceapproximator (100k points)");
+  std::vector<PointLL> pts;
+  for (int i = 0; i < 100000; ++i)
+    pts.emplace_back(-76.5f + (rand01() - 0.5f) * .2f, 40.5f + (rand01() - 0.5f) * .2f);
+  bench::escape(&pts);
+
+  // The scale on its own, as it was and as it is
+  suite.run("cosf per point", [&]() {
+    float total = 0.f;
+    for (const auto& p : pts)
+      total += cosf(p.lat() * kRadPerDeg) * kMetersPerDegreeLat;
+    bench::keep(total);
+  });
+  suite.run("MetersPerLngDegree per point", [&]() {
+    float total = 0.f;
+    for (const auto& p : pts)
+      total += DistanceApproximator::MetersPerLngDegree(p.lat());
+    bench::keep(total);
+  });
+
+  // Consecutive pairs, the scale is recomputed for every pair
+  suite.run("static DistanceSquared per pair", [&]() {
+    float total = 0.f;
+    for (size_t i = 1; i < pts.size(); ++i)
+      total += DistanceApproximator::DistanceSquared(pts[i - 1], pts[i]);
+    bench::keep(total);
+  });
+
+  // Scoring every point against one center
+  DistanceApproximator approx(PointLL(-76.5f, 40.5f));
+  std::vector<float> d2(pts.size());
+  suite.run("DistanceSquared per point", [&]() {
+    for (size_t i = 0; i < pts.size(); ++i)
+      d2[i] = approx.DistanceSquared(pts[i]);
+    bench::keep(d2.back());
+  });
+  suite.run("DistanceSquared batch", [&]() {
+    approx.DistanceSquared(pts, d2);
+    bench::keep(d2.back());
+  });
+  return 0;
+}
@@ -0,0 +1,146 @@
+#include "bench.h"
+#include "valhalla/midgard/util.h"
+#include "valhalla/midgard/pointll.h"
+#include "valhalla/midgard/aabb2.h"
+#include "valhalla/midgard/encodedpolyline.h"
+#include "valhalla/midgard/binaryshape.h"
+
+#include <vector>
+#include <string>
+#include <cmath>
+
+using namespace valhalla::midgard;
+
+int main() {
+  // 1000 shapes of 500 points, like the shapes of a batch of routes
+  std::vector<std::string> shapes;
+  size_t total = 0;
+  for (int s = 0; s < 1000; ++s) {
+    std::vector<PointLL> shape;
+    PointLL p(-76.5f + rand01(), 40.5f + rand01());
+    for (int i = 0; i < 500; ++i) {
+      p = PointLL(p.lng() + (rand01() - 0.3f) * 1e-3f, p.lat() + (rand01() - 0.3f) * 1e-3f);
+      shape.push_back(p);
+    }
+    shapes.push_back(encode(shape));
+    total += shape.size();
+  }
+  bench::suite suite("encode (1000 shapes of 500 points)");
+  bench::escape(&shapes);
+
+  auto points_per_second = [total](const double ms) { return total / ms * 1e-3; };
+  std::vector<std::vector<PointLL> > decoded;
+  for (const auto& shape : shapes)
+    decoded.push_back(decode<std::vector<PointLL> >(shape));
+  double ms = suite.run("encode", [&]() {
+    for (const auto& shape : decoded)
+      bench::keep(encode(shape).size());
+  });
+  suite.report("encode", points_per_second(ms), "million points/s");
+
+  ms = suite.run("decode to new vectors", [&]() {
+    for (const auto& shape : shapes)
+      bench::keep(decode<std::vector<PointLL> >(shape).size());
+  });
+  suite.report("decode to new vectors", points_per_second(ms), "million points/s");
+
+  std::vector<PointLL> points;
+  ms = suite.run("decode to a reused vector", [&]() {
+    for (const auto& shape : shapes) {
+      decode(shape, points);
+      bench::keep(points.size());
+    }
+  });
+  suite.report("decode to a reused vector", points_per_second(ms), "million points/s");
+
+  std::vector<float> lngs(500), lats(500);
+  ms = suite.run("decode to lng lat buffers", [&]() {
+    for (const auto& shape : shapes)
+      bench::keep(decode(shape, lngs.data(), lats.data(), lngs.size()));
+  });
+  suite.report("decode to lng lat buffers", points_per_second(ms), "million points/s");
+
+  ms = suite.run("decoded_size", [&]() {
+    for (const auto& shape : shapes)
+      bench::keep(decoded_size(shape));
+  });
+  suite.report("decoded_size", points_per_second(ms), "million points/s");
+
+  // The binary format, its size on these shapes and on densified arcs
+  std::vector<std::string> binaries, seconds, arcs, arc_binaries, arc_seconds;
+  for (const auto& shape : shapes) {
+    binaries.push_back(encoded_to_binary(shape));
+    seconds.push_back(encoded_to_binary(shape, kPolylinePrecision, true));
+  }
+  for (int s = 0; s < 1000; ++s) {
+    std::vector<PointLL> shape;
+    for (int i = 0; i < 500; ++i)
+      shape.emplace_back(-76.5 + s * 1e-3 + 0.1 * std::cos(i * 1e-3), 40.5 + 0.1 * std::sin(i * 1e-3));
+    arcs.push_back(encode(shape));
+    arc_binaries.push_back(encode_binary(shape));
+    arc_seconds.push_back(encode_binary(shape, kPolylinePrecision, true));
+  }
+  auto bytes = [](const std::vector<std::string>& strings) {
+    size_t size = 0;
+    for (const auto& s : strings)
+      size += s.size();
+    return static_cast<double>(size);
+  };
+  suite.report("binary size of text", bytes(binaries) / bytes(shapes), "");
+  suite.report("second order size of text", bytes(seconds) / bytes(shapes), "");
+  suite.report("arcs binary size of text", bytes(arc_binaries) / bytes(arcs), "");
+  suite.report("arcs second order size of text", bytes(arc_seconds) / bytes(arcs), "");
+
+  ms = suite.run("encode_binary", [&]() {
+    for (const auto& shape : decoded)
+      bench::keep(encode_binary(shape).size());
+  });
+  suite.report("encode_binary", points_per_second(ms), "million points/s");
+  ms = suite.run("decode_binary to new vectors", [&]() {
+    for (const auto& binary : binaries)
+      bench::keep(decode_binary<std::vector<PointLL> >(binary).size());
+  });
+  suite.report("decode_binary to new vectors", points_per_second(ms), "million points/s");
+  ms = suite.run("decode_binary second order", [&]() {
+    for (const auto& second : seconds)
+      bench::keep(decode_binary<std::vector<PointLL> >(second).size());
+  });
+  suite.report("decode_binary second order", points_per_second(ms), "million points/s");
+  ms = suite.run("encoded_to_binary", [&]() {
+    for (const auto& shape : shapes)
+      bench::keep(encoded_to_binary(shape).size());
+  });
+  suite.report("encoded_to_binary", points_per_second(ms), "million points/s");
+  ms = suite.run("binary_to_encoded", [&]() {
+    for (const auto& binary : binaries)
+      bench::keep(binary_to_encoded(binary).size());
+  });
+  suite.report("binary_to_encoded", points_per_second(ms), "million points/s");
+
+  // What the fused helpers save over decoding every point
+  suite.run("decode then bounding box", [&]() {
+    for (const auto& shape : shapes)
+      bench::keep(AABB2<PointLL>(decode<std::vector<PointLL> >(shape)).minx());
+  });
+  suite.run("EncodedPolyline::BoundingBox", [&]() {
+    for (const auto& shape : shapes)
+      bench::keep(EncodedPolyline(shape).BoundingBox().minx());
+  });
+  suite.run("decode then last point", [&]() {
+    for (const auto& shape : shapes)
+      bench::keep(decode<std::vector<PointLL> >(shape).back());
+  });
+  suite.run("EncodedPolyline::back", [&]() {
+    for (const auto& shape : shapes)
+      bench::keep(EncodedPolyline(shape).back());
+  });
+  suite.run("decode then length", [&]() {
+    for (const auto& shape : shapes)
+      bench::keep(length(decode<std::vector<PointLL> >(shape)));
+  });
+  suite.run("EncodedPolyline::Length", [&]() {
+    for (const auto& shape : shapes)
+      bench::keep(EncodedPolyline(shape).Length());
+  });
+  return 0;
+}
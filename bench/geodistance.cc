@@ -0,0 +1,59 @@
+#include "bench.h"
+#include "valhalla/midgard/geodistance.h"
+#include "valhalla/midgard/distanceapproximator.h"
+#include "valhalla/midgard/pointll.h"
+#include "valhalla/midgard/util.h"
+
+#include <vector>
+#include <cmath>
+
+using namespace valhalla::midgard;
+
+namespace {
+
+// Consecutive points of a 100k point random walk, segments of a few meters
+std::vector<PointLL> shape() {
+  std::vector<PointLL> pts;
+  PointLL p(-76.5f, 40.5f);
+  for (int i = 0; i < 100000; ++i) {
+    p = PointLL(p.lng() + (rand01() - 0.3f) * 1e-4f, p.lat() + (rand01() - 0.3f) * 1e-4f);
+    pts.push_back(p);
+  }
+  return pts;
+}
+
+template <class distance_t>
+double walk(const std::vector<PointLL>& pts, distance_t distance) {
+  double total = 0.0;
+  for (size_t i = 1; i < pts.size(); ++i)
+    total += distance(pts[i - 1], pts[i]);
+  return total;
+}
+
+}
+
+int main() {
+  bench::suite suite("geodistance (100k segments)");
+  auto pts = shape();
+  bench::escape(&pts);
+
+  suite.run("DistanceApproximator", [&]() {
+    bench::keep(walk(pts, [](const PointLL& a, const PointLL& b) {
+      return sqrtf(DistanceApproximator::DistanceSquared(a, b)); }));
+  });
+  suite.run("PointLL::Distance", [&]() {
+    bench::keep(walk(pts, [](const PointLL& a, const PointLL& b) { return a.Distance(b); }));
+  });
+  suite.run("Planar", [&]() { bench::keep(walk(pts, GeoDistance::Planar)); });
+  suite.run("Spherical", [&]() { bench::keep(walk(pts, GeoDistance::Spherical)); });
+  suite.run("Ellipsoidal", [&]() { bench::keep(walk(pts, GeoDistance::Ellipsoidal)); });
+  suite.run("Distance within 1 m", [&]() {
+    bench::keep(walk(pts, [](const PointLL& a, const PointLL& b) {
+      return GeoDistance::Distance(a, b, 1.0); }));
+  });
+  suite.run("Distance within 1 mm", [&]() {
+    bench::keep(walk(pts, [](const PointLL& a, const PointLL& b) {
+      return GeoDistance::Distance(a, b, 1e-3); }));
+  });
+  return 0;
+}
@@ -0,0 +1,83 @@
+#include "bench.h"
+#include "valhalla/midgard/pointll.h"
+
+#include <vector>
+#include <cstring>
+#include <cmath>
+#include <utility>
+
+using namespace valhalla::midgard;
+
+namespace {
+
+// The layout points used to have: a pair with a vtable pointer in front
+struct legacy_point_t : public std::pair<float, float> {
+  using std::pair<float, float>::pair;
+  virtual ~legacy_point_t() {}
+};
+
+template <class point_t>
+std::vector<point_t> shape(size_t count) {
+  std::vector<point_t> points;
+  points.reserve(count);
+  for (size_t i = 0; i < count; ++i)
+    points.emplace_back(-76.5f + i * 1e-5f, 40.5f + (i % 100) * 1e-5f);
+  return points;
+}
+
+// Planar length, the work is the same for both so only the memory traffic differs
+template <class point_t>
+float walk(const std::vector<point_t>& points) {
+  float total = 0.f;
+  for (size_t i = 1; i < points.size(); ++i)
+    total += sqrtf((points[i].first - points[i - 1].first) * (points[i].first - points[i - 1].first) +
+                   (points[i].second - points[i - 1].second) * (points[i].second - points[i - 1].second));
+  return total;
+}
+
+}
+
+int main() {
+  bench::suite suite("pointll");
+  const size_t count = 1000000;
+
+  auto legacy = shape<legacy_point_t>(count);
+  auto points = shape<PointLL>(count);
+  bench::escape(legacy.data());
+  bench::escape(points.data());
+  suite.report("legacy shape memory", count * sizeof(legacy_point_t) / 1048576.0, "MiB");
+  suite.report("shape memory", count * sizeof(PointLL) / 1048576.0, "MiB");
+
+  // Copying a shape
+  std::vector<legacy_point_t> legacy_copy(count);
+  suite.run("legacy copy", [&]() { std::copy(legacy.begin(), legacy.end(), legacy_copy.begin());
+                                   bench::keep(legacy_copy.back()); });
+  std::vector<PointLL> copy(count);
+  suite.run("memcpy", [&]() { memcpy(copy.data(), points.data(), count * sizeof(PointLL));
+                              bench::keep(copy.back()); });
+
+  // Streaming through a shape
+  suite.run("legacy walk", [&]() { bench::keep(walk(legacy)); });
+  suite.run("walk", [&]() { bench::keep(walk(points)); });
+
+  // Segment lengths and measures of a shape
+  std::vector<float> distances(count - 1);
+  suite.run("Distance per pair", [&]() {
+    for (size_t i = 1; i < count; ++i)
+      distances[i - 1] = points[i - 1].Distance(points[i]);
+    bench::keep(distances.back());
+  });
+  suite.run("Distances", [&]() { bench::keep(PointLL::Distances(points).back()); });
+  suite.run("CumulativeDistances", [&]() { bench::keep(PointLL::CumulativeDistances(points).back()); });
+
+  // Scoring 1000 trace points against a 50 point edge shape
+  std::vector<PointLL> edge(points.begin(), points.begin() + 50), trace;
+  for (size_t i = 0; i < 1000; ++i)
+    trace.emplace_back(edge[i % 50].lng() + 1e-4f, edge[i % 50].lat() - 1e-4f);
+  suite.run("ClosestPoint per trace point", [&]() {
+    for (const auto& p : trace)
+      bench::keep(p.ClosestPoint(edge));
+  });
+  suite.run("ClosestPoints", [&]() { bench::keep(PointLL::ClosestPoints(trace, edge)); });
+  return 0;
+}
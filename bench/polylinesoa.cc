@@ -0,0 +1,60 @@
+#include "bench.h"
+#include "valhalla/midgard/polylinesoa.h"
+#include "valhalla/midgard/polyline2.h"
+#include "valhalla/midgard/linesegment2.h"
+#include "valhalla/midgard/aabb2.h"
+#include "valhalla/midgard/pointll.h"
+#include "valhalla/midgard/util.h"
+
+#include <vector>
+
+using namespace valhalla::midgard;
+
+namespace {
+
+// A 10k point random walk, roughly a long road
+std::vector<PointLL> shape() {
+  std::vector<PointLL> pts;
+  PointLL p(-76.5f, 40.5f);
+  for (int i = 0; i < 10000; ++i) {
+    p = PointLL(p.lng() + (rand01() - 0.3f) * 1e-3f, p.lat() + (rand01() - 0.3f) * 1e-3f);
+    pts.push_back(p);
+  }
+  return pts;
+}
+
+}
+
+int main() {
+  bench::suite suite("polylinesoa (10k points)");
+  auto pts = shape();
+  Polyline2<PointLL> polyline(pts);
+  PolylineSoA<PointLL> soa(pts);
+  bench::escape(&polyline);
+  bench::escape(&soa);
+  PointLL target = pts[pts.size() / 3];
+  target.set_x(target.lng() + 1e-3f);
+
+  suite.run("Polyline2 Length", [&]() { bench::keep(polyline.Length()); });
+  suite.run("PolylineSoA Length", [&]() { bench::keep(soa.Length()); });
+
+  suite.run("Polyline2 ClosestPoint", [&]() { bench::keep(polyline.ClosestPoint(target)); });
+  suite.run("PolylineSoA ClosestPoint", [&]() { bench::keep(soa.ClosestPoint(target)); });
+
+  suite.run("AABB2 from points", [&]() { bench::keep(AABB2<PointLL>(pts)); });
+  suite.run("PolylineSoA BoundingBox", [&]() { bench::keep(soa.BoundingBox()); });
+
+  // The inner loop of Douglas-Peucker over the whole shape
+  suite.run("LineSegment2 farthest", [&]() {
+    LineSegment2<PointLL> segment(pts.front(), pts.back());
+    PointLL closest;
+    float maxdist = 0.f;
+    for (size_t k = 1; k + 1 < pts.size(); ++k)
+      maxdist = std::max(maxdist, segment.DistanceSquared(pts[k], closest));
+    bench::keep(maxdist);
+  });
+  suite.run("PolylineSoA FarthestFromSegment", [&]() {
+    bench::keep(soa.FarthestFromSegment(0, pts.size() - 1));
+  });
+  return 0;
+}
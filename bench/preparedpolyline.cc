@@ -0,0 +1,52 @@
+#include "bench.h"
+#include "valhalla/midgard/preparedpolyline.h"
+#include "valhalla/midgard/pointll.h"
+#include "valhalla/midgard/util.h"
+
+#include <vector>
+
+using namespace valhalla::midgard;
+
+namespace {
+
+// A 50k point random walk, roughly a very long road
+std::vector<PointLL> shape() {
+  std::vector<PointLL> pts;
+  PointLL p(-76.5f, 40.5f);
+  for (int i = 0; i < 50000; ++i) {
+    p = PointLL(p.lng() + (rand01() - 0.3f) * 1e-3f, p.lat() + (rand01() - 0.3f) * 1e-3f);
+    pts.push_back(p);
+  }
+  return pts;
+}
+
+// Trace points a little off the shape, like GPS noise
+std::vector<PointLL> trace(const std::vector<PointLL>& pts) {
+  std::vector<PointLL> trace;
+  for (size_t i = 0; i < pts.size(); i += 97)
+    trace.emplace_back(pts[i].lng() + (rand01() - 0.5f) * 2e-4f, pts[i].lat() + (rand01() - 0.5f) * 2e-4f);
+  return trace;
+}
+
+}
+
+int main() {
+  bench::suite suite("preparedpolyline (50k points, 516 queries)");
+  auto pts = shape();
+  auto points = trace(pts);
+  bench::escape(&pts);
+
+  suite.run("PreparedPolyline construction", [&]() { PreparedPolyline<PointLL> p(pts); bench::escape(&p); });
+  PreparedPolyline<PointLL> prepared(pts);
+  bench::escape(&prepared);
+
+  suite.run("PointLL ClosestPoint", [&]() {
+    for (const auto& p : points)
+      bench::keep(p.ClosestPoint(pts));
+  });
+  suite.run("PreparedPolyline ClosestPoint", [&]() {
+    for (const auto& p : points)
+      bench::keep(prepared.ClosestPoint(p));
+  });
+  return 0;
+}
@@ -0,0 +1,59 @@
+#include "bench.h"
+#include "valhalla/midgard/util.h"
+#include "valhalla/midgard/pointll.h"
+#include "valhalla/midgard/shapebatch.h"
+
+#include <vector>
+#include <string>
+#include <thread>
+
+using namespace valhalla::midgard;
+
+int main() {
+  // 5000 shapes of 200 points, like the shapes of a large matrix response
+  std::vector<std::vector<PointLL> > shapes;
+  size_t total = 0;
+  for (int s = 0; s < 5000; ++s) {
+    std::vector<PointLL> shape;
+    PointLL p(-76.5f + rand01(), 40.5f + rand01());
+    for (int i = 0; i < 200; ++i) {
+      p = PointLL(p.lng() + (rand01() - 0.3f) * 1e-3f, p.lat() + (rand01() - 0.3f) * 1e-3f);
+      shape.push_back(p);
+    }
+    shapes.push_back(shape);
+    total += shape.size();
+  }
+  std::vector<std::string> strings;
+  for (const auto& shape : shapes)
+    strings.push_back(encode(shape));
+  bench::suite suite("shapebatch (5000 shapes of 200 points, " +
+                     std::to_string(std::thread::hardware_concurrency()) + " cores)");
+  auto points_per_second = [total](const double ms) { return total / ms * 1e-3; };
+
+  double ms = suite.run("encode one at a time", [&]() {
+    for (const auto& shape : shapes)
+      bench::keep(encode(shape).size());
+  });
+  suite.report("encode one at a time", points_per_second(ms), "million points/s");
+  for (unsigned int threads : {1u, 0u}) {
+    std::string name = "encode_shapes " + std::string(threads ? "1 thread" : "all cores");
+    ms = suite.run(name, [&]() {
+      bench::keep(encode_shapes(shapes, kPolylinePrecision, threads).data.size());
+    });
+    suite.report(name, points_per_second(ms), "million points/s");
+  }
+
+  ms = suite.run("decode one at a time", [&]() {
+    for (const auto& s : strings)
+      bench::keep(decode<std::vector<PointLL> >(s).size());
+  });
+  suite.report("decode one at a time", points_per_second(ms), "million points/s");
+  for (unsigned int threads : {1u, 0u}) {
+    std::string name = "decode_shapes " + std::string(threads ? "1 thread" : "all cores");
+    ms = suite.run(name, [&]() {
+      bench::keep(decode_shapes(strings, kPolylinePrecision, threads).points.size());
+    });
+    suite.report(name, points_per_second(ms), "million points/s");
+  }
+  return 0;
+}
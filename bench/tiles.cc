@@ -0,0 +1,54 @@
+#include "bench.h"
+#include "valhalla/midgard/tiles.h"
+#include "valhalla/midgard/polyline2.h"
+#include "valhalla/midgard/aabb2.h"
+#include "valhalla/midgard/pointll.h"
+#include "valhalla/midgard/util.h"
+
+#include <vector>
+#include <set>
+#include <string>
+
+using namespace valhalla::midgard;
+
+namespace {
+
+// A 10k point random walk, about a degree long
+std::vector<PointLL> shape() {
+  std::vector<PointLL> pts;
+  PointLL p(-76.5f, 40.5f);
+  for (int i = 0; i < 10000; ++i) {
+    p = PointLL(p.lng() + (rand01() - 0.3f) * 4e-4f, p.lat() + (rand01() - 0.3f) * 4e-4f);
+    pts.push_back(p);
+  }
+  return pts;
+}
+
+}
+
+int main() {
+  auto pts = shape();
+  Tiles<PointLL> tiles(AABB2<PointLL>(-180.f, -90.f, 180.f, 90.f), .05f);
+  std::vector<TilePiece> pieces;
+  std::vector<PointLL> points;
+  std::vector<uint32_t> segments;
+  tiles.Split(pts, pieces, points, segments);
+  std::set<int32_t> touched;
+  for (const auto& piece : pieces)
+    touched.insert(piece.tileid);
+  bench::suite suite("tiles (10k points, " + std::to_string(touched.size()) + " tiles)");
+  bench::escape(&pts);
+
+  // What the tile cutter does today, clip the whole shape for every tile
+  suite.run("ClippedPolyline per tile", [&]() {
+    Polyline2<PointLL> polyline(pts);
+    for (const auto tileid : touched)
+      bench::keep(polyline.ClippedPolyline(tiles.TileBounds(tileid)).pts().size());
+  });
+
+  suite.run("Tiles::Split", [&]() {
+    tiles.Split(pts, pieces, points, segments);
+    bench::keep(pieces.size());
+  });
+  return 0;
+}
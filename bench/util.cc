@@ -0,0 +1,65 @@
+#include "bench.h"
+#include "valhalla/midgard/util.h"
+#include "valhalla/midgard/pointll.h"
+
+#include <vector>
+#include <cmath>
+
+using namespace valhalla::midgard;
+
+namespace {
+
+// What resample_spherical_polyline did before, trig for every point
+std::vector<PointLL> previous_resample(const std::vector<PointLL>& polyline, double resolution) {
+  const double rad_per_deg = M_PI / 180.0;
+  std::vector<PointLL> resampled{ polyline.front() };
+  resolution /= 6378160.187;
+  double remaining = resolution;
+  PointLL last = resampled.back();
+  for (auto p = std::next(polyline.cbegin()); p != polyline.cend(); ++p) {
+    auto lon2 = p->first * -rad_per_deg;
+    auto lat2 = p->second * rad_per_deg;
+    auto d = acos(sin(last.second * rad_per_deg) * sin(lat2) +
+                  cos(last.second * rad_per_deg) * cos(lat2) * cos(last.first * -rad_per_deg - lon2));
+    while (d > remaining) {
+      auto lon1 = last.first * -rad_per_deg;
+      auto lat1 = last.second * rad_per_deg;
+      auto sd = sin(d);
+      auto a = sin(d - remaining) / sd;
+      auto acs1 = a * cos(lat1);
+      auto b = sin(remaining) / sd;
+      auto bcs2 = b * cos(lat2);
+      auto x = acs1 * cos(lon1) + bcs2 * cos(lon2);
+      auto y = acs1 * sin(lon1) + bcs2 * sin(lon2);
+      auto z = a * sin(lat1) + b * sin(lat2);
+      last.first = atan2(y, x) * -180.0 / M_PI;
+      last.second = atan2(z, sqrt(x * x + y * y)) * 180.0 / M_PI;
+      resampled.push_back(last);
+      d -= remaining;
+      remaining = resolution;
+    }
+    remaining -= d;
+    last = *p;
+  }
+  return resampled;
+}
+
+}
+
+int main() {
+  // A trace of 1000 points about 20 m apart, densified to 1 m
+  std::vector<PointLL> trace;
+  PointLL p(-76.5f, 40.5f);
+  for (int i = 0; i < 1000; ++i) {
+    p = PointLL(p.lng() + (rand01() - 0.3f) * 2e-4f, p.lat() + (rand01() - 0.3f) * 2e-4f);
+    trace.push_back(p);
+  }
+  bench::suite suite("util (1000 point trace at 1 m)");
+  bench::escape(&trace);
+
+  suite.run("previous resample", [&]() { bench::keep(previous_resample(trace, 1.0).size()); });
+  suite.run("resample_spherical_polyline", [&]() {
+    bench::keep(resample_spherical_polyline(trace, 1.0).size());
+  });
+  return 0;
+}
@@ -15,6 +15,27 @@ namespace {
     return std::abs(v - a) <= d && std::abs(v - b) <= d;
   }
 
+  //one Liang-Barsky edge test: p is the (signed) component of the segment
+  //direction towards the outside of the edge and q how far inside the edge
+  //the segment starts. narrows [t0, t1], false if nothing is left
+  bool liang_barsky(const float p, const float q, float& t0, float& t1) {
+    if (p == 0.0f)
+      return q >= 0.0f;
+    float r = q / p;
+    if (p < 0.0f) {
+      if (r > t1)
+        return false;
+      if (r > t0)
+        t0 = r;
+    } else {
+      if (r < t0)
+        return false;
+      if (r < t1)
+        t1 = r;
+    }
+    return true;
+  }
+
 }
 
 namespace valhalla {
@@ -250,63 +271,129 @@ template <class coord_t>
 uint32_t AABB2<coord_t>::Clip(std::vector<coord_t>& pts, const bool closed) const {
   // Temporary vertex list
   std::vector<coord_t> tmp_pts;
+  return Clip(pts, closed, tmp_pts);
+}
 
-  // Clip against each edge in succession. At each step we swap the roles
-  // of the 2 vertex lists. If at any time there are no points remaining we
-  // return 0 (everything outside)
-  if (ClipAgainstEdge(kLeft, closed, pts, tmp_pts) == 0) {
-    return 0;
-  }
-  if (ClipAgainstEdge(kRight, closed, tmp_pts, pts) == 0) {
-    return 0;
-  }
-  if (ClipAgainstEdge(kBottom, closed, pts, tmp_pts) == 0) {
-    return 0;
-  }
-  if (ClipAgainstEdge(kTop, closed, tmp_pts, pts) == 0) {
-    return 0;
+// Clips the input set of vertices to the specified boundary in one pass,
+// every vertex is pushed through all four edges as it is read.
+template <class coord_t>
+uint32_t AABB2<coord_t>::Clip(std::vector<coord_t>& pts, const bool closed,
+                              std::vector<coord_t>& scratch) const {
+  scratch.clear();
+  ClipStage stages[4];
+  for (auto& stage : stages)
+    stage.started = false;
+  for (const auto& pt : pts)
+    ClipVertex(kLeft, pt, closed, stages, scratch);
+
+  // For polygons connect the last vertex to the first at each edge, in
+  // order, since each one can add vertices for the edges after it
+  if (closed) {
+    for (uint32_t edge = kLeft; edge <= kTop; ++edge) {
+      if (stages[edge].started)
+        ClipSegment(edge, stages[edge].prev, stages[edge].first, closed, stages, scratch);
+    }
   }
 
   // Return number of vertices in the clipped shape
+  pts.swap(scratch);
   return pts.size();
 }
 
-// Clips the polyline/polygon against a single edge.
+// Clips an open polyline into the parts inside the boundary.
 template <class coord_t>
-uint32_t AABB2<coord_t>::ClipAgainstEdge(const ClipEdge bdry,
-                              const bool closed,
-                              const std::vector<coord_t>& vin,
-                              std::vector<coord_t>& vout) const {
-  // Clear the output vector
-  vout.clear();
-
-  // Special case for the 1st vertex. For polygons (closed) connect
-  // last vertex to first vertex. For polylines repeat the first vertex
-  uint32_t n  = vin.size();
-  uint32_t v1 = closed ? n - 1 : 0;
-
-  // Loop through all vertices (edges are created from v1 to v2).
-  for (uint32_t v2 = 0; v2 < n; v1 = v2, v2++) {
-    // Relation of v1 and v2 with the bdry
-    bool v1in = Inside(bdry, vin[v1]);
-    bool v2in = Inside(bdry, vin[v2]);
-
-    // Add vertices to the output list based on the 4 cases
-    if (v1in && v2in) {
-      // Both vertices inside - output v2
-      Add(vin[v2], vout);
-    } else if (!v1in && v2in) {
-      // v1 is outside and v2 is inside - clip and add intersection
-      // followed by v2
-      Add(ClipIntersection(bdry, vin[v2], vin[v1]), vout);
-      Add(vin[v2], vout);
-    } else if (v1in && !v2in) {
-      // v1 is inside and v2 is outside - clip and add the intersection
-      Add(ClipIntersection(bdry, vin[v1], vin[v2]), vout);
+uint32_t AABB2<coord_t>::ClipParts(const std::vector<coord_t>& pts, std::vector<coord_t>& parts,
+                                   std::vector<uint32_t>& offsets) const {
+  parts.clear();
+  offsets.clear();
+
+  // Whether the last part ends at the start of the current segment
+  bool open = false;
+  for (uint32_t i = 1; i < pts.size(); ++i) {
+    // Liang-Barsky: narrow the parametric range [t0, t1] of the segment
+    // against each edge
+    const coord_t& a = pts[i - 1];
+    const coord_t& b = pts[i];
+    float dx = b.x() - a.x(), dy = b.y() - a.y();
+    float t0 = 0.0f, t1 = 1.0f;
+    if (!liang_barsky(-dx, a.x() - minx_, t0, t1) || !liang_barsky(dx, maxx_ - a.x(), t0, t1) ||
+        !liang_barsky(-dy, a.y() - miny_, t0, t1) || !liang_barsky(dy, maxy_ - a.y(), t0, t1)) {
+      open = false;
+      continue;
+    }
+    coord_t p0 = t0 > 0.0f ? coord_t(a.x() + t0 * dx, a.y() + t0 * dy) : a;
+    coord_t p1 = t1 < 1.0f ? coord_t(a.x() + t1 * dx, a.y() + t1 * dy) : b;
+
+    // Continue the current part or start a new one. A segment that only
+    // touches the boundary doesn't start a part
+    if (!open) {
+      if (p0 == p1)
+        continue;
+      offsets.push_back(parts.size());
+      parts.push_back(p0);
     }
-    // Both are outside - do nothing
+    if (!(p1 == parts.back()))
+      parts.push_back(p1);
+    open = t1 == 1.0f;
+  }
+  offsets.push_back(parts.size());
+  return offsets.size() - 1;
+}
+
+// Passes a vertex through the clipping pipeline.
+template <class coord_t>
+void AABB2<coord_t>::ClipVertex(const uint32_t edge, const coord_t& v, const bool closed,
+                                ClipStage* stages, std::vector<coord_t>& vout) const {
+  // Out of the last edge
+  if (edge > kTop) {
+    Add(v, vout);
+    return;
+  }
+
+  // Special case for the 1st vertex. For polygons (closed) the edge from
+  // the last vertex to the first is clipped once all vertices are in. For
+  // polylines repeat the first vertex
+  ClipStage& stage = stages[edge];
+  if (!stage.started) {
+    stage.started = true;
+    stage.first = stage.prev = v;
+    if (!closed && Inside(static_cast<ClipEdge>(edge), v))
+      ClipVertex(edge + 1, v, closed, stages, vout);
+    return;
+  }
+
+  // Repeated vertices would have been dropped before reaching this edge
+  if (v == stage.prev)
+    return;
+  coord_t v1 = stage.prev;
+  stage.prev = v;
+  ClipSegment(edge, v1, v, closed, stages, vout);
+}
+
+// Clips the segment from v1 to v2 against a single edge.
+template <class coord_t>
+void AABB2<coord_t>::ClipSegment(const uint32_t edge, const coord_t& v1, const coord_t& v2,
+                                 const bool closed, ClipStage* stages,
+                                 std::vector<coord_t>& vout) const {
+  // Relation of v1 and v2 with the bdry
+  ClipEdge bdry = static_cast<ClipEdge>(edge);
+  bool v1in = Inside(bdry, v1);
+  bool v2in = Inside(bdry, v2);
+
+  // Pass vertices on to the next edge based on the 4 cases
+  if (v1in && v2in) {
+    // Both vertices inside - output v2
+    ClipVertex(edge + 1, v2, closed, stages, vout);
+  } else if (!v1in && v2in) {
+    // v1 is outside and v2 is inside - clip and add intersection
+    // followed by v2
+    ClipVertex(edge + 1, ClipIntersection(bdry, v2, v1), closed, stages, vout);
+    ClipVertex(edge + 1, v2, closed, stages, vout);
+  } else if (v1in && !v2in) {
+    // v1 is inside and v2 is outside - clip and add the intersection
+    ClipVertex(edge + 1, ClipIntersection(bdry, v1, v2), closed, stages, vout);
   }
-  return vout.size();
+  // Both are outside - do nothing
 }
 
 // Finds the intersection of the segment from insidept to outsidept with the
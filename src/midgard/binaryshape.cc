@@ -0,0 +1,43 @@
+#include "midgard/binaryshape.h"
+
+namespace valhalla {
+namespace midgard {
+
+//the integers of the text are copied over as they are decoded
+std::string encoded_to_binary(const std::string& encoded, const int precision,
+                              const bool second_order) {
+  size_t count = decoded_size(encoded);
+  std::string output;
+  binary::write_header(output, count, precision, second_order);
+  binary::writer_t writer(output, count, second_order);
+  encoding::decode_points(encoded.data(), encoded.data() + encoded.size(),
+                          [&writer](const int lon, const int lat) {
+    writer(lon, lat);
+  });
+  writer.finish();
+  return output;
+}
+
+//the integers of the shape are written as text as they are read
+std::string binary_to_encoded(const std::string& bytes) {
+  const char* p = bytes.data();
+  const char* end = p + bytes.size();
+  int precision;
+  bool second_order;
+  size_t count = binary::read_header(p, end, precision, second_order);
+  std::string output(count * 6, '\0');
+  encoding::string_buffer_t buffer{output, 0};
+  int last_lon = 0, last_lat = 0;
+  binary::read_points(p, end, count, second_order,
+                      [&buffer, &last_lon, &last_lat](const int lon, const int lat) {
+    char* out = encoding::serialize(encoding::subtract(lat, last_lat), buffer.room());
+    buffer.used(encoding::serialize(encoding::subtract(lon, last_lon), out));
+    last_lon = lon;
+    last_lat = lat;
+  });
+  output.resize(buffer.size);
+  return output;
+}
+
+}
+}
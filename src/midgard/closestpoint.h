@@ -0,0 +1,219 @@
+#ifndef VALHALLA_MIDGARD_CLOSESTPOINT_H_
+#define VALHALLA_MIDGARD_CLOSESTPOINT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "simd.h"
+
+// Vectorized closest point of a polyline to a target, shared by
+// PointLL::ClosestPoint and PolylineSoA. The arithmetic is the same as the
+// original one segment at a time loop, operation for operation, so results
+// are identical to it (see -ffp-contract in configure.ac). Only used inside
+// the library, it is not installed.
+
+namespace valhalla {
+namespace midgard {
+namespace simd {
+
+// Best candidate of a closest point search
+struct closest_t {
+  float x, y, d;
+  int index;
+};
+
+// Target of a search. sx and sy scale coordinate deltas to distance units,
+// 1 for planar and a DistanceApproximator centered on the target for PointLL
+struct target_t {
+  float x, y, sx, sy;
+  float distance_squared(const float px, const float py) const {
+    float dx = (px - x) * sx, dy = (py - y) * sy;
+    return dx * dx + dy * dy;
+  }
+};
+
+// Polyline vertices, either separate x and y arrays (stride 1) or
+// interleaved x,y pairs (stride 2)
+struct shape_t {
+  const float* xs;
+  const float* ys;
+  size_t stride;
+  size_t size;
+  float x(const size_t i) const { return xs[i * stride]; }
+  float y(const size_t i) const { return ys[i * stride]; }
+  void load(const size_t i, float_v& x, float_v& y) const {
+    if (stride == 1) {
+      x = float_v::load(xs + i);
+      y = float_v::load(ys + i);
+    } else {
+      load_interleaved(xs + i * 2, x, y);
+    }
+  }
+};
+
+// Whether the target is beyond the end of the last segment that has a
+// length, in which case the last vertex has to be tested as well
+inline bool beyond_end(const shape_t& shape, const target_t& t) {
+  for (size_t i = shape.size - 1; i > 0; --i) {
+    float v1x = shape.x(i) - shape.x(i - 1), v1y = shape.y(i) - shape.y(i - 1);
+    if (v1x == 0.0f && v1y == 0.0f)
+      continue;
+    float dot = v1x * (t.x - shape.x(i - 1)) + v1y * (t.y - shape.y(i - 1));
+    return dot > 0.0f && dot / (v1x * v1x + v1y * v1y) >= 1.0f;
+  }
+  return true;
+}
+
+// Candidate of segment i, one segment at a time. Replaces closest if it is
+// closer. Zero length segments and targets beyond the segment end give no
+// candidate
+inline void closest_segment(const shape_t& shape, const size_t i, const target_t& t,
+                            closest_t& closest) {
+  float x0 = shape.x(i), y0 = shape.y(i);
+  float v1x = shape.x(i + 1) - x0, v1y = shape.y(i + 1) - y0;
+  if (v1x == 0.0f && v1y == 0.0f)
+    return;
+  float dot = v1x * (t.x - x0) + v1y * (t.y - y0);
+  if (dot <= 0.0f) {
+    float d = t.distance_squared(x0, y0);
+    if (d < closest.d)
+      closest = closest_t{ x0, y0, d, static_cast<int>(i) };
+    return;
+  }
+  float comp = dot / (v1x * v1x + v1y * v1y);
+  if (comp < 1.0f) {
+    float px = x0 + v1x * comp, py = y0 + v1y * comp;
+    float d = t.distance_squared(px, py);
+    if (d < closest.d)
+      closest = closest_t{ px, py, d, static_cast<int>(i) };
+  }
+}
+
+/**
+ * Closest point of a polyline with at least 2 vertices to a target. The
+ * first vector_segments segments (a multiple of the vector width, all of
+ * whose vertices can be loaded) are done kWidth at a time, the rest one at
+ * a time. Each lane keeps the best candidate of the segments it saw and the
+ * lanes are reduced preferring the lowest segment index on ties, which is
+ * what the sequential loop ends up with.
+ */
+inline closest_t closest_point(const shape_t& shape, const size_t vector_segments,
+                               const target_t& t) {
+  const float_v qx(t.x), qy(t.y), sx(t.sx), sy(t.sy);
+  const float_v none(std::numeric_limits<float>::infinity()), zero(0.f), one(1.f);
+  float_v best(std::numeric_limits<float>::max()), bestx(0.f), besty(0.f);
+  int_v besti(0), index = int_v::iota();
+  for (size_t i = 0; i < vector_segments; i += kWidth, index = index + int_v(kWidth)) {
+    float_v x0, y0, x1, y1;
+    shape.load(i, x0, y0);
+    shape.load(i + 1, x1, y1);
+    float_v v1x = x1 - x0, v1y = y1 - y0;
+    float_v dot = v1x * (qx - x0) + v1y * (qy - y0);
+    float_v comp = dot / (v1x * v1x + v1y * v1y);
+
+    // The segment origin if the target is before it, otherwise the projection
+    mask_v before = dot <= zero;
+    float_v px = select(before, x0, x0 + v1x * comp);
+    float_v py = select(before, y0, y0 + v1y * comp);
+    float_v dx = (px - qx) * sx, dy = (py - qy) * sy;
+    float_v d = dx * dx + dy * dy;
+
+    // Zero length segments and targets beyond the segment end give no candidate
+    d = select((v1x == zero) & (v1y == zero), none, select(before | (comp < one), d, none));
+    mask_v better = d < best;
+    best = select(better, d, best);
+    bestx = select(better, px, bestx);
+    besty = select(better, py, besty);
+    besti = select(better, index, besti);
+  }
+
+  // Reduce the lanes
+  float lane_d[kWidth], lane_x[kWidth], lane_y[kWidth];
+  int32_t lane_i[kWidth];
+  best.store(lane_d);
+  bestx.store(lane_x);
+  besty.store(lane_y);
+  besti.store(lane_i);
+  closest_t closest{ 0.f, 0.f, std::numeric_limits<float>::max(), -1 };
+  for (size_t l = 0; l < kWidth; ++l) {
+    if (lane_d[l] < closest.d ||
+        (lane_d[l] == closest.d && closest.index != -1 && lane_i[l] < closest.index))
+      closest = closest_t{ lane_x[l], lane_y[l], lane_d[l], lane_i[l] };
+  }
+
+  // Remaining segments one at a time
+  for (size_t i = vector_segments; i + 1 < shape.size; ++i)
+    closest_segment(shape, i, t, closest);
+
+  // Test the end point if the target is beyond the end
+  if (beyond_end(shape, t)) {
+    size_t last = shape.size - 1;
+    float d = t.distance_squared(shape.x(last), shape.y(last));
+    if (d < closest.d)
+      closest = closest_t{ shape.x(last), shape.y(last), d, static_cast<int>(last - 1) };
+  }
+  return closest;
+}
+
+/**
+ * Closest points of a polyline with at least 2 vertices to kWidth targets
+ * at once, one target per lane. Each lane walks the segments in order just
+ * like the sequential loop does for a single target.
+ */
+inline void closest_points(const shape_t& shape, const float_v& qx, const float_v& qy,
+                           const float_v& sx, const float_v& sy, closest_t* closest) {
+  const float_v zero(0.f), one(1.f);
+  float_v best(std::numeric_limits<float>::max()), bestx(0.f), besty(0.f);
+  int_v besti(-1);
+  mask_v beyond = zero == zero;
+  for (size_t i = 0; i + 1 < shape.size; ++i) {
+    // Zero length segments are skipped for every target
+    float x0 = shape.x(i), y0 = shape.y(i);
+    float v1x = shape.x(i + 1) - x0, v1y = shape.y(i + 1) - y0;
+    if (v1x == 0.0f && v1y == 0.0f)
+      continue;
+    const float_v vx0(x0), vy0(y0), vv1x(v1x), vv1y(v1y);
+    float_v dot = vv1x * (qx - vx0) + vv1y * (qy - vy0);
+    float_v comp = dot / float_v(v1x * v1x + v1y * v1y);
+    mask_v before = dot <= zero;
+    mask_v inside = comp < one;
+    beyond = (dot > zero) & (comp >= one);
+
+    float_v px = select(before, vx0, vx0 + vv1x * comp);
+    float_v py = select(before, vy0, vy0 + vv1y * comp);
+    float_v dx = (px - qx) * sx, dy = (py - qy) * sy;
+    float_v d = dx * dx + dy * dy;
+    mask_v better = (before | inside) & (d < best);
+    best = select(better, d, best);
+    bestx = select(better, px, bestx);
+    besty = select(better, py, besty);
+    besti = select(better, int_v(static_cast<int32_t>(i)), besti);
+  }
+
+  // Test the end point for targets beyond the end
+  size_t last = shape.size - 1;
+  const float_v lx(shape.x(last)), ly(shape.y(last));
+  float_v dx = (lx - qx) * sx, dy = (ly - qy) * sy;
+  float_v d = dx * dx + dy * dy;
+  mask_v better = beyond & (d < best);
+  best = select(better, d, best);
+  bestx = select(better, lx, bestx);
+  besty = select(better, ly, besty);
+  besti = select(better, int_v(static_cast<int32_t>(last - 1)), besti);
+
+  float lane_d[kWidth], lane_x[kWidth], lane_y[kWidth];
+  int32_t lane_i[kWidth];
+  best.store(lane_d);
+  bestx.store(lane_x);
+  besty.store(lane_y);
+  besti.store(lane_i);
+  for (size_t l = 0; l < kWidth; ++l)
+    closest[l] = closest_t{ lane_x[l], lane_y[l], lane_d[l], lane_i[l] };
+}
+
+}
+}
+}
+
+#endif  // VALHALLA_MIDGARD_CLOSESTPOINT_H_
@@ -1,5 +1,6 @@
 #include "valhalla/midgard/distanceapproximator.h"
 #include "valhalla/midgard/constants.h"
+#include "simd.h"
 
 namespace valhalla {
 namespace midgard {
@@ -24,6 +25,23 @@ float DistanceApproximator::DistanceSquared(const PointLL& ll) const {
   return (latm * latm + lngm * lngm);
 }
 
+// Distance squared (meters) from the test point to each of a list of points
+void DistanceApproximator::DistanceSquared(const std::vector<PointLL>& pts,
+                                           std::vector<float>& d2) const {
+  d2.resize(pts.size());
+  const simd::float_v lat(centerlat_), lng(centerlng_);
+  const simd::float_v mlat(kMetersPerDegreeLat), mlng(m_per_lng_degree_);
+  size_t i = 0;
+  for (; i + simd::kWidth <= pts.size(); i += simd::kWidth) {
+    simd::float_v x, y;
+    simd::load_interleaved(&pts[i].first, x, y);
+    simd::float_v latm = (y - lat) * mlat, lngm = (x - lng) * mlng;
+    (latm * latm + lngm * lngm).store(&d2[i]);
+  }
+  for (; i < pts.size(); ++i)
+    d2[i] = DistanceSquared(pts[i]);
+}
+
 // Distance squared (meters) between 2 lat,lngs
 float DistanceApproximator::DistanceSquared(const PointLL& ll1,
                                             const PointLL& ll2) {
@@ -35,7 +53,7 @@ float DistanceApproximator::DistanceSquared(const PointLL& ll1,
 
 // Approximate meters per degree of longitude at the specified latitude
 float DistanceApproximator::MetersPerLngDegree(const float lat) {
-  return cosf(lat * kRadPerDeg) * kMetersPerDegreeLat;
+  return simd::cos_lat(lat) * kMetersPerDegreeLat;
 }
 
 }
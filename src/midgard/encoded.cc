@@ -0,0 +1,106 @@
+#include "midgard/encoded.h"
+
+namespace valhalla {
+namespace midgard {
+
+//count the numbers by their last chunk, the only one without the 0x20 bit.
+//a number of more than kMaxNumberBytes chunks is a run of that many bytes
+//with it, and one of exactly that many can't have more than the 2 bits left
+//of 32 in its last chunk. the checks are accumulated rather than branched on
+//so the loop stays tight
+size_t decoded_size(const std::string& encoded) {
+  return decoded_size(encoded.data(), encoded.size());
+}
+size_t decoded_size(const char* encoded, const size_t length) {
+  size_t numbers = 0;
+  bool invalid = false, too_long = false;
+  //how many of the bytes before c are not the last of their number
+  size_t run = 0;
+  const char* c = encoded;
+#if defined(__SSE2__)
+  //16 bytes at a time, bytes past 127 are negative so below 63 as well
+  const __m128i low = _mm_set1_epi8(63), high = _mm_set1_epi8(63 + 63), last = _mm_set1_epi8(63 + 0x20);
+  const __m128i wide = _mm_set1_epi8(63 + 3);
+  __m128i outside = _mm_setzero_si128();
+  //a bit per byte that isn't the last of its number, the previous 16 bytes
+  //in the low half so runs across them are found too
+  uint32_t more = 0;
+  uint32_t runs = 0;
+  for (; encoded + length - c >= 16; c += 16) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c));
+    outside = _mm_or_si128(outside, _mm_or_si128(_mm_cmplt_epi8(bytes, low), _mm_cmpgt_epi8(bytes, high)));
+    uint32_t ends = _mm_movemask_epi8(_mm_cmplt_epi8(bytes, last));
+    uint32_t over = _mm_movemask_epi8(_mm_cmpgt_epi8(bytes, wide));
+    numbers += __builtin_popcount(ends);
+    more = (more >> 16) | ((~ends & 0xffff) << 16);
+    //bits starting runs of at least 2, then 4, then 7 of them, and last
+    //chunks over 3 after a run of 6
+    uint32_t r = more & (more >> 1);
+    r &= r >> 2;
+    runs |= r & (r >> 3);
+    runs |= ((r & (r >> 2)) << 6) & ~more & (over << 16);
+  }
+  invalid = _mm_movemask_epi8(outside) != 0;
+  too_long = runs != 0;
+  //the bytes at the end of the last 16 that aren't the last of their number
+  run = ~more != 0 ? __builtin_clz(~more) : 32;
+#endif
+  for (; c != encoded + length; ++c) {
+    int byte = static_cast<int>(*c) - 63;
+    invalid |= byte < 0 || byte > 63;
+    numbers += byte < 0x20;
+    too_long |= run == encoding::kMaxNumberBytes - 1 && byte > 3;
+    run = byte < 0x20 ? 0 : run + 1;
+    too_long |= run > encoding::kMaxNumberBytes - 1;
+  }
+  if (invalid)
+    throw std::runtime_error("Encoded polyline has characters outside of its alphabet");
+  if (too_long)
+    throw std::runtime_error("Encoded polyline has a number that is too long");
+  if (numbers % 2 != 0 || (length > 0 && encoded[length - 1] - 63 >= 0x20))
+    throw std::runtime_error("Encoded polyline is truncated");
+  return numbers / 2;
+}
+
+//decode into a vector, reusing its memory
+void decode(const std::string& encoded, std::vector<PointLL>& points, const int precision) {
+  const double inverse = 1.0 / encoding::scale(precision);
+  points.resize(decoded_size(encoded));
+  PointLL* p = points.data();
+  encoding::decode_points(encoded.data(), encoded.data() + encoded.size(),
+                          [&p, inverse](const int lon, const int lat) {
+    *p++ = PointLL(encoding::unscale<float>(lon, inverse), encoding::unscale<float>(lat, inverse));
+  });
+}
+
+//decode into a buffer of points
+size_t decode(const std::string& encoded, PointLL* points, const size_t capacity,
+              const int precision) {
+  const double inverse = 1.0 / encoding::scale(precision);
+  size_t count = decoded_size(encoded);
+  if (count > capacity)
+    throw std::runtime_error("Encoded polyline has more points than the buffer holds");
+  encoding::decode_points(encoded.data(), encoded.data() + encoded.size(),
+                          [&points, inverse](const int lon, const int lat) {
+    *points++ = PointLL(encoding::unscale<float>(lon, inverse), encoding::unscale<float>(lat, inverse));
+  });
+  return count;
+}
+
+//decode into separate longitude and latitude buffers
+size_t decode(const std::string& encoded, float* lngs, float* lats, const size_t capacity,
+              const int precision) {
+  const double inverse = 1.0 / encoding::scale(precision);
+  size_t count = decoded_size(encoded);
+  if (count > capacity)
+    throw std::runtime_error("Encoded polyline has more points than the buffers hold");
+  encoding::decode_points(encoded.data(), encoded.data() + encoded.size(),
+                          [&lngs, &lats, inverse](const int lon, const int lat) {
+    *lngs++ = encoding::unscale<float>(lon, inverse);
+    *lats++ = encoding::unscale<float>(lat, inverse);
+  });
+  return count;
+}
+
+}
+}
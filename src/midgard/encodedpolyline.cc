@@ -0,0 +1,97 @@
+#include "midgard/encodedpolyline.h"
+#include "midgard/encoded.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace valhalla {
+namespace midgard {
+
+// Constructor given an encoded string.
+EncodedPolyline::EncodedPolyline(const std::string& encoded, const int precision)
+  : EncodedPolyline(encoded.data(), encoded.size(), precision) {
+}
+
+// Constructor given encoded bytes. Validates and counts the points.
+EncodedPolyline::EncodedPolyline(const char* encoded, const size_t length, const int precision)
+  : begin_(encoded), end_(encoded + length), size_(decoded_size(encoded, length)),
+    inverse_(1.0 / encoding::scale(precision)) {
+}
+
+// Get an iterator to the first point.
+EncodedPolyline::const_iterator EncodedPolyline::begin() const {
+  return const_iterator(begin_, end_, inverse_);
+}
+
+// Get an iterator past the last point.
+EncodedPolyline::const_iterator EncodedPolyline::end() const {
+  return const_iterator(end_, end_, inverse_);
+}
+
+// Get the number of points.
+size_t EncodedPolyline::size() const {
+  return size_;
+}
+
+// Whether there are no points.
+bool EncodedPolyline::empty() const {
+  return size_ == 0;
+}
+
+// Get the first point.
+PointLL EncodedPolyline::front() const {
+  return *begin();
+}
+
+// Get the last point, summing the offsets of all the points.
+PointLL EncodedPolyline::back() const {
+  auto p = begin(), last = p;
+  for (auto e = end(); p != e; ++p)
+    last = p;
+  return *last;
+}
+
+// Get the point at an index.
+PointLL EncodedPolyline::at(const size_t i) const {
+  if (i >= size_)
+    throw std::out_of_range("Encoded polyline has no point at this index");
+  auto p = begin();
+  for (size_t j = 0; j < i; ++j)
+    ++p;
+  return *p;
+}
+
+// Get the bounding box, on the integers of the encoding.
+AABB2<PointLL> EncodedPolyline::BoundingBox() const {
+  if (size_ == 0)
+    return AABB2<PointLL>();
+  auto p = begin();
+  int32_t minx = p.lng_scaled(), miny = p.lat_scaled(), maxx = minx, maxy = miny;
+  for (auto e = end(); p != e; ++p) {
+    minx = std::min(minx, p.lng_scaled());
+    miny = std::min(miny, p.lat_scaled());
+    maxx = std::max(maxx, p.lng_scaled());
+    maxy = std::max(maxy, p.lat_scaled());
+  }
+  // The conversion is monotonic so the box holds the decoded points
+  return AABB2<PointLL>(encoding::unscale<float>(minx, inverse_), encoding::unscale<float>(miny, inverse_),
+                        encoding::unscale<float>(maxx, inverse_), encoding::unscale<float>(maxy, inverse_));
+}
+
+// Get the length of the polyline, as length() of the decoded points.
+float EncodedPolyline::Length() const {
+  float length = 0.0f;
+  if (size_ == 0)
+    return length;
+  auto p = begin();
+  PointLL previous = *p;
+  for (auto e = end(); ++p != e; ) {
+    PointLL current = *p;
+    length += current.Distance(previous);
+    previous = current;
+  }
+  return length;
+}
+
+}
+}
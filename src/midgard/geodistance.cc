@@ -0,0 +1,185 @@
+#include "midgard/geodistance.h"
+#include "midgard/constants.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace {
+
+// WGS84 ellipsoid
+constexpr double kSemiMajorAxis = 6378137.0;
+constexpr double kFlattening = 1.0 / 298.257223563;
+constexpr double kSemiMinorAxis = kSemiMajorAxis * (1.0 - kFlattening);
+constexpr double kEccentricitySquared = kFlattening * (2.0 - kFlattening);
+
+constexpr double kRadPerDegree = M_PI / 180.0;
+
+// Relative error of the spherical tier and the rounding error of the planar
+// tier, see the envelopes in geodistance.h
+constexpr double kSphericalError = 7e-3;
+constexpr double kPlanarRoundingError = 1e-6;
+
+// Accuracy of the ellipsoidal tier in meters
+constexpr double kEllipsoidalError = 1e-3;
+
+// Vincenty iterates until the longitude on the auxiliary sphere settles,
+// relative to its size so short distances are as precise as long ones
+constexpr double kVincentyConvergence = 1e-12;
+constexpr int kVincentyIterations = 200;
+
+// Longitude delta in radians taking the short way around
+double delta_lng(const valhalla::midgard::PointLL& a, const valhalla::midgard::PointLL& b) {
+  double d = static_cast<double>(b.lng()) - a.lng();
+  if (d > 180.0)
+    d -= 360.0;
+  else if (d < -180.0)
+    d += 360.0;
+  return d * kRadPerDegree;
+}
+
+// Bound on the error in meters of a distance whose error is at most relative
+// times the true distance
+double bound(const double relative, const double distance) {
+  return relative < 1.0 ? relative * distance / (1.0 - relative)
+                        : std::numeric_limits<double>::infinity();
+}
+
+}
+
+namespace valhalla {
+namespace midgard {
+
+// Planar distance with the ellipsoid's radii of curvature at the mid latitude.
+double GeoDistance::Planar(const PointLL& a, const PointLL& b) {
+  double lat = (static_cast<double>(a.lat()) + b.lat()) * 0.5 * kRadPerDegree;
+  double s = sin(lat);
+  double w = 1.0 - kEccentricitySquared * s * s;
+  double n = kSemiMajorAxis / sqrt(w);
+  double m = n * (1.0 - kEccentricitySquared) / w;
+  double north = (static_cast<double>(b.lat()) - a.lat()) * kRadPerDegree * m;
+  double east = delta_lng(a, b) * n * cos(lat);
+  return sqrt(north * north + east * east);
+}
+
+// Great circle distance with the haversine formula.
+double GeoDistance::Spherical(const PointLL& a, const PointLL& b) {
+  double lat1 = a.lat() * kRadPerDegree, lat2 = b.lat() * kRadPerDegree;
+  double slat = sin((lat2 - lat1) * 0.5), slng = sin(delta_lng(a, b) * 0.5);
+  double h = slat * slat + cos(lat1) * cos(lat2) * slng * slng;
+  return 2.0 * asin(sqrt(std::min(h, 1.0))) * kRadEarthMeters;
+}
+
+// Geodesic distance on the ellipsoid with Vincenty's inverse formula.
+bool GeoDistance::Vincenty(const PointLL& a, const PointLL& b, double& distance) {
+  // Reduced latitudes
+  double l = delta_lng(a, b);
+  double u1 = atan((1.0 - kFlattening) * tan(a.lat() * kRadPerDegree));
+  double u2 = atan((1.0 - kFlattening) * tan(b.lat() * kRadPerDegree));
+  double sinu1 = sin(u1), cosu1 = cos(u1), sinu2 = sin(u2), cosu2 = cos(u2);
+
+  // Iterate the longitude on the auxiliary sphere
+  double lambda = l, sigma = 0.0, sinsigma = 0.0, cossigma = 1.0;
+  double cos2alpha = 1.0, cos2sigmam = 0.0;
+  int i = 0;
+  for (; i < kVincentyIterations; ++i) {
+    double sinlambda = sin(lambda), coslambda = cos(lambda);
+    double x = cosu2 * sinlambda, y = cosu1 * sinu2 - sinu1 * cosu2 * coslambda;
+    sinsigma = sqrt(x * x + y * y);
+    if (sinsigma == 0.0) {
+      distance = 0.0;
+      return true;
+    }
+    cossigma = sinu1 * sinu2 + cosu1 * cosu2 * coslambda;
+    sigma = atan2(sinsigma, cossigma);
+    double sinalpha = cosu1 * cosu2 * sinlambda / sinsigma;
+    cos2alpha = 1.0 - sinalpha * sinalpha;
+    // On the equator cos2alpha is 0 and so is the term it scales
+    cos2sigmam = cos2alpha != 0.0 ? cossigma - 2.0 * sinu1 * sinu2 / cos2alpha : 0.0;
+    double c = kFlattening / 16.0 * cos2alpha * (4.0 + kFlattening * (4.0 - 3.0 * cos2alpha));
+    double previous = lambda;
+    lambda = l + (1.0 - c) * kFlattening * sinalpha *
+                 (sigma + c * sinsigma *
+                  (cos2sigmam + c * cossigma * (-1.0 + 2.0 * cos2sigmam * cos2sigmam)));
+    if (std::abs(lambda - previous) <= kVincentyConvergence * std::abs(lambda))
+      break;
+  }
+
+  // Nearly antipodal points do not converge
+  if (i == kVincentyIterations || std::abs(lambda) > M_PI)
+    return false;
+
+  double u2sq = cos2alpha * (kSemiMajorAxis * kSemiMajorAxis - kSemiMinorAxis * kSemiMinorAxis) /
+                (kSemiMinorAxis * kSemiMinorAxis);
+  double ca = 1.0 + u2sq / 16384.0 * (4096.0 + u2sq * (-768.0 + u2sq * (320.0 - 175.0 * u2sq)));
+  double cb = u2sq / 1024.0 * (256.0 + u2sq * (-128.0 + u2sq * (74.0 - 47.0 * u2sq)));
+  double deltasigma = cb * sinsigma *
+      (cos2sigmam + cb / 4.0 *
+       (cossigma * (-1.0 + 2.0 * cos2sigmam * cos2sigmam) -
+        cb / 6.0 * cos2sigmam * (-3.0 + 4.0 * sinsigma * sinsigma) *
+        (-3.0 + 4.0 * cos2sigmam * cos2sigmam)));
+  distance = kSemiMinorAxis * ca * (sigma - deltasigma);
+  return true;
+}
+
+// Geodesic distance on the ellipsoid, the sphere where Vincenty fails.
+double GeoDistance::Ellipsoidal(const PointLL& a, const PointLL& b) {
+  double distance;
+  return Vincenty(a, b, distance) ? distance : Spherical(a, b);
+}
+
+// Distance computed in the given tier.
+double GeoDistance::Distance(const PointLL& a, const PointLL& b, const DistanceTier tier) {
+  switch (tier) {
+    case DistanceTier::kPlanar:
+      return Planar(a, b);
+    case DistanceTier::kSpherical:
+      return Spherical(a, b);
+    default:
+      return Ellipsoidal(a, b);
+  }
+}
+
+// Distance computed in the cheapest tier that is within the tolerance.
+double GeoDistance::Distance(const PointLL& a, const PointLL& b, const double tolerance,
+                             DistanceTier* tier) {
+  DistanceTier used = DistanceTier::kPlanar;
+  double distance = Planar(a, b);
+  if (MaxError(a, b, used, distance) > tolerance) {
+    used = DistanceTier::kSpherical;
+    distance = Spherical(a, b);
+    // Where Vincenty fails the spherical distance is as good as it gets
+    if (MaxError(a, b, used, distance) > tolerance && Vincenty(a, b, distance))
+      used = DistanceTier::kEllipsoidal;
+  }
+  if (tier != nullptr)
+    *tier = used;
+  return distance;
+}
+
+// Bound on the error of a distance computed in a tier.
+double GeoDistance::MaxError(const PointLL& a, const PointLL& b, const DistanceTier tier,
+                             const double distance) {
+  switch (tier) {
+    case DistanceTier::kPlanar:
+      return bound(PlanarRelativeError(a, b), distance);
+    case DistanceTier::kSpherical:
+      return bound(kSphericalError, distance);
+    default: {
+      // Nearly antipodal points got the spherical distance
+      double ellipsoidal;
+      return Vincenty(a, b, ellipsoidal) ? kEllipsoidalError : bound(kSphericalError, distance);
+    }
+  }
+}
+
+// Error of the planar tier relative to the distance. Flattening the earth
+// costs terms in the square of the span, see the envelopes in geodistance.h.
+double GeoDistance::PlanarRelativeError(const PointLL& a, const PointLL& b) {
+  double dlat = (static_cast<double>(b.lat()) - a.lat()) * kRadPerDegree;
+  double dlng = delta_lng(a, b);
+  return kPlanarRoundingError + (dlat * dlat + dlng * dlng) / 6.0;
+}
+
+}
+}
@@ -0,0 +1,162 @@
+#include "midgard/linearreference.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace valhalla {
+namespace midgard {
+
+// Constructor given a list of points. Computes the measure of each vertex.
+LinearReference::LinearReference(const std::vector<PointLL>& pts)
+    : pts_(pts) {
+  measures_.reserve(pts_.size());
+  double d = 0.0;
+  for (size_t i = 0; i < pts_.size(); ++i) {
+    if (i > 0)
+      d += pts_[i - 1].Distance(pts_[i]);
+    measures_.push_back(d);
+  }
+}
+
+// Get the list of points.
+const std::vector<PointLL>& LinearReference::pts() const {
+  return pts_;
+}
+
+// Get the measure of every vertex.
+const std::vector<double>& LinearReference::measures() const {
+  return measures_;
+}
+
+// Get the length of the polyline.
+float LinearReference::Length() const {
+  return measures_.empty() ? 0.0f : measures_.back();
+}
+
+// Find the segment the measure falls on.
+int LinearReference::Segment(const float m) const {
+  int n = static_cast<int>(pts_.size());
+  if (n < 2)
+    return -1;
+
+  // First vertex past the measure ends the segment
+  int i = std::upper_bound(measures_.begin(), measures_.end(), static_cast<double>(m)) -
+          measures_.begin() - 1;
+  if (i >= 0 && i < n - 1)
+    return i;
+
+  // Before the start or at the end, skip any zero length segments there
+  if (i < 0) {
+    i = 0;
+    while (i < n - 2 && measures_[i + 1] == measures_[i])
+      ++i;
+  } else {
+    i = n - 2;
+    while (i > 0 && measures_[i + 1] == measures_[i])
+      --i;
+  }
+  return i;
+}
+
+// Get the point at a measure.
+PointLL LinearReference::PointAt(const float m) const {
+  if (pts_.empty())
+    return PointLL();
+  if (m <= 0.0f)
+    return pts_.front();
+  if (m >= measures_.back())
+    return pts_.back();
+  return Interpolate(Segment(m), m);
+}
+
+// Get the heading of the segment the measure falls on.
+float LinearReference::HeadingAt(const float m) const {
+  int i = Segment(m);
+  return i < 0 ? 0.0f : pts_[i].Heading(pts_[i + 1]);
+}
+
+// Heading from the start to the point at a distance along the polyline.
+float LinearReference::HeadingAlong(const float dist) const {
+  int n = static_cast<int>(pts_.size());
+  if (n < 2)
+    return 0.0f;
+  if (n == 2)
+    return pts_[0].Heading(pts_[1]);
+
+  // Like the polyline walk, a distance that is not strictly inside the
+  // polyline gives the heading from the first to the last point
+  if (dist <= 0.0f || dist >= measures_.back())
+    return pts_[0].Heading(pts_[n - 1]);
+  int i = Segment(dist);
+  if (measures_[i] == dist)
+    return pts_[0].Heading(pts_[n - 1]);
+  return pts_[0].Heading(Interpolate(i, dist));
+}
+
+// Heading from the point at a distance from the end to the end point.
+float LinearReference::HeadingAtEnd(const float dist) const {
+  int n = static_cast<int>(pts_.size());
+  if (n < 2)
+    return 0.0f;
+  if (n == 2)
+    return pts_[0].Heading(pts_[1]);
+
+  double length = measures_.back();
+  if (dist <= 0.0f || dist >= length)
+    return pts_[0].Heading(pts_[n - 1]);
+
+  // Walk back from the end vertex of the segment like the polyline walk
+  double m = length - dist;
+  int i = Segment(m);
+  if (measures_[i] == m)
+    return pts_[0].Heading(pts_[n - 1]);
+  double seglength = measures_[i + 1] - measures_[i];
+  float pct = (float) ((measures_[i + 1] - m) / seglength);
+  PointLL ll(pts_[i + 1].lng() + ((pts_[i].lng() - pts_[i + 1].lng()) * pct),
+             pts_[i + 1].lat() + ((pts_[i].lat() - pts_[i + 1].lat()) * pct));
+  return ll.Heading(pts_[n - 1]);
+}
+
+// Get the part of the polyline between two measures.
+std::vector<PointLL> LinearReference::Substring(const float from, const float to) const {
+  std::vector<PointLL> part;
+  if (pts_.empty() || from > to)
+    return part;
+
+  // The start point, then the vertices strictly between the two measures,
+  // then the end point
+  part.push_back(PointAt(from));
+  auto first = std::upper_bound(measures_.begin(), measures_.end(), static_cast<double>(from));
+  auto last = std::lower_bound(first, measures_.end(), static_cast<double>(to));
+  for (auto m = first; m != last; ++m) {
+    const PointLL& p = pts_[m - measures_.begin()];
+    if (!(p == part.back()))
+      part.push_back(p);
+  }
+  PointLL end = PointAt(to);
+  if (!(end == part.back()) || part.size() == 1)
+    part.push_back(end);
+  return part;
+}
+
+// Project a point onto the polyline.
+float LinearReference::Project(const PointLL& pt) const {
+  if (pts_.size() < 2)
+    return 0.0f;
+  PointLL closest;
+  float d;
+  int i;
+  std::tie(closest, d, i) = pt.ClosestPoint(pts_);
+  return std::min(measures_[i] + pts_[i].Distance(closest), measures_.back());
+}
+
+// Interpolate along segment i at a measure on it.
+PointLL LinearReference::Interpolate(const int i, const double m) const {
+  double seglength = measures_[i + 1] - measures_[i];
+  float pct = (float) ((m - measures_[i]) / seglength);
+  return PointLL(pts_[i].lng() + ((pts_[i + 1].lng() - pts_[i].lng()) * pct),
+                 pts_[i].lat() + ((pts_[i + 1].lat() - pts_[i].lat()) * pct));
+}
+
+}
+}
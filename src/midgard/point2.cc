@@ -14,9 +14,6 @@ constexpr float EPSILON = .00002f;
 namespace valhalla {
 namespace midgard {
 
-Point2::~Point2() {
-}
-
 float Point2::x() const {
   return first;
 }
@@ -181,7 +178,5 @@ bool Point2::WithinConvexPolygon(const std::vector<Point2>& poly) const {
   return true;
 }
 
-bool Point2::IsSpherical() { return false; }
-
 }
 }
@@ -2,13 +2,31 @@
 #include <valhalla/midgard/util.h>
 #include "valhalla/midgard/distanceapproximator.h"
 #include "valhalla/midgard/vector2.h"
+#include "valhalla/midgard/constants.h"
+#include "closestpoint.h"
 
 #include <limits>
 #include <cmath>
+#include <algorithm>
 
 namespace {
 const float INVALID = 0xBADBADBAD;
 
+using namespace valhalla::midgard;
+
+static_assert(sizeof(PointLL) == 2 * sizeof(float), "Polylines are loaded as interleaved floats");
+
+// View a list of points as interleaved lng,lat floats
+simd::shape_t shape(const std::vector<PointLL>& pts) {
+  return simd::shape_t{ &pts.front().first, &pts.front().second, 2, pts.size() };
+}
+
+// Target using the distances of a DistanceApproximator centered on ll
+simd::target_t target(const PointLL& ll) {
+  return simd::target_t{ ll.lng(), ll.lat(), DistanceApproximator::MetersPerLngDegree(ll.lat()),
+                         kMetersPerDegreeLat };
+}
+
 constexpr double RAD_PER_DEG = M_PI / 180.0;
 constexpr double DEG_PER_RAD = 180.0 / M_PI;
 }
@@ -135,7 +153,7 @@ float PointLL::Heading(const PointLL& ll2) const {
 
 // Finds the closest point to the supplied polyline as well as the distance
 // squared to that point and the index of the segment where the closest point
-// lies.
+// lies. Segments are projected onto several at a time, see closestpoint.h.
 std::tuple<PointLL, float, int> PointLL::ClosestPoint(const std::vector<PointLL>& pts) const {
   PointLL closest;
   int idx;
@@ -148,79 +166,83 @@ std::tuple<PointLL, float, int> PointLL::ClosestPoint(const std::vector<PointLL>
   if(pts.size() == 1)
     return std::make_tuple(pts.front(), DistanceSquared(pts.front()), 0);
 
-  DistanceApproximator approx(*this);
+  // Distances are those of a DistanceApproximator centered on this point.
+  // Vector blocks need to be able to load the vertex after their last segment
+  auto result = simd::closest_point(shape(pts), (pts.size() - 1) / simd::kWidth * simd::kWidth,
+                                    target(*this));
+  return std::make_tuple(PointLL(result.x, result.y), result.d, result.index);
+}
 
-  // Iterate through the pts
-  bool beyond_end = true;   // Need to test past the end point?
-  Vector2 v1;       // Segment vector (v1)
-  Vector2 v2;       // Vector from origin to target (v2)
-  PointLL projpt;   // Projected point along v1
-  float dot;        // Dot product of v1 and v2
-  float comp;       // Component of v2 along v1
-  float dist;       // Squared distance from target to closest point on line
-  for (size_t index = 0; index < pts.size() - 1; ++index) {
-    // Get the current segment
-    const PointLL& p0 = pts[index];
-    const PointLL& p1 = pts[index + 1];
-
-    // Construct vector v1 - represents the segment.  Skip 0 length segments
-    v1.Set(p0, p1);
-    if (v1.x() == 0.0f && v1.y() == 0.0f)
-      continue;
-
-    // Vector v2 from the segment origin to the target point
-    v2.Set(p0, *this);
-
-    // Find the dot product of v1 and v2.  If less than 0 the segment
-    // origin is the closest point.  Find the distance and continue
-    // to the next segment.
-    dot = v1.Dot(v2);
-    if (dot <= 0.0f) {
-      beyond_end = false;
-      dist = approx.DistanceSquared(p0);
-      if (dist < mindist) {
-        mindist = dist;
-        closest = p0;
-        idx = index;
-      }
-      continue;
+// Finds the closest point on the supplied polyline to each of a list of
+// points. Points are done several at a time, one per vector lane.
+std::vector<std::tuple<PointLL, float, int> > PointLL::ClosestPoints(
+    const std::vector<PointLL>& points, const std::vector<PointLL>& pts) {
+  std::vector<std::tuple<PointLL, float, int> > result;
+  result.reserve(points.size());
+  size_t i = 0;
+  if (pts.size() > 1) {
+    auto polyline = shape(pts);
+    simd::closest_t closest[simd::kWidth];
+    float scale[simd::kWidth];
+    for (; i + simd::kWidth <= points.size(); i += simd::kWidth) {
+      simd::float_v qx, qy;
+      simd::load_interleaved(&points[i].first, qx, qy);
+      for (size_t l = 0; l < simd::kWidth; ++l)
+        scale[l] = DistanceApproximator::MetersPerLngDegree(points[i + l].lat());
+      simd::closest_points(polyline, qx, qy, simd::float_v::load(scale),
+                           simd::float_v(kMetersPerDegreeLat), closest);
+      for (size_t l = 0; l < simd::kWidth; ++l)
+        result.emplace_back(PointLL(closest[l].x, closest[l].y), closest[l].d, closest[l].index);
     }
+  }
+  for (; i < points.size(); ++i)
+    result.emplace_back(points[i].ClosestPoint(pts));
+  return result;
+}
 
-    // Closest point is either beyond the end of the segment or at a point
-    // along the segment. Find the component of v2 along v1
-    comp = dot / v1.Dot(v1);
-
-    // If component >= 1.0 the segment end is the closest point. A future
-    // polyline segment will be closer.  If last segment we need to check
-    // distance to the endpoint.  Set flag so this happens.
-    if (comp >= 1.0f)
-      beyond_end = true;
-    else {
-      // Closest point is along the segment.  The closest point is found
-      // by adding the projection of v2 onto v1 to the origin point.
-      // The squared distance from this point to the target is then found.
-      // TODO - why not:  *p0 + v1 * comp;
-      beyond_end = false;
-      projpt = p0 + v1 * comp;
-      dist = approx.DistanceSquared(projpt);
-      if (dist < mindist) {
-        mindist = dist;
-        closest = projpt;
-        idx = index;
-      }
-    }
+// Calculates the distance between each pair of consecutive points. Pairs
+// are done several at a time, see simd::great_circle.
+std::vector<float> PointLL::Distances(const std::vector<PointLL>& pts) {
+  std::vector<float> distances(pts.size() < 2 ? 0 : pts.size() - 1);
+  size_t i = 0;
+  for (; i + simd::kWidth < pts.size(); i += simd::kWidth) {
+    simd::float_v x0, y0, x1, y1;
+    simd::load_interleaved(&pts[i].first, x0, y0);
+    simd::load_interleaved(&pts[i + 1].first, x1, y1);
+    simd::great_circle(x0, y0, x1, y1).store(&distances[i]);
   }
 
-  // Test the end point if flag is set - it may be the closest point
-  if (beyond_end) {
-    dist = approx.DistanceSquared(pts[pts.size() - 1]);
-    if (dist < mindist) {
-      mindist = dist;
-      closest = pts.back();
-      idx = (int) (pts.size() - 2);
+  // The last few pairs go through the same kernel so every distance is
+  // computed the same way, padding with copies of the last point
+  if (i < distances.size()) {
+    float xy[(simd::kWidth + 1) * 2], d[simd::kWidth];
+    for (size_t k = 0; k <= simd::kWidth; ++k) {
+      const PointLL& p = pts[std::min(i + k, pts.size() - 1)];
+      xy[k * 2] = p.first;
+      xy[k * 2 + 1] = p.second;
     }
+    simd::float_v x0, y0, x1, y1;
+    simd::load_interleaved(xy, x0, y0);
+    simd::load_interleaved(xy + 2, x1, y1);
+    simd::great_circle(x0, y0, x1, y1).store(d);
+    std::copy(d, d + (distances.size() - i), distances.begin() + i);
+  }
+  return distances;
+}
+
+// Calculates the distance along a list of points to each point.
+std::vector<double> PointLL::CumulativeDistances(const std::vector<PointLL>& pts) {
+  std::vector<double> measures;
+  measures.reserve(pts.size());
+  if (pts.empty())
+    return measures;
+  double d = 0.0;
+  measures.push_back(d);
+  for (const auto distance : Distances(pts)) {
+    d += distance;
+    measures.push_back(d);
   }
-  return std::make_tuple(std::move(closest), std::move(mindist), std::move(idx));
+  return measures;
 }
 
 // Calculate the heading from the start of a polyline of lat,lng points to a
@@ -319,7 +341,5 @@ bool PointLL::WithinConvexPolygon(const std::vector<PointLL>& poly) const {
   return true;
 }
 
-bool PointLL::IsSpherical() { return true; }
-
 }
 }
@@ -1,6 +1,94 @@
 #include "valhalla/midgard/polyline2.h"
+#include "valhalla/midgard/distanceapproximator.h"
+#include "valhalla/midgard/constants.h"
 
 #include <vector>
+#include <limits>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+using namespace valhalla::midgard;
+
+namespace {
+
+  //area of the triangle abc, square meters for PointLL using the same
+  //scaling as a DistanceApproximator centered on b
+  template <class coord_t>
+  float triangle_area(const coord_t& a, const coord_t& b, const coord_t& c) {
+    float sx = 1.0f, sy = 1.0f;
+    if (coord_t::IsSpherical()) {
+      sx = DistanceApproximator::MetersPerLngDegree(b.y());
+      sy = kMetersPerDegreeLat;
+    }
+    float abx = (b.x() - a.x()) * sx, aby = (b.y() - a.y()) * sy;
+    float acx = (c.x() - a.x()) * sx, acy = (c.y() - a.y()) * sy;
+    return std::abs(abx * acy - aby * acx) * 0.5f;
+  }
+
+  //binary min-heap of vertices keyed by area that knows where each vertex
+  //is so its area can be changed in place. Ties go to the lower vertex
+  class area_heap {
+   public:
+    area_heap(const std::vector<float>& areas)
+      : areas_(areas), position_(areas.size(), 0) {
+      heap_.reserve(areas.size());
+    }
+    bool empty() const { return heap_.empty(); }
+    uint32_t top() const { return heap_.front(); }
+    void push(const uint32_t v) {
+      position_[v] = heap_.size();
+      heap_.push_back(v);
+      up(heap_.size() - 1);
+    }
+    void pop() {
+      if (heap_.size() > 1) {
+        heap_.front() = heap_.back();
+        position_[heap_.front()] = 0;
+      }
+      heap_.pop_back();
+      if (!heap_.empty())
+        down(0);
+    }
+    //call after the area of v changed
+    void update(const uint32_t v) {
+      up(position_[v]);
+      down(position_[v]);
+    }
+   private:
+    bool less(const uint32_t a, const uint32_t b) const {
+      return areas_[a] < areas_[b] || (areas_[a] == areas_[b] && a < b);
+    }
+    void swap(const uint32_t i, const uint32_t j) {
+      std::swap(heap_[i], heap_[j]);
+      position_[heap_[i]] = i;
+      position_[heap_[j]] = j;
+    }
+    void up(uint32_t i) {
+      while (i > 0 && less(heap_[i], heap_[(i - 1) / 2])) {
+        swap(i, (i - 1) / 2);
+        i = (i - 1) / 2;
+      }
+    }
+    void down(uint32_t i) {
+      while (true) {
+        uint32_t smallest = i, l = 2 * i + 1, r = l + 1;
+        if (l < heap_.size() && less(heap_[l], heap_[smallest]))
+          smallest = l;
+        if (r < heap_.size() && less(heap_[r], heap_[smallest]))
+          smallest = r;
+        if (smallest == i)
+          return;
+        swap(i, smallest);
+        i = smallest;
+      }
+    }
+    const std::vector<float>& areas_;
+    std::vector<uint32_t> heap_;
+    std::vector<uint32_t> position_;
+  };
+
+}
 
 namespace valhalla {
 namespace midgard {
@@ -61,12 +149,9 @@ std::tuple<coord_t, float, int> Polyline2<coord_t>::ClosestPoint(const coord_t&
 // Generalize this polyline.
 template <class coord_t>
 uint32_t Polyline2<coord_t>::Generalize(const float t) {
-  // Create a vector for the output shape. Recursively call Douglass-Peucker
-  // method to generalize the polyline. Square the error tolerance to avoid
-  // sqrts.
-  std::vector<coord_t> genpts;
-  DouglasPeucker(0, pts_.size() - 1, t*t, genpts);
-  pts_= genpts;
+  // Douglass-Peucker generalization in place. Square the error tolerance
+  // to avoid sqrts.
+  DouglasPeucker(t * t);
   return pts_.size();
 }
 
@@ -74,11 +159,100 @@ uint32_t Polyline2<coord_t>::Generalize(const float t) {
 // unchanged.
 template <class coord_t>
 Polyline2<coord_t> Polyline2<coord_t>::GeneralizedPolyline(const float t) {
-  // Recursively call Douglass-Peucker method to generalize the polyline.
-  // Square the error tolerance to avoid sqrts.
-  std::vector<coord_t> genpts;
-  DouglasPeucker(0, pts_.size() - 1, t * t, genpts);
-  return Polyline2(genpts);
+  Polyline2 generalized;
+  generalized.pts_ = pts_;
+  generalized.DouglasPeucker(t * t);
+  return generalized;
+}
+
+// Compute the significance of every vertex with one full Douglass-Peucker
+// pass. A vertex survives a tolerance if its own split distance and that
+// of every split above it exceed the tolerance, so its significance is the
+// smallest of those distances.
+template <class coord_t>
+std::vector<float> Polyline2<coord_t>::Significance() const {
+  std::vector<float> significance(pts_.size(), 0.0f);
+  if (pts_.empty())
+    return significance;
+  const float inf = std::numeric_limits<float>::infinity();
+  significance.front() = significance.back() = inf;
+
+  std::vector<std::tuple<uint32_t, uint32_t, float> > ranges;
+  ranges.emplace_back(0, pts_.size() - 1, inf);
+  while (!ranges.empty()) {
+    uint32_t i, j;
+    float parent;
+    std::tie(i, j, parent) = ranges.back();
+    ranges.pop_back();
+    auto farthest = Farthest(i, j);
+    if (farthest.second > 0.0f) {
+      float s = std::min(farthest.second, parent);
+      significance[farthest.first] = s;
+      ranges.emplace_back(i, farthest.first, s);
+      ranges.emplace_back(farthest.first, j, s);
+    }
+  }
+  return significance;
+}
+
+// Generalize this polyline in place using precomputed significance. Keeps
+// the vertices more significant than the tolerance, skipping repeats like
+// Douglass-Peucker does.
+template <class coord_t>
+uint32_t Polyline2<coord_t>::Generalize(const float t, const std::vector<float>& significance) {
+  if (significance.size() != pts_.size())
+    throw std::runtime_error("Significance does not match the polyline");
+  const float t2 = t * t;
+  uint32_t n = 0;
+  for (uint32_t k = 0; k < pts_.size(); ++k) {
+    if (significance[k] > t2 && (n == 0 || !(pts_[k] == pts_[n - 1])))
+      pts_[n++] = pts_[k];
+  }
+  pts_.resize(n);
+  return n;
+}
+
+// Get a generalized polyline from this polyline using precomputed
+// significance. This polyline remains unchanged.
+template <class coord_t>
+Polyline2<coord_t> Polyline2<coord_t>::GeneralizedPolyline(
+    const float t, const std::vector<float>& significance) const {
+  if (significance.size() != pts_.size())
+    throw std::runtime_error("Significance does not match the polyline");
+  const float t2 = t * t;
+  Polyline2 generalized;
+  for (uint32_t k = 0; k < pts_.size(); ++k) {
+    if (significance[k] > t2)
+      generalized.Add(pts_[k]);
+  }
+  return generalized;
+}
+
+// Compute the effective area of every vertex by removing all of them.
+template <class coord_t>
+std::vector<float> Polyline2<coord_t>::EffectiveAreas() const {
+  std::vector<float> areas;
+  std::vector<bool> removed;
+  VisvalingamWhyatt(std::numeric_limits<float>::infinity(), 2, areas, removed);
+  return areas;
+}
+
+// Generalize this polyline with Visvalingam-Whyatt to an area tolerance.
+template <class coord_t>
+uint32_t Polyline2<coord_t>::GeneralizeByArea(const float area) {
+  std::vector<float> areas;
+  std::vector<bool> removed;
+  VisvalingamWhyatt(area, 2, areas, removed);
+  return Remove(removed);
+}
+
+// Generalize this polyline with Visvalingam-Whyatt to a vertex count.
+template <class coord_t>
+uint32_t Polyline2<coord_t>::GeneralizeToCount(const uint32_t count) {
+  std::vector<float> areas;
+  std::vector<bool> removed;
+  VisvalingamWhyatt(std::numeric_limits<float>::infinity(), std::max(count, 2u), areas, removed);
+  return Remove(removed);
 }
 
 // Clip this polyline to the specified bounding box.
@@ -99,12 +273,45 @@ Polyline2<coord_t> Polyline2<coord_t>::ClippedPolyline(const AABB2<coord_t>& box
 
 // Douglass-Peucker generalization. Finds the vertex farthest from the
 // segment between vertices i and j and checks if this distance exceeds
-// the tolerance. If the distance is less than the tolerance the segment
-// i,j is added to the output list of generalized vertices.
+// the tolerance. If so the range is split in two at that vertex, if not the
+// segment i,j is added to the generalized vertices. Ranges are kept on an
+// explicit stack, left before right, so the output comes out in order and
+// can be written over the front of pts_: every vertex still to be read is
+// past the last one written.
 template <class coord_t>
-void Polyline2<coord_t>::DouglasPeucker(const uint32_t i, const uint32_t j,
-                    const float t2, std::vector<coord_t>& genpts) {
-  // Find the vertex farthest from the line segment ViVj
+void Polyline2<coord_t>::DouglasPeucker(const float t2) {
+  if (pts_.size() < 2)
+    return;
+  uint32_t n = 0;
+  std::vector<std::pair<uint32_t, uint32_t> > ranges;
+  ranges.emplace_back(0, pts_.size() - 1);
+  while (!ranges.empty()) {
+    uint32_t i = ranges.back().first, j = ranges.back().second;
+    ranges.pop_back();
+
+    // If the maximum distance is greater than the error tolerance,
+    // divide the sub-polyline into two at the furthest point
+    auto farthest = Farthest(i, j);
+    if (farthest.second > t2) {
+      ranges.emplace_back(farthest.first, j);
+      ranges.emplace_back(i, farthest.first);
+    }
+    else {
+      // Output segment ViVj to the generalized shape
+      if (n == 0 || !(pts_[i] == pts_[n - 1]))
+        pts_[n++] = pts_[i];
+      if (!(pts_[j] == pts_[n - 1]))
+        pts_[n++] = pts_[j];
+    }
+  }
+  pts_.resize(n);
+}
+
+// Find the vertex strictly between vertices i and j farthest from the
+// segment ViVj.
+template <class coord_t>
+std::pair<uint32_t, float> Polyline2<coord_t>::Farthest(const uint32_t i,
+                                                        const uint32_t j) const {
   uint32_t index = 0;
   float maxdist = 0.0f;
   float d2;
@@ -118,27 +325,66 @@ void Polyline2<coord_t>::DouglasPeucker(const uint32_t i, const uint32_t j,
       index   = k;
     }
   }
+  return std::make_pair(index, maxdist);
+}
 
-  // If the maximum distance is greater than the error tolerance,
-  // divide the sub-polyline into two at the furthest point and
-  // recursively call this method
-  if (maxdist > t2) {
-    DouglasPeucker(i, index, t2, genpts);
-    DouglasPeucker(index, j, t2, genpts);
+// Visvalingam-Whyatt. The vertices are a doubly linked list over the
+// indices so removing one is constant time, and an indexed heap gives the
+// vertex with the smallest area in O(log n).
+template <class coord_t>
+void Polyline2<coord_t>::VisvalingamWhyatt(const float area, const uint32_t count,
+                                           std::vector<float>& areas,
+                                           std::vector<bool>& removed) const {
+  const uint32_t n = pts_.size();
+  areas.assign(n, std::numeric_limits<float>::infinity());
+  removed.assign(n, false);
+  if (n < 3)
+    return;
+
+  std::vector<uint32_t> prev(n), next(n);
+  area_heap heap(areas);
+  for (uint32_t i = 1; i + 1 < n; ++i) {
+    prev[i] = i - 1;
+    next[i] = i + 1;
+    areas[i] = triangle_area(pts_[i - 1], pts_[i], pts_[i + 1]);
+    heap.push(i);
   }
-  else {
-    // Output segment ViVj to the generalized shape
-    uint32_t n = genpts.size();
-    if (n == 0 || !(pts_[i] == genpts[n-1])) {
-      genpts.push_back(pts_[i]);
-      n++;
+
+  // Neighbors get the area of their new triangle but never less than the
+  // area of the vertex just removed, so effective areas don't decrease in
+  // the order vertices are removed
+  uint32_t left = n;
+  while (!heap.empty() && left > count && areas[heap.top()] < area) {
+    uint32_t v = heap.top();
+    heap.pop();
+    removed[v] = true;
+    --left;
+    uint32_t p = prev[v], q = next[v];
+    next[p] = q;
+    prev[q] = p;
+    if (p > 0) {
+      areas[p] = std::max(triangle_area(pts_[prev[p]], pts_[p], pts_[q]), areas[v]);
+      heap.update(p);
     }
-    if (!(pts_[j] == genpts[n-1])) {
-      genpts.push_back(pts_[j]);
+    if (q + 1 < n) {
+      areas[q] = std::max(triangle_area(pts_[p], pts_[q], pts_[next[q]]), areas[v]);
+      heap.update(q);
     }
   }
 }
 
+// Remove the vertices flagged as removed, in place.
+template <class coord_t>
+uint32_t Polyline2<coord_t>::Remove(const std::vector<bool>& removed) {
+  uint32_t n = 0;
+  for (uint32_t k = 0; k < pts_.size(); ++k) {
+    if (!removed[k])
+      pts_[n++] = pts_[k];
+  }
+  pts_.resize(n);
+  return n;
+}
+
 // Explicit instantiation
 template class Polyline2<Point2>;
 template class Polyline2<PointLL>;
@@ -0,0 +1,266 @@
+#include "midgard/polylinesoa.h"
+#include "midgard/distanceapproximator.h"
+#include "midgard/constants.h"
+#include "simd.h"
+#include "closestpoint.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace valhalla::midgard;
+using namespace valhalla::midgard::simd;
+
+namespace {
+
+  //the arrays are padded with this many copies of the last vertex which
+  //covers the widest vector
+  constexpr size_t kPadding = 8;
+
+  //meters per degree on the sphere PointLL::Distance uses
+  constexpr float kMetersPerDegree = kRadEarthMeters * kRadPerDeg;
+
+  //squared distance from the closest point c to p, as c.DistanceSquared(p)
+  //does. PointLL centers a DistanceApproximator on c
+  template <class coord_t>
+  float_v closest_distance_squared(float_v cx, float_v cy, float_v px, float_v py) {
+    float_v dx = px - cx, dy = py - cy;
+    if (coord_t::IsSpherical()) {
+      dx = dx * (cos_lat(cy) * float_v(kMetersPerDegreeLat));
+      dy = dy * float_v(kMetersPerDegreeLat);
+    }
+    return dx * dx + dy * dy;
+  }
+
+  //squared distance of the points p to the segment ab, as LineSegment2::DistanceSquared
+  template <class coord_t>
+  float_v segment_distance_squared(float_v ax, float_v ay, float_v bx, float_v by,
+                                   float_v px, float_v py) {
+    float_v vx = bx - ax, vy = by - ay;
+    float_v n = (px - ax) * vx + (py - ay) * vy;
+    float_v d = vx * vx + vy * vy;
+    float_v t = n / d;
+    mask_v before = n <= float_v(0.f), after = d <= n;
+    float_v cx = select(before, ax, select(after, bx, ax + vx * t));
+    float_v cy = select(before, ay, select(after, by, ay + vy * t));
+    return closest_distance_squared<coord_t>(cx, cy, px, py);
+  }
+
+  //horizontal sum
+  float sum(float_v v) {
+    float lanes[kWidth];
+    v.store(lanes);
+    float total = 0.f;
+    for (size_t i = 0; i < kWidth; ++i)
+      total += lanes[i];
+    return total;
+  }
+
+  //horizontal min and max
+  float min(float_v v) {
+    float lanes[kWidth];
+    v.store(lanes);
+    return *std::min_element(lanes, lanes + kWidth);
+  }
+  float max(float_v v) {
+    float lanes[kWidth];
+    v.store(lanes);
+    return *std::max_element(lanes, lanes + kWidth);
+  }
+
+}
+
+namespace valhalla {
+namespace midgard {
+
+template <class coord_t>
+PolylineSoA<coord_t>::PolylineSoA() : size_(0) { }
+
+// Constructor given a list of points.
+template <class coord_t>
+PolylineSoA<coord_t>::PolylineSoA(const std::vector<coord_t>& pts) : size_(pts.size()) {
+  x_.reserve(size_ + kPadding);
+  y_.reserve(size_ + kPadding);
+  for (const auto& p : pts) {
+    x_.push_back(p.x());
+    y_.push_back(p.y());
+  }
+  pad();
+}
+
+// Get the number of vertices.
+template <class coord_t>
+size_t PolylineSoA<coord_t>::size() const {
+  return size_;
+}
+
+// Get the x values.
+template <class coord_t>
+const float* PolylineSoA<coord_t>::x() const {
+  return x_.data();
+}
+
+// Get the y values.
+template <class coord_t>
+const float* PolylineSoA<coord_t>::y() const {
+  return y_.data();
+}
+
+// Get a vertex.
+template <class coord_t>
+coord_t PolylineSoA<coord_t>::at(const size_t i) const {
+  return coord_t(x_[i], y_[i]);
+}
+
+// Add a point to the polyline unless it equals the current endpoint.
+template <class coord_t>
+void PolylineSoA<coord_t>::Add(const coord_t& p) {
+  if (size_ > 0 && p == at(size_ - 1))
+    return;
+  x_.resize(size_);
+  y_.resize(size_);
+  x_.push_back(p.x());
+  y_.push_back(p.y());
+  ++size_;
+  pad();
+}
+
+// Get the list of points.
+template <class coord_t>
+std::vector<coord_t> PolylineSoA<coord_t>::pts() const {
+  std::vector<coord_t> pts;
+  pts.reserve(size_);
+  for (size_t i = 0; i < size_; ++i)
+    pts.emplace_back(x_[i], y_[i]);
+  return pts;
+}
+
+// Get the polyline as a Polyline2.
+template <class coord_t>
+Polyline2<coord_t> PolylineSoA<coord_t>::ToPolyline2() const {
+  std::vector<coord_t> points = pts();
+  return Polyline2<coord_t>(points);
+}
+
+// Accumulate the length of all segments, several segments at a time.
+template <class coord_t>
+float PolylineSoA<coord_t>::Length() const {
+  float_v length(0.f);
+  for (size_t i = 0; i + 1 < size_; i += kWidth) {
+    float_v x0 = float_v::load(&x_[i]), x1 = float_v::load(&x_[i + 1]);
+    float_v y0 = float_v::load(&y_[i]), y1 = float_v::load(&y_[i + 1]);
+    float_v dx = x1 - x0, dy = y1 - y0;
+    if (coord_t::IsSpherical()) {
+      dx = dx * (cos_lat((y0 + y1) * float_v(0.5f)) * float_v(kMetersPerDegree));
+      dy = dy * float_v(kMetersPerDegree);
+    }
+    length = length + sqrt(dx * dx + dy * dy);
+  }
+  return sum(length);
+}
+
+// Finds the closest point to the supplied point.
+template <class coord_t>
+std::tuple<coord_t, float, int> PolylineSoA<coord_t>::ClosestPoint(const coord_t& pt) const {
+  // Distance scale, PointLL uses a DistanceApproximator centered on pt
+  float sx = 1.f, sy = 1.f;
+  if (coord_t::IsSpherical()) {
+    sx = DistanceApproximator::MetersPerLngDegree(pt.y());
+    sy = kMetersPerDegreeLat;
+  }
+  const simd::target_t target{ pt.x(), pt.y(), sx, sy };
+
+  if (size_ == 0)
+    return std::make_tuple(coord_t(), std::numeric_limits<float>::max(), -1);
+  if (size_ == 1)
+    return std::make_tuple(at(0), target.distance_squared(x_[0], y_[0]), 0);
+
+  // Padding only forms zero length segments so every segment can be done
+  // in vector blocks
+  simd::shape_t shape{ x_.data(), y_.data(), 1, size_ };
+  size_t segments = (size_ - 1 + kWidth - 1) / kWidth * kWidth;
+  auto closest = simd::closest_point(shape, segments, target);
+  return std::make_tuple(coord_t(closest.x, closest.y), closest.d, closest.index);
+}
+
+// Get the bounding box of the polyline.
+template <class coord_t>
+AABB2<coord_t> PolylineSoA<coord_t>::BoundingBox() const {
+  if (size_ == 0)
+    return AABB2<coord_t>();
+  float_v minx(x_[0]), miny(y_[0]), maxx(x_[0]), maxy(y_[0]);
+  for (size_t i = 0; i < size_; i += kWidth) {
+    float_v x = float_v::load(&x_[i]), y = float_v::load(&y_[i]);
+    minx = simd::min(minx, x);
+    maxx = simd::max(maxx, x);
+    miny = simd::min(miny, y);
+    maxy = simd::max(maxy, y);
+  }
+  return AABB2<coord_t>(min(minx), min(miny), max(maxx), max(maxy));
+}
+
+// Get the squared distance of a range of vertices to a segment.
+template <class coord_t>
+void PolylineSoA<coord_t>::DistancesToSegment(const coord_t& a, const coord_t& b,
+                                              const size_t begin, const size_t end,
+                                              float* d2) const {
+  const float_v ax(a.x()), ay(a.y()), bx(b.x()), by(b.y());
+  for (size_t k = begin; k < end; k += kWidth) {
+    float_v d = segment_distance_squared<coord_t>(ax, ay, bx, by,
+        float_v::load(&x_[k]), float_v::load(&y_[k]));
+    if (k + kWidth <= end) {
+      d.store(d2 + (k - begin));
+    } else {
+      float lanes[kWidth];
+      d.store(lanes);
+      std::copy(lanes, lanes + (end - k), d2 + (k - begin));
+    }
+  }
+}
+
+// Find the vertex strictly between i and j farthest from the segment ViVj.
+template <class coord_t>
+std::pair<uint32_t, float> PolylineSoA<coord_t>::FarthestFromSegment(const uint32_t i,
+                                                                     const uint32_t j) const {
+  const float_v ax(x_[i]), ay(y_[i]), bx(x_[j]), by(y_[j]);
+  const int_v last(static_cast<int32_t>(j));
+  float_v best(0.f);
+  int_v besti(0), index = int_v::iota() + int_v(static_cast<int32_t>(i + 1));
+  for (size_t k = i + 1; k < j; k += kWidth, index = index + int_v(kWidth)) {
+    float_v d = segment_distance_squared<coord_t>(ax, ay, bx, by,
+        float_v::load(&x_[k]), float_v::load(&y_[k]));
+    mask_v better = (d > best) & (index < last);
+    best = select(better, d, best);
+    besti = select(better, index, besti);
+  }
+
+  // Reduce the lanes preferring the lowest index on ties
+  float lane_d[kWidth];
+  int32_t lane_i[kWidth];
+  best.store(lane_d);
+  besti.store(lane_i);
+  std::pair<uint32_t, float> farthest(0, 0.f);
+  for (size_t l = 0; l < kWidth; ++l) {
+    if (lane_d[l] > farthest.second ||
+        (lane_d[l] == farthest.second && lane_d[l] > 0.f && static_cast<uint32_t>(lane_i[l]) < farthest.first))
+      farthest = std::make_pair(static_cast<uint32_t>(lane_i[l]), lane_d[l]);
+  }
+  return farthest;
+}
+
+// Fill the padding with copies of the last vertex.
+template <class coord_t>
+void PolylineSoA<coord_t>::pad() {
+  x_.resize(size_ + kPadding);
+  y_.resize(size_ + kPadding);
+  if (size_ > 0) {
+    std::fill(x_.begin() + size_, x_.end(), x_[size_ - 1]);
+    std::fill(y_.begin() + size_, y_.end(), y_[size_ - 1]);
+  }
+}
+
+// Explicit instantiation
+template class PolylineSoA<Point2>;
+template class PolylineSoA<PointLL>;
+
+}
+}
@@ -0,0 +1,153 @@
+#include "midgard/preparedpolyline.h"
+#include "midgard/distanceapproximator.h"
+#include "midgard/constants.h"
+#include "closestpoint.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace valhalla::midgard;
+
+namespace {
+
+  //segments per leaf block, small enough that scanning a block is cheap and
+  //large enough that the tree stays shallow
+  constexpr uint32_t kLeafSegments = 8;
+
+  //leaf boxes are grown by this fraction of the coordinate magnitude. A
+  //projected point can land a rounding error outside the box of its segment,
+  //growing the box keeps the box distance a true lower bound
+  constexpr float kBoxSlack = 1e-6f;
+
+  //deepest tree is 32 levels, the stack holds at most one sibling per level
+  constexpr size_t kStackSize = 64;
+
+  //squared distance from the target to the nearest point of a box, in the
+  //same units as the candidate distances
+  template <class coord_t>
+  float box_distance_squared(const AABB2<coord_t>& box, const simd::target_t& t) {
+    float dx = std::max(std::max(box.minx() - t.x, t.x - box.maxx()), 0.f) * t.sx;
+    float dy = std::max(std::max(box.miny() - t.y, t.y - box.maxy()), 0.f) * t.sy;
+    return dx * dx + dy * dy;
+  }
+
+}
+
+namespace valhalla {
+namespace midgard {
+
+// Constructor given a list of points. Builds the box hierarchy bottom up.
+template <class coord_t>
+PreparedPolyline<coord_t>::PreparedPolyline(const std::vector<coord_t>& pts)
+    : pts_(pts), leaves_(1) {
+  static_assert(sizeof(coord_t) == 2 * sizeof(float), "Polylines are loaded as interleaved floats");
+  uint32_t segments = pts_.size() > 1 ? pts_.size() - 1 : 0;
+  uint32_t blocks = (segments + kLeafSegments - 1) / kLeafSegments;
+  while (leaves_ < blocks)
+    leaves_ *= 2;
+
+  const float inf = std::numeric_limits<float>::infinity();
+  nodes_.assign(2 * leaves_, AABB2<coord_t>(inf, inf, -inf, -inf));
+  for (uint32_t l = 0; l < blocks; ++l) {
+    uint32_t first = l * kLeafSegments;
+    uint32_t last = std::min(first + kLeafSegments, segments);
+    auto& box = nodes_[leaves_ + l];
+    for (uint32_t i = first; i <= last; ++i)
+      box.Expand(AABB2<coord_t>(pts_[i], pts_[i]));
+    float sx = (std::abs(box.minx()) + std::abs(box.maxx()) + 1.f) * kBoxSlack;
+    float sy = (std::abs(box.miny()) + std::abs(box.maxy()) + 1.f) * kBoxSlack;
+    box = AABB2<coord_t>(box.minx() - sx, box.miny() - sy, box.maxx() + sx, box.maxy() + sy);
+  }
+  for (uint32_t n = leaves_ - 1; n > 0; --n) {
+    nodes_[n] = nodes_[2 * n];
+    nodes_[n].Expand(nodes_[2 * n + 1]);
+  }
+}
+
+// Get the list of points.
+template <class coord_t>
+const std::vector<coord_t>& PreparedPolyline<coord_t>::pts() const {
+  return pts_;
+}
+
+// Get the bounding box of the polyline.
+template <class coord_t>
+AABB2<coord_t> PreparedPolyline<coord_t>::BoundingBox() const {
+  return AABB2<coord_t>(pts_);
+}
+
+// Finds the closest point to the supplied point, branch and bound over the
+// box hierarchy.
+template <class coord_t>
+std::tuple<coord_t, float, int> PreparedPolyline<coord_t>::ClosestPoint(const coord_t& pt) const {
+  // Distance scale, PointLL uses a DistanceApproximator centered on pt
+  float sx = 1.f, sy = 1.f;
+  if (coord_t::IsSpherical()) {
+    sx = DistanceApproximator::MetersPerLngDegree(pt.y());
+    sy = kMetersPerDegreeLat;
+  }
+  const simd::target_t target{ pt.x(), pt.y(), sx, sy };
+
+  if (pts_.empty())
+    return std::make_tuple(coord_t(), std::numeric_limits<float>::max(), -1);
+  if (pts_.size() == 1)
+    return std::make_tuple(pts_.front(), target.distance_squared(pts_[0].x(), pts_[0].y()), 0);
+
+  // Depth first, nearest child first. A node is skipped once its box is
+  // farther than the best candidate. Equal distances are still visited so
+  // ties can go to the lowest segment index like the sequential loop
+  const simd::shape_t shape{ &pts_.front().first, &pts_.front().second, 2, pts_.size() };
+  const uint32_t segments = pts_.size() - 1;
+  simd::closest_t closest{ 0.f, 0.f, std::numeric_limits<float>::max(), -1 };
+  std::pair<uint32_t, float> stack[kStackSize];
+  size_t top = 0;
+  stack[top++] = std::make_pair(1u, box_distance_squared(nodes_[1], target));
+  while (top > 0) {
+    auto node = stack[--top];
+    if (node.second > closest.d)
+      continue;
+
+    // Scan the segments of a leaf
+    if (node.first >= leaves_) {
+      uint32_t first = (node.first - leaves_) * kLeafSegments;
+      uint32_t last = std::min(first + kLeafSegments, segments);
+      for (uint32_t i = first; i < last; ++i) {
+        simd::closest_t candidate{ 0.f, 0.f, std::numeric_limits<float>::max(), -1 };
+        simd::closest_segment(shape, i, target, candidate);
+        if (candidate.index != -1 && (candidate.d < closest.d ||
+            (candidate.d == closest.d && candidate.index < closest.index)))
+          closest = candidate;
+      }
+      continue;
+    }
+
+    // Push the far child first so the near one is visited next
+    uint32_t left = 2 * node.first, right = left + 1;
+    float dl = box_distance_squared(nodes_[left], target);
+    float dr = box_distance_squared(nodes_[right], target);
+    if (dl <= dr) {
+      stack[top++] = std::make_pair(right, dr);
+      stack[top++] = std::make_pair(left, dl);
+    } else {
+      stack[top++] = std::make_pair(left, dl);
+      stack[top++] = std::make_pair(right, dr);
+    }
+  }
+
+  // Test the end point if the target is beyond the end
+  if (simd::beyond_end(shape, target)) {
+    const coord_t& end = pts_.back();
+    float d = target.distance_squared(end.x(), end.y());
+    if (d < closest.d)
+      closest = simd::closest_t{ end.x(), end.y(), d, static_cast<int>(segments - 1) };
+  }
+  return std::make_tuple(coord_t(closest.x, closest.y), closest.d, closest.index);
+}
+
+// Explicit instantiation
+template class PreparedPolyline<Point2>;
+template class PreparedPolyline<PointLL>;
+
+}
+}
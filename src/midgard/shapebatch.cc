@@ -0,0 +1,176 @@
+#include "midgard/shapebatch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <thread>
+
+namespace valhalla {
+namespace midgard {
+
+namespace {
+
+//starting a thread costs about as much as encoding or decoding this many
+//points, fewer than this per thread aren't worth one
+constexpr size_t kPointsPerThread = 16384;
+//and the bytes of text they take
+constexpr size_t kBytesPerThread = 4 * kPointsPerThread;
+
+//how many threads to split work of the given size over
+unsigned int workers(const unsigned int threads, const size_t work, const size_t per_thread) {
+  size_t most = threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+  return static_cast<unsigned int>(std::max<size_t>(1, std::min(most, work / per_thread)));
+}
+
+//split count items into runs of about the same total weight, run p is the
+//items from bounds[p] to bounds[p + 1]
+template <class weight_t>
+std::vector<size_t> partition(const size_t count, const unsigned int parts, weight_t weight) {
+  size_t total = 0;
+  for (size_t i = 0; i < count; ++i)
+    total += weight(i);
+  std::vector<size_t> bounds(parts + 1, count);
+  bounds[0] = 0;
+  size_t sum = 0, part = 1;
+  for (size_t i = 0; i < count && part < parts; ++i) {
+    sum += weight(i);
+    while (part < parts && sum * parts >= total * part)
+      bounds[part++] = i + 1;
+  }
+  return bounds;
+}
+
+//do run p of the work for every p, the first on the calling thread and the
+//rest on threads of their own. if no more threads can be started, as on a
+//loaded server, the calling thread does the runs that didn't get one. the
+//first exception thrown is rethrown once all the runs are done
+template <class work_t>
+void run(const unsigned int parts, work_t work) {
+  std::vector<std::exception_ptr> errors(parts);
+  auto attempt = [&work, &errors](const unsigned int p) {
+    try { work(p); } catch (...) { errors[p] = std::current_exception(); }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(parts);
+  unsigned int started = 1;
+  try {
+    for (; started < parts; ++started)
+      threads.emplace_back(attempt, started);
+  }
+  catch (const std::exception&) {
+  }
+  attempt(0);
+  for (unsigned int p = started; p < parts; ++p)
+    attempt(p);
+  for (auto& thread : threads)
+    thread.join();
+  for (const auto& error : errors)
+    if (error)
+      std::rethrow_exception(error);
+}
+
+//decode shapes whose text is given by a callback, i -> pair of bytes and length
+template <class text_at_t>
+DecodedShapes decode_all(const size_t count, text_at_t text_at, const int precision,
+                         const unsigned int threads) {
+  const double inverse = 1.0 / encoding::scale(precision);
+  size_t bytes = 0;
+  for (size_t i = 0; i < count; ++i)
+    bytes += text_at(i).second;
+  unsigned int parts = workers(threads, bytes, kBytesPerThread);
+  auto bounds = partition(count, parts, [&text_at](const size_t i) { return text_at(i).second + 1; });
+
+  //count the points of every shape, which validates them
+  DecodedShapes decoded;
+  decoded.offsets.resize(count + 1);
+  run(parts, [&](const unsigned int p) {
+    for (size_t i = bounds[p]; i < bounds[p + 1]; ++i) {
+      auto text = text_at(i);
+      decoded.offsets[i + 1] = decoded_size(text.first, text.second);
+    }
+  });
+  for (size_t i = 0; i < count; ++i)
+    decoded.offsets[i + 1] += decoded.offsets[i];
+
+  //then decode them in place
+  decoded.points.resize(decoded.offsets.back());
+  run(parts, [&](const unsigned int p) {
+    for (size_t i = bounds[p]; i < bounds[p + 1]; ++i) {
+      auto text = text_at(i);
+      PointLL* point = decoded.points.data() + decoded.offsets[i];
+      encoding::decode_points(text.first, text.first + text.second,
+                              [&point, inverse](const int lon, const int lat) {
+        *point++ = PointLL(encoding::unscale<float>(lon, inverse),
+                           encoding::unscale<float>(lat, inverse));
+      });
+    }
+  });
+  return decoded;
+}
+
+}
+
+//each thread encodes its run of shapes into its own buffer, noting where
+//each shape ends in it. once the buffers' sizes are known they are copied
+//into place and the ends moved by where the buffer landed
+EncodedShapes encode_shapes(const std::vector<std::vector<PointLL> >& shapes,
+                            const int precision, const unsigned int threads) {
+  encoding::scale(precision);
+  size_t points = 0;
+  for (const auto& shape : shapes)
+    points += shape.size();
+  unsigned int parts = workers(threads, points, kPointsPerThread);
+  auto bounds = partition(shapes.size(), parts,
+                          [&shapes](const size_t i) { return shapes[i].size() + 1; });
+
+  EncodedShapes encoded;
+  encoded.precision = precision;
+  encoded.offsets.resize(shapes.size() + 1);
+  std::vector<std::string> buffers(parts);
+  run(parts, [&](const unsigned int p) {
+    size_t run_points = 0;
+    for (size_t i = bounds[p]; i < bounds[p + 1]; ++i)
+      run_points += shapes[i].size();
+    //most numbers take 3 bytes or fewer
+    buffers[p].resize(run_points * 6);
+    encoding::string_buffer_t buffer{buffers[p], 0};
+    for (size_t i = bounds[p]; i < bounds[p + 1]; ++i) {
+      encoding::encode_points(shapes[i].begin(), shapes[i].end(), precision, buffer);
+      encoded.offsets[i + 1] = buffer.size;
+    }
+    buffers[p].resize(buffer.size);
+  });
+
+  //a single buffer already is the whole text
+  if (parts == 1) {
+    encoded.data.swap(buffers[0]);
+    return encoded;
+  }
+  std::vector<size_t> bases(parts + 1, 0);
+  for (unsigned int p = 0; p < parts; ++p)
+    bases[p + 1] = bases[p] + buffers[p].size();
+  encoded.data.resize(bases.back());
+  run(parts, [&](const unsigned int p) {
+    std::memcpy(&encoded.data[bases[p]], buffers[p].data(), buffers[p].size());
+    for (size_t i = bounds[p]; i < bounds[p + 1]; ++i)
+      encoded.offsets[i + 1] += bases[p];
+  });
+  return encoded;
+}
+
+DecodedShapes decode_shapes(const EncodedShapes& shapes, const unsigned int threads) {
+  return decode_all(shapes.size(), [&shapes](const size_t i) {
+    return std::make_pair(shapes.data.data() + shapes.offsets[i],
+                          shapes.offsets[i + 1] - shapes.offsets[i]);
+  }, shapes.precision, threads);
+}
+
+DecodedShapes decode_shapes(const std::vector<std::string>& shapes, const int precision,
+                            const unsigned int threads) {
+  return decode_all(shapes.size(), [&shapes](const size_t i) {
+    return std::make_pair(shapes[i].data(), shapes[i].size());
+  }, precision, threads);
+}
+
+}
+}
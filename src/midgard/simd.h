@@ -0,0 +1,268 @@
+#ifndef VALHALLA_MIDGARD_SIMD_H_
+#define VALHALLA_MIDGARD_SIMD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "midgard/constants.h"
+
+// Thin wrappers over the widest float vector the target has (AVX2, SSE2 or a
+// single float otherwise) so kernels can be written once. Only used inside
+// the library, it is not installed.
+
+namespace valhalla {
+namespace midgard {
+namespace simd {
+
+#if defined(__AVX2__)
+
+struct float_v {
+  static constexpr size_t width = 8;
+  __m256 v;
+  float_v() = default;
+  float_v(__m256 v) : v(v) { }
+  float_v(float f) : v(_mm256_set1_ps(f)) { }
+  static float_v load(const float* p) { return _mm256_loadu_ps(p); }
+  void store(float* p) const { _mm256_storeu_ps(p, v); }
+};
+
+struct int_v {
+  __m256i v;
+  int_v() = default;
+  int_v(__m256i v) : v(v) { }
+  int_v(int32_t i) : v(_mm256_set1_epi32(i)) { }
+  static int_v iota() { return _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7); }
+  void store(int32_t* p) const { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+};
+
+struct mask_v {
+  __m256 v;
+};
+
+inline float_v operator+(float_v a, float_v b) { return _mm256_add_ps(a.v, b.v); }
+inline float_v operator-(float_v a, float_v b) { return _mm256_sub_ps(a.v, b.v); }
+inline float_v operator*(float_v a, float_v b) { return _mm256_mul_ps(a.v, b.v); }
+inline float_v operator/(float_v a, float_v b) { return _mm256_div_ps(a.v, b.v); }
+inline float_v sqrt(float_v a) { return _mm256_sqrt_ps(a.v); }
+inline float_v min(float_v a, float_v b) { return _mm256_min_ps(a.v, b.v); }
+inline float_v max(float_v a, float_v b) { return _mm256_max_ps(a.v, b.v); }
+inline mask_v operator<(float_v a, float_v b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+inline mask_v operator<=(float_v a, float_v b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+inline mask_v operator>(float_v a, float_v b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+inline mask_v operator>=(float_v a, float_v b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) }; }
+inline mask_v operator==(float_v a, float_v b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ) }; }
+inline mask_v operator&(mask_v a, mask_v b) { return { _mm256_and_ps(a.v, b.v) }; }
+inline mask_v operator|(mask_v a, mask_v b) { return { _mm256_or_ps(a.v, b.v) }; }
+inline bool any(mask_v m) { return _mm256_movemask_ps(m.v) != 0; }
+inline float_v select(mask_v m, float_v a, float_v b) { return _mm256_blendv_ps(b.v, a.v, m.v); }
+inline int_v operator+(int_v a, int_v b) { return _mm256_add_epi32(a.v, b.v); }
+inline int_v select(mask_v m, int_v a, int_v b) {
+  return _mm256_blendv_epi8(b.v, a.v, _mm256_castps_si256(m.v));
+}
+inline mask_v operator<(int_v a, int_v b) { return { _mm256_castsi256_ps(_mm256_cmpgt_epi32(b.v, a.v)) }; }
+//load x,y pairs, x into x and y into y
+inline void load_interleaved(const float* p, float_v& x, float_v& y) {
+  __m256 a = _mm256_loadu_ps(p), b = _mm256_loadu_ps(p + 8);
+  //within each 128 bit half the shuffle gives x0 x1 x4 x5 | x2 x3 x6 x7
+  x.v = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(
+      _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0)));
+  y.v = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(
+      _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+#elif defined(__SSE2__)
+
+struct float_v {
+  static constexpr size_t width = 4;
+  __m128 v;
+  float_v() = default;
+  float_v(__m128 v) : v(v) { }
+  float_v(float f) : v(_mm_set1_ps(f)) { }
+  static float_v load(const float* p) { return _mm_loadu_ps(p); }
+  void store(float* p) const { _mm_storeu_ps(p, v); }
+};
+
+struct int_v {
+  __m128i v;
+  int_v() = default;
+  int_v(__m128i v) : v(v) { }
+  int_v(int32_t i) : v(_mm_set1_epi32(i)) { }
+  static int_v iota() { return _mm_setr_epi32(0, 1, 2, 3); }
+  void store(int32_t* p) const { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+};
+
+struct mask_v {
+  __m128 v;
+};
+
+inline float_v operator+(float_v a, float_v b) { return _mm_add_ps(a.v, b.v); }
+inline float_v operator-(float_v a, float_v b) { return _mm_sub_ps(a.v, b.v); }
+inline float_v operator*(float_v a, float_v b) { return _mm_mul_ps(a.v, b.v); }
+inline float_v operator/(float_v a, float_v b) { return _mm_div_ps(a.v, b.v); }
+inline float_v sqrt(float_v a) { return _mm_sqrt_ps(a.v); }
+inline float_v min(float_v a, float_v b) { return _mm_min_ps(a.v, b.v); }
+inline float_v max(float_v a, float_v b) { return _mm_max_ps(a.v, b.v); }
+inline mask_v operator<(float_v a, float_v b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+inline mask_v operator<=(float_v a, float_v b) { return { _mm_cmple_ps(a.v, b.v) }; }
+inline mask_v operator>(float_v a, float_v b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+inline mask_v operator>=(float_v a, float_v b) { return { _mm_cmpge_ps(a.v, b.v) }; }
+inline mask_v operator==(float_v a, float_v b) { return { _mm_cmpeq_ps(a.v, b.v) }; }
+inline mask_v operator&(mask_v a, mask_v b) { return { _mm_and_ps(a.v, b.v) }; }
+inline mask_v operator|(mask_v a, mask_v b) { return { _mm_or_ps(a.v, b.v) }; }
+inline bool any(mask_v m) { return _mm_movemask_ps(m.v) != 0; }
+inline float_v select(mask_v m, float_v a, float_v b) {
+  return _mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v));
+}
+inline int_v operator+(int_v a, int_v b) { return _mm_add_epi32(a.v, b.v); }
+inline int_v select(mask_v m, int_v a, int_v b) {
+  __m128i mi = _mm_castps_si128(m.v);
+  return _mm_or_si128(_mm_and_si128(mi, a.v), _mm_andnot_si128(mi, b.v));
+}
+inline mask_v operator<(int_v a, int_v b) { return { _mm_castsi128_ps(_mm_cmplt_epi32(a.v, b.v)) }; }
+//load x,y pairs, x into x and y into y
+inline void load_interleaved(const float* p, float_v& x, float_v& y) {
+  __m128 a = _mm_loadu_ps(p), b = _mm_loadu_ps(p + 4);
+  x.v = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+  y.v = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+#else
+
+struct float_v {
+  static constexpr size_t width = 1;
+  float v;
+  float_v() = default;
+  float_v(float f) : v(f) { }
+  static float_v load(const float* p) { return *p; }
+  void store(float* p) const { *p = v; }
+};
+
+struct int_v {
+  int32_t v;
+  int_v() = default;
+  int_v(int32_t i) : v(i) { }
+  static int_v iota() { return 0; }
+  void store(int32_t* p) const { *p = v; }
+};
+
+struct mask_v {
+  bool v;
+};
+
+inline float_v operator+(float_v a, float_v b) { return a.v + b.v; }
+inline float_v operator-(float_v a, float_v b) { return a.v - b.v; }
+inline float_v operator*(float_v a, float_v b) { return a.v * b.v; }
+inline float_v operator/(float_v a, float_v b) { return a.v / b.v; }
+inline float_v sqrt(float_v a) { return sqrtf(a.v); }
+inline float_v min(float_v a, float_v b) { return a.v < b.v ? a.v : b.v; }
+inline float_v max(float_v a, float_v b) { return a.v > b.v ? a.v : b.v; }
+inline mask_v operator<(float_v a, float_v b) { return { a.v < b.v }; }
+inline mask_v operator<=(float_v a, float_v b) { return { a.v <= b.v }; }
+inline mask_v operator>(float_v a, float_v b) { return { a.v > b.v }; }
+inline mask_v operator>=(float_v a, float_v b) { return { a.v >= b.v }; }
+inline mask_v operator==(float_v a, float_v b) { return { a.v == b.v }; }
+inline mask_v operator&(mask_v a, mask_v b) { return { a.v && b.v }; }
+inline mask_v operator|(mask_v a, mask_v b) { return { a.v || b.v }; }
+inline bool any(mask_v m) { return m.v; }
+inline float_v select(mask_v m, float_v a, float_v b) { return m.v ? a : b; }
+inline int_v operator+(int_v a, int_v b) { return a.v + b.v; }
+inline int_v select(mask_v m, int_v a, int_v b) { return m.v ? a : b; }
+inline mask_v operator<(int_v a, int_v b) { return { a.v < b.v }; }
+//load x,y pairs, x into x and y into y
+inline void load_interleaved(const float* p, float_v& x, float_v& y) {
+  x.v = p[0];
+  y.v = p[1];
+}
+
+#endif
+
+constexpr size_t kWidth = float_v::width;
+
+//min and max of single floats, like minps and maxps b is given if a is NaN
+inline float min(float a, float b) { return a < b ? a : b; }
+inline float max(float a, float b) { return a > b ? a : b; }
+
+/**
+ * Cosine of a latitude given in degrees, using a polynomial in place of
+ * cosf. The absolute error is below 2e-7 over [-90, 90], about twice that of
+ * cosf of the same float radians. The series is only good near that range so
+ * latitudes are clamped to it, one that is NaN counts as 90. Works on a
+ * float_v or a single float so scalar code can get the exact same values as
+ * the kernels.
+ */
+template <class T>
+inline T cos_lat(T lat) {
+  T x = max(min(lat, T(90.f)), T(-90.f)) * T(kRadPerDeg);
+  T x2 = x * x;
+  // Taylor series of cos to the x^12 term, evaluated with Horner's method
+  T c = T(1.f / 479001600.f);
+  c = c * x2 + T(-1.f / 3628800.f);
+  c = c * x2 + T(1.f / 40320.f);
+  c = c * x2 + T(-1.f / 720.f);
+  c = c * x2 + T(1.f / 24.f);
+  c = c * x2 + T(-0.5f);
+  return c * x2 + T(1.f);
+}
+
+/**
+ * Sine of an angle in radians within [-pi/2, pi/2], using the Taylor series
+ * to the x^11 term. The absolute error is below 1e-7 and the relative error
+ * is a few float ulps.
+ */
+inline float_v sin_rad(float_v x) {
+  float_v x2 = x * x;
+  float_v s = float_v(-1.f / 39916800.f);
+  s = s * x2 + float_v(1.f / 362880.f);
+  s = s * x2 + float_v(-1.f / 5040.f);
+  s = s * x2 + float_v(1.f / 120.f);
+  s = s * x2 + float_v(-1.f / 6.f);
+  return s * x2 * x + x;
+}
+
+/**
+ * Arcsine of a value within [0, 1]. Below 0.5 this is the minimax
+ * polynomial of the Cephes asinf, above it the identity
+ * asin(x) = pi/2 - 2 asin(sqrt((1 - x) / 2)) brings the argument back below
+ * 0.5. The relative error is below 3e-7.
+ */
+inline float_v asin(float_v x) {
+  mask_v big = x > float_v(0.5f);
+  float_v z = select(big, (float_v(1.f) - x) * float_v(0.5f), x * x);
+  float_v a = select(big, sqrt(z), x);
+  float_v p = float_v(4.2163199048e-2f);
+  p = p * z + float_v(2.4181311049e-2f);
+  p = p * z + float_v(4.5470025998e-2f);
+  p = p * z + float_v(7.4953002686e-2f);
+  p = p * z + float_v(1.6666752422e-1f);
+  p = p * z * a + a;
+  return select(big, float_v(kPiOver2) - (p + p), p);
+}
+
+/**
+ * Great circle distance in meters between lng,lat positions in degrees, on
+ * the same sphere as PointLL::Distance. Uses the haversine formula, which
+ * unlike the law of cosines keeps its precision for short distances in
+ * float, with the polynomials above in place of libm. Longitude deltas are
+ * wrapped so segments crossing the antimeridian take the short way.
+ */
+inline float_v great_circle(float_v lng0, float_v lat0, float_v lng1, float_v lat1) {
+  float_v dlng = lng1 - lng0;
+  dlng = select(dlng > float_v(180.f), dlng - float_v(360.f),
+                select(dlng < float_v(-180.f), dlng + float_v(360.f), dlng));
+  float_v a = sin_rad((lat1 - lat0) * float_v(kRadPerDeg * 0.5f));
+  float_v b = sin_rad(dlng * float_v(kRadPerDeg * 0.5f));
+  // cos_lat may be a hair below zero at the poles
+  float_v h = a * a + max(cos_lat(lat0) * cos_lat(lat1), float_v(0.f)) * b * b;
+  return asin(sqrt(min(h, float_v(1.f)))) * float_v(2.f * kRadEarthMeters);
+}
+
+}
+}
+}
+
+#endif  // VALHALLA_MIDGARD_SIMD_H_
@@ -0,0 +1,81 @@
+#include "midgard/streamgeneralizer.h"
+#include "midgard/linesegment2.h"
+
+#include <algorithm>
+
+namespace valhalla {
+namespace midgard {
+
+// Constructor. The window is allocated once.
+template <class coord_t>
+StreamGeneralizer<coord_t>::StreamGeneralizer(const float t, const uint32_t capacity)
+    : t2_(t * t), capacity_(std::max(capacity, 1u)), started_(false) {
+  window_.reserve(capacity_);
+}
+
+// Add the next point of the polyline.
+template <class coord_t>
+bool StreamGeneralizer<coord_t>::Add(const coord_t& p, coord_t& out) {
+  // The first point is always output
+  if (!started_) {
+    started_ = true;
+    anchor_ = p;
+    out = p;
+    return true;
+  }
+
+  // Skip repeated points
+  const coord_t& last = window_.empty() ? anchor_ : window_.back();
+  if (p == last)
+    return false;
+
+  // Grow the window while every point in it is within the tolerance of the
+  // segment from the anchor to p
+  if (window_.size() < capacity_) {
+    coord_t tmp;
+    LineSegment2<coord_t> segment(anchor_, p);
+    bool within = true;
+    for (const auto& w : window_) {
+      if (segment.DistanceSquared(w, tmp) > t2_) {
+        within = false;
+        break;
+      }
+    }
+    if (within) {
+      window_.push_back(p);
+      return false;
+    }
+  }
+
+  // Output the last point that kept the window within the tolerance and
+  // start a new window from it
+  anchor_ = window_.back();
+  out = anchor_;
+  window_.clear();
+  window_.push_back(p);
+  return true;
+}
+
+// End the polyline with its last point.
+template <class coord_t>
+bool StreamGeneralizer<coord_t>::Finish(coord_t& out) {
+  bool output = !window_.empty();
+  if (output)
+    out = window_.back();
+  window_.clear();
+  started_ = false;
+  return output;
+}
+
+// Get the number of points held back.
+template <class coord_t>
+uint32_t StreamGeneralizer<coord_t>::size() const {
+  return window_.size();
+}
+
+// Explicit instantiation
+template class StreamGeneralizer<Point2>;
+template class StreamGeneralizer<PointLL>;
+
+}
+}
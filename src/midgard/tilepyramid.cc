@@ -0,0 +1,204 @@
+#include "midgard/tilepyramid.h"
+#include "midgard/point2.h"
+#include "midgard/pointll.h"
+
+#include <cmath>
+#include <list>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+
+namespace valhalla {
+namespace midgard {
+
+template <class coord_t>
+constexpr uint32_t TilePyramid<coord_t>::kLevelBits;
+template <class coord_t>
+constexpr uint32_t TilePyramid<coord_t>::kMaxLevels;
+
+// Constructor. Checks that every level evenly subdivides the level above it
+// and that the tile Ids of every level fit in a packed Id.
+template <class coord_t>
+TilePyramid<coord_t>::TilePyramid(const AABB2<coord_t>& bounds,
+                                  const std::vector<float>& tilesizes,
+                                  const unsigned short subdivisions) {
+  if (tilesizes.empty() || tilesizes.size() > kMaxLevels)
+    throw std::runtime_error("TilePyramid requires between 1 and " +
+                             std::to_string(kMaxLevels) + " levels");
+
+  levels_.reserve(tilesizes.size());
+  scale_.reserve(tilesizes.size());
+  for (size_t i = 0; i < tilesizes.size(); ++i) {
+    int32_t ratio = 1;
+    if (i > 0) {
+      // The ratio to the level above has to be a whole number
+      float r = tilesizes[i - 1] / tilesizes[i];
+      ratio = static_cast<int32_t>(std::round(r));
+      if (ratio < 1 || std::abs(r - ratio) > 1e-4f * r)
+        throw std::runtime_error("TilePyramid level " + std::to_string(i) +
+                                 " does not evenly subdivide the level above it");
+    }
+    levels_.emplace_back(bounds, tilesizes[i], subdivisions);
+    uint64_t count = static_cast<uint64_t>(levels_.back().ncolumns()) * levels_.back().nrows();
+    if (count > (uint64_t(1) << (31 - kLevelBits)))
+      throw std::runtime_error("TilePyramid level " + std::to_string(i) +
+                               " has too many tiles to pack into an Id");
+    scale_.push_back(i > 0 ? scale_.back() * ratio : 1);
+  }
+}
+
+// Get the number of levels.
+template <class coord_t>
+uint32_t TilePyramid<coord_t>::levels() const {
+  return levels_.size();
+}
+
+// Get the tiling system of a level.
+template <class coord_t>
+const Tiles<coord_t>& TilePyramid<coord_t>::tiles(const uint32_t level) const {
+  if (level >= levels_.size())
+    throw std::out_of_range("TilePyramid has no level " + std::to_string(level));
+  return levels_[level];
+}
+
+// Pack a level and tile Id into a single Id.
+template <class coord_t>
+int32_t TilePyramid<coord_t>::Id(const uint32_t level, const int32_t tileid) {
+  return (tileid < 0) ? -1 : (tileid << kLevelBits) | static_cast<int32_t>(level);
+}
+
+// Get the level of a packed Id.
+template <class coord_t>
+uint32_t TilePyramid<coord_t>::Level(const int32_t id) {
+  return static_cast<uint32_t>(id) & (kMaxLevels - 1);
+}
+
+// Get the tile Id (within its level) of a packed Id.
+template <class coord_t>
+int32_t TilePyramid<coord_t>::TileId(const int32_t id) {
+  return id >> kLevelBits;
+}
+
+// Get the packed Id of the tile containing a coordinate at a level.
+template <class coord_t>
+int32_t TilePyramid<coord_t>::TileId(const coord_t& c, const uint32_t level) const {
+  return Id(level, tiles(level).TileId(c));
+}
+
+// Get the parent of a tile.
+template <class coord_t>
+int32_t TilePyramid<coord_t>::Parent(const int32_t id) const {
+  uint32_t level = Level(id);
+  return (level == 0) ? -1 : Ancestor(id, level - 1);
+}
+
+// Get the ancestor of a tile on a coarser (or the same) level. All levels
+// share an origin so the ancestor row and column are found by dividing by
+// the number of tiles per ancestor tile.
+template <class coord_t>
+int32_t TilePyramid<coord_t>::Ancestor(const int32_t id, const uint32_t level) const {
+  uint32_t from = Level(id);
+  if (id < 0 || from >= levels_.size() || level > from)
+    return -1;
+
+  int32_t factor = scale_[from] / scale_[level];
+  auto rc = levels_[from].GetRowColumn(TileId(id));
+  return Id(level, levels_[level].TileId(rc.second / factor, rc.first / factor));
+}
+
+// Get the children of a tile.
+template <class coord_t>
+std::vector<int32_t> TilePyramid<coord_t>::Children(const int32_t id) const {
+  std::vector<int32_t> children;
+  uint32_t level = Level(id);
+  if (id < 0 || level + 1 >= levels_.size())
+    return children;
+
+  // Children form a factor x factor block, clipped to the child level extent
+  const auto& child_tiles = levels_[level + 1];
+  int32_t factor = scale_[level + 1] / scale_[level];
+  auto rc = levels_[level].GetRowColumn(TileId(id));
+  int32_t maxrow = std::min((rc.first + 1) * factor, child_tiles.nrows());
+  int32_t maxcol = std::min((rc.second + 1) * factor, child_tiles.ncolumns());
+  children.reserve(factor * factor);
+  for (int32_t row = rc.first * factor; row < maxrow; ++row) {
+    for (int32_t col = rc.second * factor; col < maxcol; ++col)
+      children.push_back(Id(level + 1, child_tiles.TileId(col, row)));
+  }
+  return children;
+}
+
+// Get the tiles of every level that intersect a bounding box.
+template <class coord_t>
+std::vector<int32_t> TilePyramid<coord_t>::Cover(const AABB2<coord_t>& boundingbox) const {
+  std::vector<int32_t> cover;
+  const auto& finest = levels_.back();
+  const auto bounds = finest.TileBounds();
+  if (!bounds.Intersects(boundingbox))
+    return cover;
+
+  // Find the row and column range on the finest level (clamped to the bounds)
+  int32_t mincol = finest.Col(std::max(boundingbox.minx(), bounds.minx()));
+  int32_t maxcol = finest.Col(std::min(boundingbox.maxx(), bounds.maxx()));
+  int32_t minrow = finest.Row(std::max(boundingbox.miny(), bounds.miny()));
+  int32_t maxrow = finest.Row(std::min(boundingbox.maxy(), bounds.maxy()));
+
+  // Like TileList, tiles that only touch the bounding box count as well
+  auto base = finest.TileBounds(mincol, minrow);
+  if (mincol > 0 && boundingbox.minx() == base.minx())
+    --mincol;
+  if (minrow > 0 && boundingbox.miny() == base.miny())
+    --minrow;
+
+  // Derive the range of each level from the finest one
+  for (uint32_t level = 0; level < levels_.size(); ++level) {
+    int32_t factor = scale_.back() / scale_[level];
+    for (int32_t row = minrow / factor; row <= maxrow / factor; ++row) {
+      for (int32_t col = mincol / factor; col <= maxcol / factor; ++col)
+        cover.push_back(Id(level, levels_[level].TileId(col, row)));
+    }
+  }
+  return cover;
+}
+
+// Get the tiles of every level that a linestring intersects.
+template <class coord_t>
+template <class container_t>
+std::vector<int32_t> TilePyramid<coord_t>::Cover(const container_t& linestring) const {
+  // Rasterize once on the finest level
+  const auto& finest = levels_.back();
+  auto intersection = finest.Intersect(linestring);
+
+  // Roll each intersected tile up through the levels above it
+  std::vector<std::unordered_set<int32_t> > tiles(levels_.size());
+  for (const auto& tile : intersection) {
+    auto rc = finest.GetRowColumn(tile.first);
+    for (uint32_t level = 0; level < levels_.size(); ++level) {
+      int32_t factor = scale_.back() / scale_[level];
+      tiles[level].insert(levels_[level].TileId(rc.second / factor, rc.first / factor));
+    }
+  }
+
+  // Pack them in level then tile order
+  std::vector<int32_t> cover;
+  for (uint32_t level = 0; level < levels_.size(); ++level) {
+    std::vector<int32_t> tileids(tiles[level].begin(), tiles[level].end());
+    std::sort(tileids.begin(), tileids.end());
+    for (const auto tileid : tileids)
+      cover.push_back(Id(level, tileid));
+  }
+  return cover;
+}
+
+// Explicit instantiation
+template class TilePyramid<Point2>;
+template class TilePyramid<PointLL>;
+
+template std::vector<int32_t> TilePyramid<Point2>::Cover(const std::list<Point2>&) const;
+template std::vector<int32_t> TilePyramid<PointLL>::Cover(const std::list<PointLL>&) const;
+template std::vector<int32_t> TilePyramid<Point2>::Cover(const std::vector<Point2>&) const;
+template std::vector<int32_t> TilePyramid<PointLL>::Cover(const std::vector<PointLL>&) const;
+
+}
+}
@@ -1,6 +1,15 @@
 #include "midgard/tiles.h"
+#include "midgard/distanceapproximator.h"
+#include "midgard/util.h"
 #include <cmath>
 #include <functional>
+#include <algorithm>
+#include <queue>
+#include <limits>
+
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 namespace {
 
@@ -69,6 +78,221 @@ namespace {
     }
   }
 
+  //spread the bits of a 32 bit value out so there is a 0 bit between each of them
+  uint64_t spread_bits(uint64_t v) {
+    v &= 0x00000000ffffffff;
+    v = (v | (v << 16)) & 0x0000ffff0000ffff;
+    v = (v | (v << 8))  & 0x00ff00ff00ff00ff;
+    v = (v | (v << 4))  & 0x0f0f0f0f0f0f0f0f;
+    v = (v | (v << 2))  & 0x3333333333333333;
+    v = (v | (v << 1))  & 0x5555555555555555;
+    return v;
+  }
+
+  //the opposite of the above, gathers every other bit back into a 32 bit value
+  uint32_t compact_bits(uint64_t v) {
+    v &= 0x5555555555555555;
+    v = (v | (v >> 1))  & 0x3333333333333333;
+    v = (v | (v >> 2))  & 0x0f0f0f0f0f0f0f0f;
+    v = (v | (v >> 4))  & 0x00ff00ff00ff00ff;
+    v = (v | (v >> 8))  & 0x0000ffff0000ffff;
+    v = (v | (v >> 16)) & 0x00000000ffffffff;
+    return static_cast<uint32_t>(v);
+  }
+
+  //rotate/flip a quadrant so the sub curve within it has the right orientation
+  void hilbert_rotate(uint32_t n, uint32_t& x, uint32_t& y, uint32_t rx, uint32_t ry) {
+    if(ry == 0) {
+      if(rx == 1) {
+        x = n - 1 - x;
+        y = n - 1 - y;
+      }
+      std::swap(x, y);
+    }
+  }
+
+  //distance along the hilbert curve filling an n by n square (n is a power of 2)
+  uint64_t hilbert_index(uint32_t n, uint32_t x, uint32_t y) {
+    uint64_t d = 0;
+    for(uint32_t s = n / 2; s > 0; s /= 2) {
+      uint32_t rx = (x & s) > 0;
+      uint32_t ry = (y & s) > 0;
+      d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+      hilbert_rotate(n, x, y, rx, ry);
+    }
+    return d;
+  }
+
+  //x,y position of a distance along the hilbert curve filling an n by n square
+  void hilbert_position(uint32_t n, uint64_t d, uint32_t& x, uint32_t& y) {
+    x = y = 0;
+    for(uint32_t s = 1; s < n; s *= 2) {
+      uint32_t rx = 1 & static_cast<uint32_t>(d / 2);
+      uint32_t ry = 1 & static_cast<uint32_t>(d ^ rx);
+      hilbert_rotate(s, x, y, rx, ry);
+      x += s * rx;
+      y += s * ry;
+      d /= 4;
+    }
+  }
+
+  //squared distance from a seed point, planar for Point2
+  template <class coord_t>
+  struct seed_distance_t {
+    seed_distance_t(const coord_t& seed): seed(seed) { }
+    float operator()(const coord_t& p) const { return seed.DistanceSquared(p); }
+    coord_t seed;
+  };
+
+  //and approximate meters for PointLL, set up once for the seed
+  template <>
+  struct seed_distance_t<valhalla::midgard::PointLL> {
+    seed_distance_t(const valhalla::midgard::PointLL& seed): approx(seed) { }
+    float operator()(const valhalla::midgard::PointLL& p) const { return approx.DistanceSquared(p); }
+    valhalla::midgard::DistanceApproximator approx;
+  };
+
+  //everything the batch tile id kernels need to know about the tiling system
+  struct batch_params_t {
+    float minx, miny, maxx, maxy;
+    float size, inv_size, inv_subsize;
+    int32_t ncolumns, nrows, nsubdivisions;
+  };
+
+  //the reciprocal and the multiply each round by at most half an ulp so a lane whose
+  //quotient is within this relative distance of a whole number could floor differently
+  //than an actual division would. those lanes get redone with a division
+  constexpr float kReciprocalTolerance = 4e-7f;
+
+  //index of the subdivision a point falls in given its offset from the tiling system origin
+  unsigned short subdivision_index(const batch_params_t& p, float dx, float dy, int32_t col, int32_t row) {
+    float sx = (dx - static_cast<float>(col) * p.size) * p.inv_subsize;
+    float sy = (dy - static_cast<float>(row) * p.size) * p.inv_subsize;
+    float last = static_cast<float>(p.nsubdivisions - 1);
+    sx = std::min(std::max(sx, 0.f), last);
+    sy = std::min(std::max(sy, 0.f), last);
+    return static_cast<int32_t>(sy) * p.nsubdivisions + static_cast<int32_t>(sx);
+  }
+
+#if defined(__AVX2__)
+  //floor(d / size) for d >= 0 using the reciprocal
+  inline __m256i floor_div(__m256 d, __m256 size, __m256 inv_size) {
+    __m256 q = _mm256_mul_ps(d, inv_size);
+    __m256i t = _mm256_cvttps_epi32(q);
+    __m256 frac = _mm256_sub_ps(q, _mm256_cvtepi32_ps(t));
+    __m256 tol = _mm256_mul_ps(q, _mm256_set1_ps(kReciprocalTolerance));
+    __m256 near = _mm256_or_ps(_mm256_cmp_ps(frac, tol, _CMP_LT_OQ),
+                               _mm256_cmp_ps(frac, _mm256_sub_ps(_mm256_set1_ps(1.f), tol), _CMP_GT_OQ));
+    if (_mm256_movemask_ps(near))
+      t = _mm256_blendv_epi8(t, _mm256_cvttps_epi32(_mm256_div_ps(d, size)), _mm256_castps_si256(near));
+    return t;
+  }
+
+  //8 points at a time, returns how many points were done
+  size_t tile_ids_simd(const batch_params_t& p, const float* ys, const float* xs, const size_t count,
+                       int32_t* tileids, unsigned short* subdivisions) {
+    const __m256 minx = _mm256_set1_ps(p.minx), miny = _mm256_set1_ps(p.miny);
+    const __m256 maxx = _mm256_set1_ps(p.maxx), maxy = _mm256_set1_ps(p.maxy);
+    const __m256 size = _mm256_set1_ps(p.size), inv_size = _mm256_set1_ps(p.inv_size);
+    const __m256 inv_subsize = _mm256_set1_ps(p.inv_subsize);
+    const __m256 last_sub = _mm256_set1_ps(static_cast<float>(p.nsubdivisions - 1));
+    const __m256i ncolumns = _mm256_set1_epi32(p.ncolumns), nsubdivisions = _mm256_set1_epi32(p.nsubdivisions);
+    const __m256i last_col = _mm256_set1_epi32(p.ncolumns - 1), last_row = _mm256_set1_epi32(p.nrows - 1);
+    const __m256i invalid = _mm256_set1_epi32(-1);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+      __m256 x = _mm256_loadu_ps(xs + i), y = _mm256_loadu_ps(ys + i);
+      __m256i inside = _mm256_castps_si256(_mm256_and_ps(
+        _mm256_and_ps(_mm256_cmp_ps(x, minx, _CMP_GE_OQ), _mm256_cmp_ps(x, maxx, _CMP_LE_OQ)),
+        _mm256_and_ps(_mm256_cmp_ps(y, miny, _CMP_GE_OQ), _mm256_cmp_ps(y, maxy, _CMP_LE_OQ))));
+      __m256 dx = _mm256_sub_ps(x, minx), dy = _mm256_sub_ps(y, miny);
+      //points on the max edges belong to the last column/row
+      __m256i col = _mm256_blendv_epi8(floor_div(dx, size, inv_size), last_col,
+                                       _mm256_castps_si256(_mm256_cmp_ps(x, maxx, _CMP_EQ_OQ)));
+      __m256i row = _mm256_blendv_epi8(floor_div(dy, size, inv_size), last_row,
+                                       _mm256_castps_si256(_mm256_cmp_ps(y, maxy, _CMP_EQ_OQ)));
+      __m256i id = _mm256_add_epi32(_mm256_mullo_epi32(row, ncolumns), col);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(tileids + i), _mm256_blendv_epi8(invalid, id, inside));
+      if (subdivisions) {
+        __m256 sx = _mm256_mul_ps(_mm256_sub_ps(dx, _mm256_mul_ps(_mm256_cvtepi32_ps(col), size)), inv_subsize);
+        __m256 sy = _mm256_mul_ps(_mm256_sub_ps(dy, _mm256_mul_ps(_mm256_cvtepi32_ps(row), size)), inv_subsize);
+        sx = _mm256_min_ps(_mm256_max_ps(sx, _mm256_setzero_ps()), last_sub);
+        sy = _mm256_min_ps(_mm256_max_ps(sy, _mm256_setzero_ps()), last_sub);
+        __m256i sub = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvttps_epi32(sy), nsubdivisions),
+                                       _mm256_cvttps_epi32(sx));
+        alignas(32) int32_t subs[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(subs), _mm256_and_si256(sub, inside));
+        for (int j = 0; j < 8; ++j)
+          subdivisions[i + j] = static_cast<unsigned short>(subs[j]);
+      }
+    }
+    return i;
+  }
+#elif defined(__SSE2__)
+  //keep the low 32 bits of each lane product (SSE4.1 has this as _mm_mullo_epi32)
+  inline __m128i mullo_epi32(__m128i a, __m128i b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+  }
+
+  //lanes of a where the mask is set otherwise lanes of b
+  inline __m128i select(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+  }
+
+  //floor(d / size) for d >= 0 using the reciprocal
+  inline __m128i floor_div(__m128 d, __m128 size, __m128 inv_size) {
+    __m128 q = _mm_mul_ps(d, inv_size);
+    __m128i t = _mm_cvttps_epi32(q);
+    __m128 frac = _mm_sub_ps(q, _mm_cvtepi32_ps(t));
+    __m128 tol = _mm_mul_ps(q, _mm_set1_ps(kReciprocalTolerance));
+    __m128 near = _mm_or_ps(_mm_cmplt_ps(frac, tol), _mm_cmpgt_ps(frac, _mm_sub_ps(_mm_set1_ps(1.f), tol)));
+    if (_mm_movemask_ps(near))
+      t = select(_mm_castps_si128(near), _mm_cvttps_epi32(_mm_div_ps(d, size)), t);
+    return t;
+  }
+
+  //4 points at a time, returns how many points were done
+  size_t tile_ids_simd(const batch_params_t& p, const float* ys, const float* xs, const size_t count,
+                       int32_t* tileids, unsigned short* subdivisions) {
+    const __m128 minx = _mm_set1_ps(p.minx), miny = _mm_set1_ps(p.miny);
+    const __m128 maxx = _mm_set1_ps(p.maxx), maxy = _mm_set1_ps(p.maxy);
+    const __m128 size = _mm_set1_ps(p.size), inv_size = _mm_set1_ps(p.inv_size);
+    const __m128 inv_subsize = _mm_set1_ps(p.inv_subsize);
+    const __m128 last_sub = _mm_set1_ps(static_cast<float>(p.nsubdivisions - 1));
+    const __m128i ncolumns = _mm_set1_epi32(p.ncolumns), nsubdivisions = _mm_set1_epi32(p.nsubdivisions);
+    const __m128i last_col = _mm_set1_epi32(p.ncolumns - 1), last_row = _mm_set1_epi32(p.nrows - 1);
+    const __m128i invalid = _mm_set1_epi32(-1);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+      __m128 x = _mm_loadu_ps(xs + i), y = _mm_loadu_ps(ys + i);
+      __m128i inside = _mm_castps_si128(_mm_and_ps(
+        _mm_and_ps(_mm_cmpge_ps(x, minx), _mm_cmple_ps(x, maxx)),
+        _mm_and_ps(_mm_cmpge_ps(y, miny), _mm_cmple_ps(y, maxy))));
+      __m128 dx = _mm_sub_ps(x, minx), dy = _mm_sub_ps(y, miny);
+      //points on the max edges belong to the last column/row
+      __m128i col = select(_mm_castps_si128(_mm_cmpeq_ps(x, maxx)), last_col, floor_div(dx, size, inv_size));
+      __m128i row = select(_mm_castps_si128(_mm_cmpeq_ps(y, maxy)), last_row, floor_div(dy, size, inv_size));
+      __m128i id = _mm_add_epi32(mullo_epi32(row, ncolumns), col);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(tileids + i), select(inside, id, invalid));
+      if (subdivisions) {
+        __m128 sx = _mm_mul_ps(_mm_sub_ps(dx, _mm_mul_ps(_mm_cvtepi32_ps(col), size)), inv_subsize);
+        __m128 sy = _mm_mul_ps(_mm_sub_ps(dy, _mm_mul_ps(_mm_cvtepi32_ps(row), size)), inv_subsize);
+        sx = _mm_min_ps(_mm_max_ps(sx, _mm_setzero_ps()), last_sub);
+        sy = _mm_min_ps(_mm_max_ps(sy, _mm_setzero_ps()), last_sub);
+        __m128i sub = _mm_add_epi32(mullo_epi32(_mm_cvttps_epi32(sy), nsubdivisions), _mm_cvttps_epi32(sx));
+        alignas(16) int32_t subs[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(subs), _mm_and_si128(sub, inside));
+        for (int j = 0; j < 4; ++j)
+          subdivisions[i + j] = static_cast<unsigned short>(subs[j]);
+      }
+    }
+    return i;
+  }
+#endif
+
 }
 
 namespace valhalla {
@@ -78,13 +302,39 @@ namespace midgard {
 // Sets class data members and computes the number of rows and columns
 // based on the bounding box and tile size.
 template <class coord_t>
-Tiles<coord_t>::Tiles(const AABB2<coord_t>& bounds, const float tilesize, unsigned short subdivisions):
-  tilebounds_(bounds), tilesize_(tilesize), nsubdivisions_(subdivisions){
+Tiles<coord_t>::Tiles(const AABB2<coord_t>& bounds, const float tilesize, unsigned short subdivisions,
+                      const TileOrder order):
+  tilebounds_(bounds), tilesize_(tilesize), nsubdivisions_(subdivisions), tile_order_(order) {
   tilebounds_ = bounds;
   tilesize_ = tilesize;
   subdivision_size_ = tilesize_ / nsubdivisions_;
+  inv_tilesize_ = 1.0f / tilesize_;
+  inv_subdivision_size_ = 1.0f / subdivision_size_;
   ncolumns_ = static_cast<int32_t>(ceil((bounds.maxx() - bounds.minx()) / tilesize_));
   nrows_    = static_cast<int32_t>(ceil((bounds.maxy() - bounds.miny()) / tilesize_));
+
+  // The ordering curves fill a power of 2 square covering all rows and columns
+  curve_size_ = 1;
+  while (curve_size_ < static_cast<uint32_t>(std::max(ncolumns_, nrows_)))
+    curve_size_ *= 2;
+}
+
+// Get the number of subdivisions along each side of a tile.
+template <class coord_t>
+unsigned short Tiles<coord_t>::nsubdivisions() const {
+  return nsubdivisions_;
+}
+
+// Get the order in which tiles are emitted.
+template <class coord_t>
+TileOrder Tiles<coord_t>::tile_order() const {
+  return tile_order_;
+}
+
+// Set the order in which tiles are emitted.
+template <class coord_t>
+void Tiles<coord_t>::set_tile_order(const TileOrder order) {
+  tile_order_ = order;
 }
 
 // Get the tile size. Tiles are square.
@@ -161,6 +411,53 @@ int32_t Tiles<coord_t>::TileId(const float y, const float x) const {
   return (Row(y) * ncolumns_) + Col(x);
 }
 
+// Convert arrays of y,x coordinates into tile Ids and optionally the
+// subdivision within the tile. SIMD kernels do as many points as they can
+// and whatever is left is done one point at a time.
+template <class coord_t>
+void Tiles<coord_t>::TileIds(const float* ys, const float* xs, const size_t count,
+                             int32_t* tileids, unsigned short* subdivisions) const {
+  const batch_params_t p{ tilebounds_.minx(), tilebounds_.miny(), tilebounds_.maxx(),
+                          tilebounds_.maxy(), tilesize_, inv_tilesize_, inv_subdivision_size_,
+                          ncolumns_, nrows_, nsubdivisions_ };
+  size_t i = 0;
+#if defined(__SSE2__) || defined(__AVX2__)
+  i = tile_ids_simd(p, ys, xs, count, tileids, subdivisions);
+#endif
+  for (; i < count; ++i) {
+    tileids[i] = TileId(ys[i], xs[i]);
+    if (subdivisions) {
+      if (tileids[i] == -1) {
+        subdivisions[i] = 0;
+      } else {
+        auto rc = GetRowColumn(tileids[i]);
+        subdivisions[i] = subdivision_index(p, xs[i] - p.minx, ys[i] - p.miny, rc.second, rc.first);
+      }
+    }
+  }
+}
+
+// Convert a list of points into tile Ids and optionally the subdivision
+// within the tile. Points are split into coordinate arrays a block at a time.
+template <class coord_t>
+void Tiles<coord_t>::TileIds(const std::vector<coord_t>& pts, std::vector<int32_t>& tileids,
+                             std::vector<unsigned short>* subdivisions) const {
+  constexpr size_t kBlockSize = 256;
+  float ys[kBlockSize], xs[kBlockSize];
+  tileids.resize(pts.size());
+  if (subdivisions)
+    subdivisions->resize(pts.size());
+  for (size_t start = 0; start < pts.size(); start += kBlockSize) {
+    size_t n = std::min(kBlockSize, pts.size() - start);
+    for (size_t i = 0; i < n; ++i) {
+      ys[i] = pts[start + i].second;
+      xs[i] = pts[start + i].first;
+    }
+    TileIds(ys, xs, n, tileids.data() + start,
+            subdivisions ? subdivisions->data() + start : nullptr);
+  }
+}
+
 // Get the tile Id given the row Id and column Id.
 template <class coord_t>
 int32_t Tiles<coord_t>::TileId(const int32_t col, const int32_t row) const {
@@ -174,6 +471,76 @@ std::pair<int32_t, int32_t> Tiles<coord_t>::GetRowColumn(
   return { tileid / ncolumns_, tileid % ncolumns_ };
 }
 
+// Get the position of a tile along the space filling curve of the tile order.
+template <class coord_t>
+uint64_t Tiles<coord_t>::CurveIndex(const int32_t tileid) const {
+  uint32_t row = tileid / ncolumns_;
+  uint32_t col = tileid % ncolumns_;
+  switch (tile_order_) {
+    case kMorton:
+      return spread_bits(col) | (spread_bits(row) << 1);
+    case kHilbert:
+      return hilbert_index(curve_size_, col, row);
+    default:
+      return tileid;
+  }
+}
+
+// Get the tile Id at a position along the space filling curve of the tile
+// order. Returns -1 if the position is outside of the tiling system.
+template <class coord_t>
+int32_t Tiles<coord_t>::TileIdFromCurveIndex(const uint64_t index) const {
+  uint32_t col, row;
+  switch (tile_order_) {
+    case kMorton:
+      col = compact_bits(index);
+      row = compact_bits(index >> 1);
+      break;
+    case kHilbert:
+      if (index >= static_cast<uint64_t>(curve_size_) * curve_size_)
+        return -1;
+      hilbert_position(curve_size_, index, col, row);
+      break;
+    default:
+      return (index < TileCount()) ? static_cast<int32_t>(index) : -1;
+  }
+  if (col >= static_cast<uint32_t>(ncolumns_) ||
+      row >= static_cast<uint32_t>(nrows_))
+    return -1;
+  return TileId(static_cast<int32_t>(col), static_cast<int32_t>(row));
+}
+
+// Sort a list of tile Ids by their position along the tile order curve.
+template <class coord_t>
+void Tiles<coord_t>::SortTileIds(std::vector<int32_t>& tileids) const {
+  if (tile_order_ == kRowMajor)
+    return;
+
+  // Compute the curve index once per tile rather than once per comparison
+  std::vector<std::pair<uint64_t, int32_t> > keyed;
+  keyed.reserve(tileids.size());
+  for (const auto tileid : tileids)
+    keyed.emplace_back(CurveIndex(tileid), tileid);
+  std::sort(keyed.begin(), keyed.end());
+  for (size_t i = 0; i < keyed.size(); ++i)
+    tileids[i] = keyed[i].second;
+}
+
+// Get the tile Ids of an intersection result in tile order.
+template <class coord_t>
+std::vector<int32_t> Tiles<coord_t>::OrderedTileIds(const std::unordered_map<int32_t,
+                          std::unordered_set<unsigned short> >& intersection) const {
+  std::vector<int32_t> tileids;
+  tileids.reserve(intersection.size());
+  for (const auto& tile : intersection)
+    tileids.push_back(tile.first);
+  if (tile_order_ == kRowMajor)
+    std::sort(tileids.begin(), tileids.end());
+  else
+    SortTileIds(tileids);
+  return tileids;
+}
+
 // Get a maximum tileid given a bounds and a tile size.
 template <class coord_t>
 uint32_t Tiles<coord_t>::MaxTileId(const AABB2<coord_t>& bbox,
@@ -341,9 +708,80 @@ const std::vector<int>& Tiles<coord_t>::TileList(
       visited_tiles.insert(neighbor);
     }
   }
+
+  // Lay the tiles out along the ordering curve (if there is one)
+  SortTileIds(tilelist_);
   return tilelist_;
 }
 
+// Get a function that visits tiles or subdivisions in order of distance
+// from a seed point. Cells are expanded from the one nearest the seed using
+// a priority queue keyed on the distance to each cell. For any cell one of
+// its (8-connected) neighbors towards the seed is at least as close, so
+// cells come off the queue in true distance order.
+template <class coord_t>
+std::function<std::tuple<int32_t, unsigned short, float>()> Tiles<coord_t>::ClosestFirst(
+                    const coord_t& seed, const bool subdivisions) const {
+  // Size and extent of the grid of cells to visit
+  using cell_t = std::pair<int32_t, int32_t>;
+  int32_t nsub = subdivisions ? nsubdivisions_ : 1;
+  float cellsize = subdivisions ? subdivision_size_ : tilesize_;
+  int32_t ncols = ncolumns_ * nsub;
+  int32_t nrows = nrows_ * nsub;
+  seed_distance_t<coord_t> distance(seed);
+
+  // Minimum distance squared from the seed to a cell (to its closest point)
+  auto cell_distance = [this, cellsize, distance, seed](const cell_t& cell) {
+    float minx = tilebounds_.minx() + cell.first * cellsize;
+    float miny = tilebounds_.miny() + cell.second * cellsize;
+    return distance(coord_t(clamp<float>(seed.first, minx, minx + cellsize),
+                            clamp<float>(seed.second, miny, miny + cellsize)));
+  };
+
+  // Start from the cell nearest to the seed, which contains the seed clamped
+  // to the bounds of the tiling system
+  cell_t start(static_cast<int32_t>((clamp<float>(seed.first, tilebounds_.minx(),
+                  tilebounds_.maxx()) - tilebounds_.minx()) / cellsize),
+               static_cast<int32_t>((clamp<float>(seed.second, tilebounds_.miny(),
+                  tilebounds_.maxy()) - tilebounds_.miny()) / cellsize));
+  start.first = clamp(start.first, 0, ncols - 1);
+  start.second = clamp(start.second, 0, nrows - 1);
+
+  // Queue ordered by smallest distance first and the cells already queued
+  using queued_t = std::pair<float, cell_t>;
+  std::priority_queue<queued_t, std::vector<queued_t>, std::greater<queued_t> > queue;
+  std::unordered_set<uint64_t> queued;
+  queue.emplace(cell_distance(start), start);
+  queued.insert(static_cast<uint64_t>(start.second) * ncols + start.first);
+
+  return [this, queue, queued, cell_distance, nsub, ncols, nrows]() mutable {
+    // Nothing left to visit
+    if (queue.empty())
+      return std::make_tuple(int32_t(-1), static_cast<unsigned short>(0),
+                             std::numeric_limits<float>::infinity());
+
+    // Queue up the unvisited neighbors (including diagonals) of the next cell
+    auto next = queue.top();
+    queue.pop();
+    const cell_t& cell = next.second;
+    for (int32_t dy = -1; dy <= 1; ++dy) {
+      for (int32_t dx = -1; dx <= 1; ++dx) {
+        cell_t neighbor(cell.first + dx, cell.second + dy);
+        if (neighbor.first < 0 || neighbor.second < 0 ||
+            neighbor.first >= ncols || neighbor.second >= nrows ||
+            !queued.insert(static_cast<uint64_t>(neighbor.second) * ncols + neighbor.first).second)
+          continue;
+        queue.emplace(cell_distance(neighbor), neighbor);
+      }
+    }
+
+    // Convert the cell to a tile and subdivision
+    int32_t tileid = TileId(cell.first / nsub, cell.second / nsub);
+    unsigned short subdivision = (cell.second % nsub) * nsub + (cell.first % nsub);
+    return std::make_tuple(tileid, subdivision, std::sqrt(next.first));
+  };
+}
+
 // Color a "connectivity map" starting with a sparse map of uncolored tiles.
 // Any 2 tiles that have a connected path between them will have the same
 // value in the connectivity map.
@@ -483,6 +921,103 @@ std::unordered_map<int32_t, std::unordered_set<unsigned short> > Tiles<coord_t>:
   return intersection;
 }
 
+// Split a shape into per tile pieces in one walk along it. Segments are
+// traversed cell by cell (Amanatides-Woo): the parameter t at which the
+// segment reaches the next column and next row edge is tracked and the
+// nearer one is crossed.
+template <class coord_t>
+void Tiles<coord_t>::Split(const std::vector<coord_t>& shape, std::vector<TilePiece>& pieces,
+                           std::vector<coord_t>& points, std::vector<uint32_t>& segments) const {
+  pieces.clear();
+  points.clear();
+  segments.clear();
+  if (shape.size() < 2)
+    return;
+
+  //column and row of a point, unbounded so points outside still step
+  //across the tiles correctly. the max edge belongs to the last tile, and so
+  //do points just below it that the division rounds up onto it
+  const auto column = [this](const float x) {
+    int32_t col = static_cast<int32_t>(std::floor((x - tilebounds_.minx()) / tilesize_));
+    return x <= tilebounds_.maxx() ? std::min(col, ncolumns_ - 1) : col;
+  };
+  const auto row = [this](const float y) {
+    int32_t row = static_cast<int32_t>(std::floor((y - tilebounds_.miny()) / tilesize_));
+    return y <= tilebounds_.maxy() ? std::min(row, nrows_ - 1) : row;
+  };
+  const auto tile = [this](const int32_t col, const int32_t row) {
+    return col < 0 || row < 0 || col >= ncolumns_ || row >= nrows_ ? -1 : TileId(col, row);
+  };
+
+  //add a point to the current piece, skipping repeats
+  uint32_t begin = 0;
+  const auto add = [&points, &segments, &begin](const coord_t& p, const uint32_t segment) {
+    if (points.size() == begin || !(points.back() == p)) {
+      points.push_back(p);
+      segments.push_back(segment);
+    }
+  };
+
+  //end the current piece, it is kept if it is in a tile and has a length
+  const auto finish = [&pieces, &points, &segments, &begin](const int32_t tileid) {
+    if (tileid != -1 && points.size() - begin > 1) {
+      pieces.push_back({ tileid, begin, static_cast<uint32_t>(points.size()) });
+    } else {
+      points.resize(begin);
+      segments.resize(begin);
+    }
+    begin = points.size();
+  };
+
+  const uint32_t last = shape.size() - 2;
+  int32_t cx = column(shape[0].first), cy = row(shape[0].second);
+  int32_t current = tile(cx, cy);
+  add(shape[0], 0);
+  for (uint32_t i = 0; i + 1 < shape.size(); ++i) {
+    const coord_t& a = shape[i];
+    const coord_t& b = shape[i + 1];
+    const int32_t ex = column(b.first), ey = row(b.second);
+    const float dx = b.first - a.first, dy = b.second - a.second;
+    //steps go towards the tile of b even if rounding put it the other way
+    //from a than the sign of the offset says, so the walk always gets there
+    const int32_t stepx = ex != cx ? (ex > cx ? 1 : -1) : (dx > 0.0f ? 1 : -1);
+    const int32_t stepy = ey != cy ? (ey > cy ? 1 : -1) : (dy > 0.0f ? 1 : -1);
+
+    //edges the segment reaches next and where along the segment it does
+    float edgex = tilebounds_.minx() + (cx + (stepx > 0 ? 1 : 0)) * tilesize_;
+    float edgey = tilebounds_.miny() + (cy + (stepy > 0 ? 1 : 0)) * tilesize_;
+    const float inf = std::numeric_limits<float>::infinity();
+    float tx = dx != 0.0f ? (edgex - a.first) / dx : inf;
+    float ty = dy != 0.0f ? (edgey - a.second) / dy : inf;
+    float t = 0.0f;
+    while (cx != ex || cy != ey) {
+      //only step towards the tile of b, both at once through a corner
+      bool step_x = cx != ex && (cy == ey || tx <= ty);
+      bool step_y = cy != ey && (cx == ex || ty <= tx);
+      t = std::min(std::max(step_x ? tx : ty, t), 1.0f);
+      coord_t crossing(step_x ? edgex : a.first + t * dx, step_y ? edgey : a.second + t * dy);
+      if (step_x) {
+        cx += stepx;
+        edgex += stepx * tilesize_;
+        tx = (edgex - a.first) / dx;
+      }
+      if (step_y) {
+        cy += stepy;
+        edgey += stepy * tilesize_;
+        ty = (edgey - a.second) / dy;
+      }
+
+      //end the piece at the crossing and start the next one there
+      add(crossing, i);
+      finish(current);
+      current = tile(cx, cy);
+      add(crossing, i);
+    }
+    add(b, std::min(i + 1, last));
+  }
+  finish(current);
+}
+
 // Explicit instantiation
 template class Tiles<Point2>;
 template class Tiles<PointLL>;
@@ -15,12 +15,34 @@
 
 namespace {
 
-constexpr double POLYLINE_PRECISION = 1E6;
-constexpr double INV_POLYLINE_PRECISION = 1.0 / POLYLINE_PRECISION;
 constexpr double RAD_PER_METER  = 1.0 / 6378160.187;
 constexpr double RAD_PER_DEG = M_PI / 180.0;
 constexpr double DEG_PER_RAD = 180.0 / M_PI;
 
+//a position on the unit sphere
+struct unit_t {
+  double x, y, z;
+};
+
+unit_t to_unit(const valhalla::midgard::PointLL& p) {
+  double lng = p.first * RAD_PER_DEG, lat = p.second * RAD_PER_DEG;
+  double cl = cos(lat);
+  return { cl * cos(lng), cl * sin(lng), sin(lat) };
+}
+
+valhalla::midgard::PointLL to_ll(const unit_t& u) {
+  return valhalla::midgard::PointLL(atan2(u.y, u.x) * DEG_PER_RAD,
+                                    atan2(u.z, sqrt(u.x * u.x + u.y * u.y)) * DEG_PER_RAD);
+}
+
+double dot(const unit_t& a, const unit_t& b) {
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+unit_t cross(const unit_t& a, const unit_t& b) {
+  return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
 }
 
 namespace valhalla {
@@ -47,161 +69,6 @@ float FastInvSqrt(float x) {
   // x *= 1.5f - xhalf*x*x;          // repeating step increases accuracy
 }
 
-template<class container_t>
-std::string encode(const container_t& points) {
-  //a place to keep the output
-  std::string output;
-  //unless the shape is very course you should probably only need about 3 bytes
-  //per coord, which is 6 bytes with 2 coords, so we overshoot to 8 just in case
-  output.reserve(points.size() * 8);
-
-  //handy lambda to turn an integer into an encoded string
-  auto serialize = [&output](int number) {
-    //move the bits left 1 position and flip all the bits if it was a negative number
-    number = number < 0 ? ~(number << 1) : (number << 1);
-    //write 5 bit chunks of the number
-    while (number >= 0x20) {
-      int nextValue = (0x20 | (number & 0x1f)) + 63;
-      output.push_back(static_cast<char>(nextValue));
-      number >>= 5;
-    }
-    //write the last chunk
-    number += 63;
-    output.push_back(static_cast<char>(number));
-  };
-
-  //this is an offset encoding so we remember the last point we saw
-  int last_lon = 0, last_lat = 0;
-  //for each point
-  for (const auto& p : points) {
-    //shift the decimal point 5 places to the right and truncate
-    int lon = static_cast<int>(floor(static_cast<double>(p.first) * POLYLINE_PRECISION));
-    int lat = static_cast<int>(floor(static_cast<double>(p.second) * POLYLINE_PRECISION));
-    //encode each coordinate, lat first for some reason
-    serialize(lat - last_lat);
-    serialize(lon - last_lon);
-    //remember the last one we encountered
-    last_lon = lon;
-    last_lat = lat;
-  }
-  return output;
-}
-
-template<class container_t>
-void decode(const std::string& encoded, container_t& output) {
-  //what byte are we looking at
-  size_t i = 0;
-
-  //handy lambda to turn a few bytes of an encoded string into an integer
-  auto deserialize = [&encoded, &i](const int previous) {
-    //grab each 5 bits and mask it in where it belongs using the shift
-    int byte, shift = 0, result = 0;
-    do {
-      //TODO: could use a check here for out of bounds
-      //which could happen on improper polyline string data
-      byte = static_cast<int>(encoded[i++]) - 63;
-      result |= (byte & 0x1f) << shift;
-      shift += 5;
-    }while (byte >= 0x20);
-    //undo the left shift from above or the bit flipping and add to previous since its an offset
-    return previous + (result & 1 ? ~(result >> 1) : (result >> 1));
-  };
-
-  //make sure to go over all the characters
-  int last_lon = 0, last_lat = 0;
-  while (i < encoded.length()) {
-    //decode the coordinates, lat first for some reason
-    int lat = deserialize(last_lat);
-    int lon = deserialize(last_lon);
-    //shift the decimal point 5 places to the left
-    output.emplace_back(static_cast<typename container_t::value_type::first_type>(static_cast<double>(lon) * INV_POLYLINE_PRECISION),
-                        static_cast<typename container_t::value_type::second_type>(static_cast<double>(lat) * INV_POLYLINE_PRECISION));
-    //remember the last one we encountered
-    last_lon = lon;
-    last_lat = lat;
-  }
-}
-
-//specialize for list
-template <>
-std::list<PointLL> decode<std::list<PointLL> >(const std::string& encoded) {
-  std::list<PointLL> l;
-  decode(encoded, l);
-  return l;
-}
-template <>
-std::list<std::pair<double,double> > decode<std::list<std::pair<double,double> > >(const std::string& encoded) {
-  std::list<std::pair<double,double> > l;
-  decode(encoded, l);
-  return l;
-}
-template <>
-std::list<Point2> decode<std::list<Point2> >(const std::string& encoded) {
-  std::list<Point2> l;
-  decode(encoded, l);
-  return l;
-}
-template <>
-std::list<std::pair<float,float> > decode<std::list<std::pair<float,float> > >(const std::string& encoded) {
-  std::list<std::pair<float,float> > l;
-  decode(encoded, l);
-  return l;
-}
-
-//specialize for vector with a preallocation
-//based on the length of the string we can make a guess at how many points are in it
-//as above we'll say each point uses 6 bytes, so we overshoot to a quarter of the size
-template <>
-std::vector<PointLL> decode<std::vector<PointLL> >(const std::string& encoded) {
-  std::vector<PointLL> v;
-  v.reserve(encoded.size() * .25f);
-  decode(encoded, v);
-  return v;
-}
-template <>
-std::vector<std::pair<double,double> > decode<std::vector<std::pair<double,double> > >(const std::string& encoded) {
-  std::vector<std::pair<double,double> > v;
-  v.reserve(encoded.size() * .25f);
-  decode(encoded, v);
-  return v;
-}
-template <>
-std::vector<Point2> decode<std::vector<Point2> >(const std::string& encoded) {
-  std::vector<Point2> v;
-  v.reserve(encoded.size() * .25f);
-  decode(encoded, v);
-  return v;
-}
-template <>
-std::vector<std::pair<float,float> > decode<std::vector<std::pair<float,float> > >(const std::string& encoded) {
-  std::vector<std::pair<float,float> > v;
-  v.reserve(encoded.size() * .25f);
-  decode(encoded, v);
-  return v;
-}
-
-//explicit instantiations, we should probably just move the implementation to the header so that
-//projects that depend on this library aren't limited in the instantiations made here
-template std::string encode<std::vector<PointLL> >(const std::vector<PointLL>&);
-template std::string encode<std::vector<std::pair<double,double> > >(const std::vector<std::pair<double,double> >&);
-template std::string encode<std::vector<Point2> >(const std::vector<Point2>&);
-template std::string encode<std::vector<std::pair<float,float> > >(const std::vector<std::pair<float,float> >&);
-
-template std::string encode<std::list<PointLL> >(const std::list<PointLL>&);
-template std::string encode<std::list<std::pair<double,double> > >(const std::list<std::pair<double,double> >&);
-template std::string encode<std::list<Point2> >(const std::list<Point2>&);
-template std::string encode<std::list<std::pair<float,float> > >(const std::list<std::pair<float,float> >&);
-
-template std::vector<PointLL> decode<std::vector<PointLL> >(const std::string&);
-template std::vector<std::pair<double,double> > decode<std::vector<std::pair<double,double> > >(const std::string&);
-template std::vector<Point2> decode<std::vector<Point2> >(const std::string&);
-template std::vector<std::pair<float,float> > decode<std::vector<std::pair<float,float> > >(const std::string&);
-
-template std::list<PointLL> decode<std::list<PointLL> >(const std::string&);
-template std::list<std::pair<double,double> > decode<std::list<std::pair<double,double> > >(const std::string&);
-template std::list<Point2> decode<std::list<Point2> >(const std::string&);
-template std::list<std::pair<float,float> > decode<std::list<std::pair<float,float> > >(const std::string&);
-
 memory_status::memory_status(const std::unordered_set<std::string> interest){
   //grab the vm stats from the file
   std::ifstream file("/proc/self/status");
@@ -244,9 +111,11 @@ std::ostream& operator<<(std::ostream& stream, const memory_status& s){
   return stream;
 }
 
-/* This method makes use of several computations explained and demonstrated at:
- * http://williams.best.vwh.net/avform.htm *
- * We humbly bow to you sir!
+/* Positions are converted to 3D unit vectors once, every segment is then
+ * the arc between two of them. Points along an arc are a rotation of its
+ * start toward its end, stepping the rotation by the resolution with an
+ * angle addition rather than calling sin and cos for every point. Only the
+ * points that are output are converted back to lat,lng.
  */
 template <class container_t>
 container_t resample_spherical_polyline(const container_t& polyline, double resolution) {
@@ -258,46 +127,40 @@ container_t resample_spherical_polyline(const container_t& polyline, double reso
   if(polyline.size() == 1)
     return resampled;
 
-  //for each point
+  //all of the positions at once
+  std::vector<unit_t> units;
+  units.reserve(polyline.size());
+  for(const auto& p : polyline)
+    units.push_back(to_unit(p));
+
+  //the step rotation
   resolution *= RAD_PER_METER;
+  const double cr = cos(resolution), sr = sin(resolution);
   double remaining = resolution;
-  PointLL last = resampled.back();
-  for(auto p = std::next(polyline.cbegin()); p != polyline.cend(); ++p) {
-    //radians
-    auto lon2 = p->first * -RAD_PER_DEG;
-    auto lat2 = p->second * RAD_PER_DEG;
-    //how much do we have left on this segment from where we are (in great arc radians)
-    //double d = 2.0 * asin(sqrt(pow(sin((resampled.back().second * RAD_PER_DEG - lat2) / 2.0), 2.0) + cos(resampled.back().second * RAD_PER_DEG) * cos(lat2) *pow(sin((resampled.back().first * -RAD_PER_DEG - lon2) / 2.0), 2.0)));
-    auto d = acos(
-      sin(last.second * RAD_PER_DEG) * sin(lat2) +
-      cos(last.second * RAD_PER_DEG) * cos(lat2) *
-      cos(last.first * -RAD_PER_DEG - lon2)
-    );
-    //keep placing points while we can fit them
-    while(d > remaining) {
-      //some precomputed stuff
-      auto lon1 = last.first * -RAD_PER_DEG;
-      auto lat1 = last.second * RAD_PER_DEG;
-      auto sd = sin(d);
-      auto a = sin(d - remaining) / sd;
-      auto acs1 = a * cos(lat1);
-      auto b = sin(remaining) / sd;
-      auto bcs2 = b * cos(lat2);
-      //find the interpolated point along the arc
-      auto x = acs1 * cos(lon1) + bcs2 * cos(lon2);
-      auto y = acs1 * sin(lon1) + bcs2 * sin(lon2);
-      auto z = a * sin(lat1) + b * sin(lat2);
-      last.first = atan2(y, x) * -DEG_PER_RAD;
-      last.second = atan2(z, sqrt(x * x + y * y)) * DEG_PER_RAD;
-      resampled.push_back(last);
-      //we just consumed a bit
-      d -= remaining;
-      //we need another bit
-      remaining = resolution;
+  for(size_t i = 1; i < units.size(); ++i) {
+    //the arc of this segment, atan2 keeps short arcs precise where acos would not
+    const unit_t& a = units[i - 1];
+    const unit_t& b = units[i];
+    unit_t n = cross(a, b);
+    double sd = sqrt(dot(n, n));
+    double d = atan2(sd, dot(a, b));
+    //keep placing points while we can fit them, a degenerate arc has no direction
+    if(d > remaining && sd > 0.0) {
+      //unit vector perpendicular to a in the plane of the arc, toward b
+      unit_t w = cross(n, a);
+      w = { w.x / sd, w.y / sd, w.z / sd };
+      double angle = remaining, c = cos(angle), s = sin(angle);
+      while(d > angle) {
+        resampled.push_back(to_ll({ c * a.x + s * w.x, c * a.y + s * w.y, c * a.z + s * w.z }));
+        double next = c * cr - s * sr;
+        s = s * cr + c * sr;
+        c = next;
+        angle += resolution;
+      }
+      remaining = angle;
     }
     //we're going to the next point so consume whatever's left
     remaining -= d;
-    last = *p;
   }
 
   //TODO: do we want to let them know remaining?
@@ -3,9 +3,11 @@
 #include "test.h"
 
 #include <vector>
+#include <algorithm>
 
 #include "valhalla/midgard/point2.h"
 #include "valhalla/midgard/vector2.h"
+#include "valhalla/midgard/util.h"
 
 using namespace std;
 using namespace valhalla::midgard;
@@ -212,6 +214,137 @@ void TestIntersect() {
     throw std::logic_error("Wrong intersection");
 }
 
+// Sutherland-Hodgman one edge at a time, the way Clip used to work
+std::vector<Point2> ReferenceClip(const AABB2<Point2>& box, std::vector<Point2> pts, const bool closed) {
+  auto add = [](const Point2& p, std::vector<Point2>& out) {
+    if (out.empty() || out.back() != p)
+      out.push_back(p);
+  };
+  for (int edge = 0; edge < 4; ++edge) {
+    auto inside = [&](const Point2& p) {
+      return edge == 0 ? p.x() > box.minx() : edge == 1 ? p.x() < box.maxx() :
+             edge == 2 ? p.y() > box.miny() : p.y() < box.maxy();
+    };
+    auto intersection = [&](const Point2& in, const Point2& out) {
+      float dx = out.x() - in.x(), dy = out.y() - in.y();
+      float t = edge == 0 ? (box.minx() - in.x()) / dx : edge == 1 ? (box.maxx() - in.x()) / dx :
+                edge == 2 ? (box.miny() - in.y()) / dy : (box.maxy() - in.y()) / dy;
+      return Point2(in.x() + t * dx, in.y() + t * dy);
+    };
+    std::vector<Point2> out;
+    uint32_t n = pts.size(), v1 = closed ? n - 1 : 0;
+    for (uint32_t v2 = 0; v2 < n; v1 = v2, v2++) {
+      bool v1in = inside(pts[v1]), v2in = inside(pts[v2]);
+      if (v1in && v2in) {
+        add(pts[v2], out);
+      } else if (!v1in && v2in) {
+        add(intersection(pts[v2], pts[v1]), out);
+        add(pts[v2], out);
+      } else if (v1in && !v2in) {
+        add(intersection(pts[v1], pts[v2]), out);
+      }
+    }
+    if (out.empty())
+      return out;
+    pts = out;
+  }
+  return pts;
+}
+
+// Same ring, possibly starting at a different vertex
+bool SameRing(std::vector<Point2> a, std::vector<Point2> b) {
+  if (a.size() > 1 && a.front() == a.back())
+    a.pop_back();
+  if (b.size() > 1 && b.front() == b.back())
+    b.pop_back();
+  if (a.size() != b.size())
+    return false;
+  for (size_t r = 0; r < a.size() || r == 0; ++r) {
+    if (std::equal(a.begin(), a.end() - r, b.begin() + r) && std::equal(a.end() - r, a.end(), b.begin()))
+      return true;
+  }
+  return a.empty();
+}
+
+void TestClip() {
+  AABB2<Point2> box(-1.f, -1.f, 1.f, 1.f);
+  std::vector<Point2> scratch;
+  for (int i = 0; i < 500; ++i) {
+    std::vector<Point2> pts;
+    size_t count = 1 + i % 20;
+    for (size_t k = 0; k < count; ++k)
+      pts.emplace_back((rand01() - .5f) * 4.f, (rand01() - .5f) * 4.f);
+    if (i % 3 == 0)
+      pts.push_back(pts.back());
+
+    // Polylines are exactly the same as clipping one edge at a time
+    auto clipped = pts;
+    if (box.Clip(clipped, false, scratch) != clipped.size() || clipped != ReferenceClip(box, pts, false))
+      throw std::logic_error("Clipped polyline does not match");
+    if (scratch != pts)
+      throw std::logic_error("Scratch should hold the input");
+    auto legacy = pts;
+    box.Clip(legacy, false);
+    if (legacy != clipped)
+      throw std::logic_error("Clip should match Clip with scratch");
+
+    // Polygons may start at another vertex
+    clipped = pts;
+    box.Clip(clipped, true, scratch);
+    if (!SameRing(clipped, ReferenceClip(box, pts, true)))
+      throw std::logic_error("Clipped polygon does not match");
+  }
+
+  // A triangle poking out of the box gets the box corner
+  std::vector<Point2> triangle = { { 0.f, 0.f }, { 3.f, 0.f }, { 0.f, 3.f } };
+  box.Clip(triangle, true, scratch);
+  if (!SameRing(triangle, { { 0.f, 0.f }, { 1.f, 0.f }, { 1.f, 1.f }, { 0.f, 1.f } }))
+    throw std::logic_error("Clipped triangle is wrong");
+}
+
+void TestClipParts() {
+  AABB2<Point2> box(0.f, 0.f, 10.f, 10.f);
+  std::vector<Point2> parts;
+  std::vector<uint32_t> offsets;
+
+  // In, out over the top and back in, then along the bottom edge
+  std::vector<Point2> pts = { { 2.f, 5.f }, { 2.f, 15.f }, { 8.f, 15.f }, { 8.f, 5.f },
+                              { 12.f, 0.f }, { 15.f, 0.f } };
+  if (box.ClipParts(pts, parts, offsets) != 2)
+    throw std::logic_error("Polyline should be clipped into 2 parts");
+  std::vector<Point2> expected = { { 2.f, 5.f }, { 2.f, 10.f }, { 8.f, 10.f }, { 8.f, 5.f },
+                                   { 10.f, 2.5f } };
+  if (parts != expected || offsets != std::vector<uint32_t>{ 0, 2, 5 })
+    throw std::logic_error("Parts are wrong");
+
+  // Touching a corner isn't a part, running along an edge is
+  if (box.ClipParts({ { -1.f, 1.f }, { 1.f, -1.f } }, parts, offsets) != 0 || offsets.size() != 1)
+    throw std::logic_error("Touching the corner should not make a part");
+  if (box.ClipParts({ { -5.f, 0.f }, { 15.f, 0.f } }, parts, offsets) != 1 ||
+      parts != std::vector<Point2>{ { 0.f, 0.f }, { 10.f, 0.f } })
+    throw std::logic_error("Running along the edge should make a part");
+  if (box.ClipParts({ { 5.f, 5.f } }, parts, offsets) != 0 || !parts.empty())
+    throw std::logic_error("A point is not a part");
+
+  // Every part is inside, has a length and parts don't share points
+  for (int i = 0; i < 200; ++i) {
+    std::vector<Point2> walk;
+    for (int k = 0; k < 30; ++k)
+      walk.emplace_back(rand01() * 20.f - 5.f, rand01() * 20.f - 5.f);
+    uint32_t n = box.ClipParts(walk, parts, offsets);
+    if (offsets.size() != n + 1 || offsets.back() != parts.size())
+      throw std::logic_error("Offsets should end with the number of points");
+    for (uint32_t p = 0; p < n; ++p) {
+      if (offsets[p + 1] - offsets[p] < 2)
+        throw std::logic_error("Parts should have at least 2 points");
+    }
+    for (const auto& pt : parts) {
+      if (pt.x() < -1e-4f || pt.x() > 10.0001f || pt.y() < -1e-4f || pt.y() > 10.0001f)
+        throw std::logic_error("Part is outside the box");
+    }
+  }
+}
+
 }
 
 int main() {
@@ -238,6 +371,10 @@ int main() {
   //Test minimum and maximum point constructor.
   suite.test(TEST_CASE(TestPtConstructor));
 
+  // Test clipping polylines and polygons
+  suite.test(TEST_CASE(TestClip));
+  suite.test(TEST_CASE(TestClipParts));
+
   //Test minimum and maximum values.
   suite.test(TEST_CASE(TestMinMaxValues));
 
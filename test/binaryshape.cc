@@ -0,0 +1,138 @@
+#include "test.h"
+#include "valhalla/midgard/binaryshape.h"
+#include "valhalla/midgard/pointll.h"
+#include "valhalla/midgard/util.h"
+
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <cmath>
+
+using namespace std;
+using namespace valhalla::midgard;
+
+namespace {
+
+// A random walk with some repeated vertices
+std::vector<PointLL> walk(size_t count) {
+  std::vector<PointLL> pts;
+  PointLL p(-76.5f, 40.5f);
+  for (size_t i = 0; i < count; ++i) {
+    if (i % 7 != 3)
+      p = PointLL(p.lng() + (rand01() - 0.5f) * 1e-2f, p.lat() + (rand01() - 0.5f) * 1e-2f);
+    pts.push_back(p);
+  }
+  return pts;
+}
+
+// An arc densified at a steady spacing, like a resampled road
+std::vector<PointLL> arc(size_t count) {
+  std::vector<PointLL> pts;
+  for (size_t i = 0; i < count; ++i) {
+    double angle = i * 0.001;
+    pts.emplace_back(-76.5 + 0.1 * std::cos(angle), 40.5 + 0.1 * std::sin(angle));
+  }
+  return pts;
+}
+
+void TestRoundTrip() {
+  for (int precision : {5, 6, 7}) {
+    for (bool second_order : {false, true}) {
+      for (size_t count : {0, 1, 2, 137}) {
+        auto points = walk(count);
+        auto bytes = encode_binary(points, precision, second_order);
+        auto expected = decode<std::vector<PointLL> >(encode(points, precision), precision);
+        if (decode_binary<std::vector<PointLL> >(bytes) != expected)
+          throw runtime_error("Binary shape should decode to the same points as the text");
+      }
+    }
+  }
+
+  // Points more than half the world apart wrap around with 7 digits
+  std::vector<std::pair<double, double> > far = {{-179.9999999, -89.9999999}, {179.9999999, 89.9999999},
+                                                {-179.9999999, 0}, {0, 0}};
+  for (bool second_order : {false, true}) {
+    auto bytes = encode_binary(far, 7, second_order);
+    auto decoded = decode_binary<std::vector<std::pair<double, double> > >(bytes);
+    auto expected = decode<std::vector<std::pair<double, double> > >(encode(far, 7), 7);
+    if (decoded != expected)
+      throw runtime_error("Points far apart should round trip");
+  }
+}
+
+void TestSize() {
+  auto points = walk(500);
+  auto text = encode(points);
+  auto bytes = encode_binary(points);
+  if (bytes.size() * 4 > text.size() * 3)
+    throw runtime_error("Binary shape should be a quarter smaller than the text: " +
+                        std::to_string(bytes.size()) + " vs " + std::to_string(text.size()));
+
+  auto curve = arc(500);
+  auto first = encode_binary(curve, 6, false), second = encode_binary(curve, 6, true);
+  if (second.size() >= first.size())
+    throw runtime_error("Second order offsets should be smaller on a smooth curve: " +
+                        std::to_string(second.size()) + " vs " + std::to_string(first.size()));
+}
+
+void TestConversion() {
+  for (bool second_order : {false, true}) {
+    for (size_t count : {0, 1, 500}) {
+      auto encoded = encode(walk(count));
+      auto bytes = encoded_to_binary(encoded, kPolylinePrecision, second_order);
+      if (decode_binary<std::vector<PointLL> >(bytes) != decode<std::vector<PointLL> >(encoded))
+        throw runtime_error("Converting should keep the points");
+      if (binary_to_encoded(bytes) != encoded)
+        throw runtime_error("Converting back should give the same text");
+    }
+  }
+
+  // The precision travels with the shape
+  auto encoded = encode(arc(100), 5);
+  if (binary_to_encoded(encoded_to_binary(encoded, 5, true)) != encoded)
+    throw runtime_error("Converting back with 5 digits should give the same text");
+}
+
+void TestInvalid() {
+  auto bytes = encode_binary(walk(20));
+  std::vector<std::string> invalid = {
+    "",                                   // no header
+    std::string(1, '\x26') + bytes.substr(1),  // unknown flag bit
+    std::string(1, '\x09') + bytes.substr(1),  // no such precision
+    bytes.substr(0, bytes.size() - 1),    // truncated
+    bytes + std::string(1, '\0'),         // bytes past the last point
+    std::string("\x06\x01\xff\xff\xff\xff\xff\xff\x01\x00\x00", 11),  // number too long
+    std::string("\x06\x7f\x00\x00", 4),   // more points than bytes
+  };
+  for (const auto& b : invalid) {
+    bool threw = false;
+    try { decode_binary<std::vector<PointLL> >(b); } catch (const std::runtime_error&) { threw = true; }
+    if (!threw)
+      throw runtime_error("Invalid binary shape should throw");
+    threw = false;
+    try { binary_to_encoded(b); } catch (const std::runtime_error&) { threw = true; }
+    if (!threw)
+      throw runtime_error("Converting an invalid binary shape should throw");
+  }
+
+  bool threw = false;
+  try { encoded_to_binary("gq`kkAny~opCvQns"); } catch (const std::runtime_error&) { threw = true; }
+  if (!threw)
+    throw runtime_error("Converting a truncated polyline should throw");
+}
+
+}
+
+int main() {
+  test::suite suite("binaryshape");
+
+  suite.test(TEST_CASE(TestRoundTrip));
+
+  suite.test(TEST_CASE(TestSize));
+
+  suite.test(TEST_CASE(TestConversion));
+
+  suite.test(TEST_CASE(TestInvalid));
+
+  return suite.tear_down();
+}
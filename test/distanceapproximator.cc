@@ -2,8 +2,11 @@
 
 #include "valhalla/midgard/constants.h"
 #include "valhalla/midgard/pointll.h"
+#include "valhalla/midgard/util.h"
 #include "test.h"
 
+#include <cmath>
+
 using namespace std;
 using namespace valhalla::midgard;
 
@@ -48,6 +51,41 @@ void TestDistanceSquared() {
   TryDistanceSquaredFromTestPt(a, b, a.Distance(b));
 }
 
+void TestMetersPerLngDegreeError() {
+  // Within 2e-7 of the cosine over all latitudes, 2 cm per degree
+  for (float lat = -90.f; lat <= 90.f; lat += 0.01f) {
+    double expected = cos(lat * M_PI / 180.0) * kMetersPerDegreeLat;
+    if (fabs(DistanceApproximator::MetersPerLngDegree(lat) - expected) > 2e-7 * kMetersPerDegreeLat)
+      throw runtime_error("MetersPerLngDegree is off by more than its error bound");
+  }
+  if (DistanceApproximator::MetersPerLngDegree(0.f) != kMetersPerDegreeLat)
+    throw runtime_error("MetersPerLngDegree should be exact at the equator");
+
+  // Latitudes outside of the poles are clamped rather than left to the series
+  for (float lat : { 90.5f, -135.f, 1e6f, -1e30f, NAN, INFINITY }) {
+    float m = DistanceApproximator::MetersPerLngDegree(lat);
+    if (!(fabs(m) < 1.f))
+      throw runtime_error("MetersPerLngDegree past the poles should be about 0, got " + std::to_string(m));
+  }
+}
+
+void TestDistanceSquaredBatch() {
+  // Every size up to a few vector widths gives the same as one at a time
+  DistanceApproximator approx(PointLL(-76.5f, 40.5f));
+  std::vector<float> d2(3, -1.f);
+  for (size_t count = 0; count < 40; ++count) {
+    std::vector<PointLL> pts;
+    for (size_t i = 0; i < count; ++i)
+      pts.emplace_back(-76.5f + (rand01() - 0.5f) * .1f, 40.5f + (rand01() - 0.5f) * .1f);
+    approx.DistanceSquared(pts, d2);
+    if (d2.size() != count)
+      throw runtime_error("Expected a squared distance per point");
+    for (size_t i = 0; i < count; ++i)
+      if (d2[i] != approx.DistanceSquared(pts[i]))
+        throw runtime_error("Batch DistanceSquared does not match DistanceSquared");
+  }
+}
+
 }
 
 int main() {
@@ -62,5 +100,11 @@ int main() {
   // Test distance squared between 2 points
   suite.test(TEST_CASE(TestDistanceSquared));
 
+  // Error of the cosine polynomial
+  suite.test(TEST_CASE(TestMetersPerLngDegreeError));
+
+  // Test distance squared of many points at once
+  suite.test(TEST_CASE(TestDistanceSquaredBatch));
+
   return suite.tear_down();
 }
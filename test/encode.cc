@@ -1,8 +1,14 @@
 #include "valhalla/midgard/util.h"
 #include "valhalla/midgard/pointll.h"
+#include "valhalla/midgard/point2.h"
 #include "test.h"
 
 #include <string>
+#include <vector>
+#include <deque>
+#include <iterator>
+#include <algorithm>
+#include <cmath>
 
 using namespace std;
 using namespace valhalla::midgard;
@@ -85,6 +91,227 @@ void TestSimple() {
   do_pair({{-9.42372, 152.03805}, {-1.82375, 116.05687}, {-71.41203, -66.66489}, {65.64729, 68.17239}, {34.2284, -77.90916}, {-72.90402, -47.25247}, {-78.55439, -25.28158}, {-31.92992, 103.20477}, {58.26482, -169.02219}}, "cit~`Hnud~PvvbscAcuznM~lmo{InrivcC_ayd`Go~lldGzobsuGr_t|z@cjcny@f_zikEs{~{h@b{zwI{{datFklv|wA~glffOgr``kD");
 }
 
+//what encode and decode did a byte at a time, the kernels have to match it
+std::string reference_encode(const container_t& points) {
+  std::string output;
+  auto serialize = [&output](long long number) {
+    number = number < 0 ? ~(number * 2) : number * 2;
+    while (number >= 0x20) {
+      output.push_back(static_cast<char>((0x20 | (number & 0x1f)) + 63));
+      number >>= 5;
+    }
+    output.push_back(static_cast<char>(number + 63));
+  };
+  long long last_lon = 0, last_lat = 0;
+  for (const auto& p : points) {
+    long long lon = static_cast<long long>(floor(p.first * 1e6));
+    long long lat = static_cast<long long>(floor(p.second * 1e6));
+    serialize(lat - last_lat);
+    serialize(lon - last_lon);
+    last_lon = lon;
+    last_lat = lat;
+  }
+  return output;
+}
+
+container_t reference_decode(const std::string& encoded) {
+  container_t output;
+  size_t i = 0;
+  auto deserialize = [&encoded, &i](const long long previous) {
+    long long byte, shift = 0, result = 0;
+    do {
+      byte = static_cast<long long>(encoded[i++]) - 63;
+      result |= (byte & 0x1f) << shift;
+      shift += 5;
+    } while (byte >= 0x20);
+    return previous + (result & 1 ? ~(result >> 1) : (result >> 1));
+  };
+  long long last_lon = 0, last_lat = 0;
+  while (i < encoded.size()) {
+    last_lat = deserialize(last_lat);
+    last_lon = deserialize(last_lon);
+    output.emplace_back(last_lon * 1e-6, last_lat * 1e-6);
+  }
+  return output;
+}
+
+void TestKernelsMatchReference() {
+  //steps from a micro degree to 1200 degrees so numbers take 1 to 7 bytes,
+  //and lengths that leave every size of tail
+  for (double step : {1e-6, 1e-4, 1e-2, 1.0, 100.0, 1200.0}) {
+    for (size_t count : {0, 1, 2, 3, 5, 8, 13, 100, 1001}) {
+      container_t points;
+      for (size_t i = 0; i < count; ++i)
+        points.emplace_back((rand01() - 0.5) * step, (rand01() - 0.5) * step);
+      auto encoded = encode(points);
+      if (encoded != reference_encode(points))
+        throw std::runtime_error("Encoding should match the reference byte for byte");
+      auto decoded = decode<container_t>(encoded), expected = reference_decode(encoded);
+      if (decoded.size() != expected.size())
+        throw std::runtime_error("Decoding should match the reference");
+      for (size_t i = 0; i < decoded.size(); ++i)
+        if (decoded[i] != expected[i])
+          throw std::runtime_error("Decoding should match the reference");
+    }
+  }
+}
+
+void TestPrecision() {
+  //the example from Google's documentation of the encoding, 5 digits
+  container_t points{{-120.2, 38.5}, {-120.95, 40.7}, {-126.453, 43.252}};
+  auto encoded = encode(points, 5);
+  if(encoded != "_p~iF~ps|U_ulLnnqC_mqNvxq`@")
+    throw std::runtime_error("Expected: _p~iF~ps|U_ulLnnqC_mqNvxq`@ but got: " + encoded);
+  if(!appx_equal(decode<container_t>(encoded, 5), points))
+    throw std::runtime_error("Decoding with 5 digits failed");
+
+  //7 digits across the antimeridian, the offsets wrap around 32 bits
+  points = {{-179.9876543, -89.1234567}, {179.9876543, 89.1234567}, {-179.5, 0.0}};
+  auto decoded = decode<container_t>(encode(points, 7), 7);
+  for(size_t i = 0; i < points.size(); ++i)
+    if(std::abs(decoded[i].first - points[i].first) > 1e-7 || std::abs(decoded[i].second - points[i].second) > 1e-7)
+      throw std::runtime_error("Decoding with 7 digits failed");
+
+  bool threw = false;
+  try { encode(points, 8); } catch (const std::runtime_error&) { threw = true; }
+  if(!threw)
+    throw std::runtime_error("8 digits do not fit in 32 bits and should throw");
+}
+
+void TestGenericOutput() {
+  std::vector<PointLL> shape;
+  for(int i = 0; i < 300; ++i)
+    shape.emplace_back(-76.3f + i * .0013f, 40.04f - i * .0007f);
+  auto encoded = encode(shape);
+
+  //encode from any range into any output iterator
+  std::deque<PointLL> points(shape.begin(), shape.end());
+  std::vector<char> chars;
+  encode_into(points.begin(), points.end(), std::back_inserter(chars));
+  if(std::string(chars.begin(), chars.end()) != encoded || encode(points) != encoded)
+    throw std::runtime_error("Encoding into an output iterator failed");
+
+  //decode into any output iterator, containers without reserve and other point types
+  auto expected = decode<std::vector<PointLL> >(encoded);
+  std::deque<PointLL> decoded;
+  decode_into(encoded, std::back_inserter(decoded));
+  if(!std::equal(expected.begin(), expected.end(), decoded.begin()) || decoded.size() != expected.size())
+    throw std::runtime_error("Decoding into an output iterator failed");
+  auto pairs = decode<std::deque<std::pair<float, float> > >(encoded);
+  std::vector<Point2> planar;
+  decode_into<Point2>(encoded, std::back_inserter(planar));
+  for(size_t i = 0; i < expected.size(); ++i)
+    if(pairs[i].first != expected[i].lng() || planar[i].second != expected[i].lat())
+      throw std::runtime_error("Decoding into other point types failed");
+
+  //or into a function
+  size_t count = 0;
+  decode_each(encoded, [&count, &expected](const double lng, const double lat) {
+    if(static_cast<float>(lng) != expected[count].lng() || static_cast<float>(lat) != expected[count].lat())
+      throw std::runtime_error("Decoding into a function failed");
+    ++count;
+  });
+  if(count != expected.size())
+    throw std::runtime_error("Decoding into a function failed");
+}
+
+void TestDecodedSize() {
+  if(decoded_size("") != 0)
+    throw std::runtime_error("An empty string has no points");
+  std::string encoded = "gq`kkAny~opCvQnsE";
+  if(decoded_size(encoded) != 2)
+    throw std::runtime_error("Wrong number of points counted");
+  //every string a valid polyline fits in half its length
+  std::vector<PointLL> points{{-76.3002f, 40.0433f}, {-76.3036f, 40.043f}, {-76.3036f, 40.043f}, {0.f, 0.f}};
+  encoded = encode(points);
+  if(decoded_size(encoded) != points.size() || decoded_size(encoded) > encoded.size() / 2)
+    throw std::runtime_error("Wrong number of points counted");
+}
+
+void TestDecodeInvalid() {
+  //a character outside the alphabet, a truncated number, a lone latitude and
+  //numbers too long, on their own and in the middle of long strings
+  std::vector<PointLL> shape;
+  for(int i = 0; i < 100; ++i)
+    shape.emplace_back(-76.3f + i * .0013f, 40.04f - i * .0007f);
+  auto valid = encode(shape);
+  for(const auto& invalid : {std::string("gq`kkAny~op Cvq"), std::string("gq`kkAny~opCvQns"),
+                             std::string("gq`kkAny~opCvQ"), std::string("~~~~~~~~??"),
+                             std::string("~~~~~~~??"), valid + "~~~~~~~??" + valid,
+                             valid.substr(0, 80) + "~~~~~~~??" + valid, valid + "~~~~~~~??",
+                             std::string("~~~~~~^?"), std::string("~~~~~~C?")}) {
+    std::vector<PointLL> points;
+    bool threw = false;
+    try { decode(invalid, points); } catch (const std::runtime_error&) { threw = true; }
+    if(!threw)
+      throw std::runtime_error("Decoding " + invalid + " should have thrown");
+    threw = false;
+    try { decode<std::vector<PointLL> >(invalid); } catch (const std::runtime_error&) { threw = true; }
+    if(!threw)
+      throw std::runtime_error("Decoding " + invalid + " into a new vector should have thrown");
+    threw = false;
+    try { decoded_size(invalid); } catch (const std::runtime_error&) { threw = true; }
+    if(!threw)
+      throw std::runtime_error("Counting " + invalid + " should have thrown");
+  }
+
+  //7 chunks hold 35 bits, the last can only have the 2 left of 32. the
+  //largest one is -2^31 and not a number that got its high bits cut off
+  for(size_t k = 0; k < 32; ++k) {
+    auto pad = std::string(k, '?');
+    auto after = std::string(k % 2 == 0 ? "?" : "") + valid;
+    bool threw = false;
+    try { decoded_size(pad + "~~~~~~^" + after); } catch (const std::runtime_error&) { threw = true; }
+    if(!threw)
+      throw std::runtime_error("A 7th chunk over 3 should have thrown");
+    auto points = decode<std::vector<PointLL> >(pad + "~~~~~~B" + after);
+    if(points[k / 2] != PointLL(k % 2 == 0 ? 0.f : -2147.483648f, k % 2 == 0 ? -2147.483648f : 0.f))
+      throw std::runtime_error("A 7th chunk of 3 should decode to -2^31");
+  }
+}
+
+void TestDecodeIntoBuffers() {
+  std::vector<PointLL> shape;
+  for(int i = 0; i < 200; ++i)
+    shape.emplace_back(-76.3f + i * .0013f, 40.04f - i * .0007f);
+  auto encoded = encode(shape);
+  auto expected = decode<std::vector<PointLL> >(encoded);
+
+  //into a vector that keeps its memory
+  std::vector<PointLL> points(1000);
+  const PointLL* data = points.data();
+  decode(encoded, points);
+  if(points != expected || points.data() != data)
+    throw std::runtime_error("Decoding into a vector should reuse its memory");
+  decode("gq`kkAny~opCvQnsE", points);
+  if(points.size() != 2 || points.data() != data)
+    throw std::runtime_error("Decoding into a vector should replace its contents");
+
+  //into a buffer of points
+  std::vector<PointLL> buffer(encoded.size() / 2);
+  if(decode(encoded, buffer.data(), buffer.size()) != expected.size() ||
+     !std::equal(expected.begin(), expected.end(), buffer.begin()))
+    throw std::runtime_error("Decoding into a buffer of points failed");
+
+  //into longitude and latitude buffers
+  std::vector<float> lngs(expected.size()), lats(expected.size());
+  if(decode(encoded, lngs.data(), lats.data(), expected.size()) != expected.size())
+    throw std::runtime_error("Decoding into longitude and latitude buffers failed");
+  for(size_t i = 0; i < expected.size(); ++i)
+    if(lngs[i] != expected[i].lng() || lats[i] != expected[i].lat())
+      throw std::runtime_error("Decoding into longitude and latitude buffers failed");
+
+  //buffers too small
+  bool threw = false;
+  try { decode(encoded, buffer.data(), expected.size() - 1); } catch (const std::runtime_error&) { threw = true; }
+  if(!threw)
+    throw std::runtime_error("Decoding into a buffer that is too small should throw");
+  threw = false;
+  try { decode(encoded, lngs.data(), lats.data(), 10); } catch (const std::runtime_error&) { threw = true; }
+  if(!threw)
+    throw std::runtime_error("Decoding into buffers that are too small should throw");
+}
+
 }
 
 int main() {
@@ -93,5 +320,17 @@ int main() {
   // Test kilometer per degree longitude at a specified latitude
   suite.test(TEST_CASE(TestSimple));
 
+  suite.test(TEST_CASE(TestKernelsMatchReference));
+
+  suite.test(TEST_CASE(TestPrecision));
+
+  suite.test(TEST_CASE(TestGenericOutput));
+
+  suite.test(TEST_CASE(TestDecodedSize));
+
+  suite.test(TEST_CASE(TestDecodeInvalid));
+
+  suite.test(TEST_CASE(TestDecodeIntoBuffers));
+
   return suite.tear_down();
 }
@@ -0,0 +1,121 @@
+#include "test.h"
+#include "valhalla/midgard/encodedpolyline.h"
+#include "valhalla/midgard/aabb2.h"
+#include "valhalla/midgard/pointll.h"
+#include "valhalla/midgard/util.h"
+
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+
+using namespace std;
+using namespace valhalla::midgard;
+
+namespace {
+
+// A random walk with some repeated vertices
+std::vector<PointLL> walk(size_t count) {
+  std::vector<PointLL> pts;
+  PointLL p(-76.5f, 40.5f);
+  for (size_t i = 0; i < count; ++i) {
+    if (i % 7 != 3)
+      p = PointLL(p.lng() + (rand01() - 0.5f) * 1e-2f, p.lat() + (rand01() - 0.5f) * 1e-2f);
+    pts.push_back(p);
+  }
+  return pts;
+}
+
+void TestIterate() {
+  for (size_t count : {0, 1, 2, 137}) {
+    auto encoded = encode(walk(count));
+    auto expected = decode<std::vector<PointLL> >(encoded);
+    EncodedPolyline polyline(encoded);
+    if (polyline.size() != expected.size() || polyline.empty() != expected.empty())
+      throw runtime_error("Wrong number of points");
+    std::vector<PointLL> points(polyline.begin(), polyline.end());
+    if (points != expected)
+      throw runtime_error("Iterating should give the decoded points");
+    size_t i = 0;
+    for (const auto& p : polyline)
+      if (!(p == expected[i++]))
+        throw runtime_error("Iterating should give the decoded points");
+  }
+}
+
+void TestHelpers() {
+  auto encoded = encode(walk(500));
+  auto expected = decode<std::vector<PointLL> >(encoded);
+  EncodedPolyline polyline(encoded);
+  if (!(polyline.front() == expected.front()) || !(polyline.back() == expected.back()))
+    throw runtime_error("Wrong first or last point");
+  for (size_t i : {0, 1, 250, 499})
+    if (!(polyline.at(i) == expected[i]))
+      throw runtime_error("Wrong point at index " + std::to_string(i));
+  bool threw = false;
+  try { polyline.at(500); } catch (const std::out_of_range&) { threw = true; }
+  if (!threw)
+    throw runtime_error("A point past the end should throw");
+
+  AABB2<PointLL> box(expected), fused = polyline.BoundingBox();
+  if (!(box.minpt() == fused.minpt()) || !(box.maxpt() == fused.maxpt()))
+    throw runtime_error("Wrong bounding box");
+  if (polyline.Length() != length(expected))
+    throw runtime_error("Wrong length");
+
+  // Part of a larger buffer
+  std::string padded = "xx" + encoded + "yy";
+  EncodedPolyline part(padded.data() + 2, encoded.size());
+  if (part.size() != expected.size() || !(part.back() == expected.back()))
+    throw runtime_error("Wrong points from part of a buffer");
+
+  std::string empty;
+  EncodedPolyline none(empty);
+  if (!none.empty() || none.begin() != none.end() || none.Length() != 0.f)
+    throw runtime_error("An empty string has no points");
+}
+
+void TestPrecision() {
+  auto points = walk(50);
+  auto encoded = encode(points, 5);
+  auto expected = decode<std::vector<PointLL> >(encoded, 5);
+  EncodedPolyline polyline(encoded, 5);
+  if (!std::equal(expected.begin(), expected.end(), polyline.begin()) ||
+      !(polyline.back() == expected.back()))
+    throw runtime_error("Iterating with 5 digits should give the decoded points");
+}
+
+void TestInvalid() {
+  std::string truncated = "gq`kkAny~opCvQns";
+  bool threw = false;
+  try { EncodedPolyline polyline(truncated); } catch (const std::runtime_error&) { threw = true; }
+  if (!threw)
+    throw runtime_error("A truncated string should throw");
+
+  // Numbers of more than 7 chunks, alone and within longer strings so both
+  // the vectorized and the byte at a time checks see them
+  auto valid = encode(walk(100));
+  for (const auto& too_long : { std::string("~~~~~~~~??"), valid + "~~~~~~~~??",
+                                valid.substr(0, 30) + "~~~~~~~~??" + valid }) {
+    threw = false;
+    try { EncodedPolyline polyline(too_long); } catch (const std::runtime_error&) { threw = true; }
+    if (!threw)
+      throw runtime_error("A number that is too long should throw");
+  }
+}
+
+}
+
+int main() {
+  test::suite suite("encodedpolyline");
+
+  suite.test(TEST_CASE(TestIterate));
+
+  suite.test(TEST_CASE(TestHelpers));
+
+  suite.test(TEST_CASE(TestPrecision));
+
+  suite.test(TEST_CASE(TestInvalid));
+
+  return suite.tear_down();
+}
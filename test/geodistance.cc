@@ -0,0 +1,130 @@
+#include "midgard/geodistance.h"
+#include "midgard/pointll.h"
+#include "midgard/util.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "test.h"
+
+using namespace std;
+using namespace valhalla::midgard;
+
+namespace {
+
+void TryEllipsoidal(const PointLL& a, const PointLL& b, const double expected,
+                    const double tolerance) {
+  if (fabs(GeoDistance::Ellipsoidal(a, b) - expected) > tolerance ||
+      fabs(GeoDistance::Ellipsoidal(b, a) - expected) > tolerance)
+    throw logic_error("Ellipsoidal distance is wrong");
+}
+
+void TestEllipsoidal() {
+  // Quarter meridian and a degree of the equator of WGS84
+  TryEllipsoidal({ 0.f, 0.f }, { 0.f, 90.f }, 10001965.729, 1e-3);
+  TryEllipsoidal({ 0.f, 0.f }, { 1.f, 0.f }, 111319.491, 1e-3);
+  TryEllipsoidal({ 179.5f, 0.f }, { -179.5f, 0.f }, 111319.491, 1e-3);
+  // Vincenty's Flinders Peak to Buninyong, the float coordinates are only
+  // good to a few decimeters
+  TryEllipsoidal({ 144.424868f, -37.951033f }, { 143.926496f, -37.652821f }, 54972.271, 0.5);
+  TryEllipsoidal({ -76.5f, 40.5f }, { -76.5f, 40.5f }, 0.0, 0.0);
+
+  // Nearly antipodal points fall back to the sphere
+  double d = GeoDistance::Ellipsoidal({ 0.f, 0.f }, { 179.8f, 0.1f });
+  if (!(d > 19.9e6 && d < 20.1e6))
+    throw logic_error("Nearly antipodal points should fall back to the spherical distance");
+}
+
+void TestEnvelopes() {
+  // Every tier is within its error bound of the ellipsoid, from centimeters
+  // to thousands of kilometers and all the way to the poles
+  for (int i = 0; i < 50000; ++i) {
+    PointLL a((rand01() - 0.5f) * 360.f, (rand01() - 0.5f) * 180.f);
+    float length = powf(10.f, -7.f + 8.5f * rand01()), angle = rand01() * 6.2831853f;
+    PointLL b(a.lng() + length * cosf(angle),
+              std::max(-90.f, std::min(90.f, a.lat() + length * sinf(angle))));
+    double expected = GeoDistance::Ellipsoidal(a, b);
+    for (auto tier : { DistanceTier::kPlanar, DistanceTier::kSpherical }) {
+      double d = GeoDistance::Distance(a, b, tier);
+      if (fabs(d - expected) > GeoDistance::MaxError(a, b, tier, d) + 1e-3)
+        throw logic_error("Distance is outside the error envelope of its tier");
+    }
+  }
+
+  // The spherical tier is the distance PointLL::Distance computes
+  PointLL a(-76.5f, 40.5f), b(-76.2f, 40.8f);
+  if (fabs(GeoDistance::Spherical(a, b) - a.Distance(b)) > 1.0)
+    throw logic_error("Spherical should be on the sphere of PointLL::Distance");
+}
+
+void TryDistance(const PointLL& a, const PointLL& b, const double tolerance,
+                 const DistanceTier expected) {
+  DistanceTier tier;
+  double d = GeoDistance::Distance(a, b, tolerance, &tier);
+  if (tier != expected)
+    throw logic_error("Wrong tier picked for the tolerance");
+  if (d != GeoDistance::Distance(a, b, tier))
+    throw logic_error("Distance should be that of the tier picked");
+  if (fabs(d - GeoDistance::Ellipsoidal(a, b)) > tolerance)
+    throw logic_error("Distance is not within the tolerance");
+}
+
+void TestDistance() {
+  // A 100 m segment is planar even to a millimeter
+  PointLL a(-76.5f, 40.5f), b(-76.5f, 40.5009f);
+  TryDistance(a, b, 1.0, DistanceTier::kPlanar);
+  TryDistance(a, b, 1e-3, DistanceTier::kPlanar);
+  TryDistance(a, b, 1e-5, DistanceTier::kEllipsoidal);
+
+  // Across a continent the flat earth is off by a hundred kilometers
+  PointLL c(-100.f, 30.f), d(-75.f, 45.f);
+  TryDistance(c, d, 2e5, DistanceTier::kPlanar);
+  TryDistance(c, d, 5e4, DistanceTier::kSpherical);
+  TryDistance(c, d, 10.0, DistanceTier::kEllipsoidal);
+
+  // Across the antimeridian
+  TryDistance({ 179.9995f, 0.f }, { -179.9995f, 0.f }, 1.0, DistanceTier::kPlanar);
+}
+
+void TestAntipodal() {
+  // Antipodes are half a meridian apart, so points near the antipode of a
+  // are within the distance to the antipode of that. The tier picked has to
+  // claim a bound that covers all of it, Vincenty fails for many of them
+  const double half_meridian = 20003931.4586;
+  for (int i = 0; i < 2000; ++i) {
+    PointLL a((rand01() - 0.5f) * 360.f, (rand01() - 0.5f) * 180.f);
+    PointLL antipode(a.lng() > 0.f ? a.lng() - 180.f : a.lng() + 180.f, -a.lat());
+    PointLL b(antipode.lng() + rand01() - 0.5f,
+              std::max(-90.f, std::min(90.f, antipode.lat() + rand01() - 0.5f)));
+    double off = GeoDistance::Ellipsoidal(b, antipode);
+    DistanceTier tier;
+    double d = GeoDistance::Distance(a, b, 1.0, &tier);
+    double error = GeoDistance::MaxError(a, b, tier, d);
+    if (tier == DistanceTier::kEllipsoidal ? fabs(d - half_meridian) > off + 1e-3
+                                           : fabs(d - half_meridian) + off > error)
+      throw logic_error("Nearly antipodal distance is outside the error bound it claims");
+    double ellipsoidal = GeoDistance::Ellipsoidal(a, b);
+    if (d != GeoDistance::Distance(a, b, tier) ||
+        GeoDistance::MaxError(a, b, DistanceTier::kEllipsoidal, ellipsoidal) != error)
+      throw logic_error("Nearly antipodal points should get the tier and bound actually used");
+  }
+
+  // Vincenty fails here, the spherical distance is all there is
+  DistanceTier tier;
+  GeoDistance::Distance({ 0.f, 0.f }, { 179.8f, 0.1f }, 1.0, &tier);
+  if (tier != DistanceTier::kSpherical)
+    throw logic_error("Nearly antipodal points should be reported as spherical");
+}
+
+}
+
+int main() {
+  test::suite suite("geodistance");
+
+  suite.test(TEST_CASE(TestEllipsoidal));
+  suite.test(TEST_CASE(TestEnvelopes));
+  suite.test(TEST_CASE(TestDistance));
+  suite.test(TEST_CASE(TestAntipodal));
+
+  return suite.tear_down();
+}
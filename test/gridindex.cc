@@ -0,0 +1,119 @@
+#include "test.h"
+#include "valhalla/midgard/gridindex.h"
+#include "valhalla/midgard/aabb2.h"
+#include "valhalla/midgard/point2.h"
+#include "valhalla/midgard/pointll.h"
+
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+using namespace valhalla::midgard;
+
+namespace {
+
+using index_t = GridIndex<Point2, uint32_t>;
+
+// 10x10 tiles of size 1 with 4x4 subdivisions each
+index_t build() {
+  index_t index(Tiles<Point2>(AABB2<Point2>(Point2(0, 0), Point2(10, 10)), 1, 4));
+  index.Add(0, std::vector<Point2>{ {0.1f, 0.1f}, {9.9f, 0.1f} });
+  index.Add(1, std::vector<Point2>{ {5.1f, 5.1f}, {5.2f, 5.2f} });
+  index.Add(2, std::vector<Point2>{ {0.1f, 9.9f}, {9.9f, 0.1f} });
+  index.Add(3, std::vector<Point2>{ {8.6f, 8.6f}, {8.7f, 8.6f} });
+  index.Build();
+  return index;
+}
+
+void TestCell() {
+  auto index = build();
+  auto tileid = index.tiles().TileId(Point2(5.15f, 5.15f));
+  auto cell = index.Cell(tileid, 0);
+  if (cell.size() != 1 || *cell.begin() != 1)
+    throw runtime_error("Expected payload 1 in the cell");
+  if (index.Cell(tileid, 15).size() != 0)
+    throw runtime_error("Expected an empty cell");
+}
+
+void TestBoundingBox() {
+  auto index = build();
+  auto result = index.Query(AABB2<Point2>(Point2(4.9f, 4.9f), Point2(5.3f, 5.3f)));
+  if (result != std::vector<uint32_t>{ 1, 2 })
+    throw runtime_error("Unexpected bounding box query result");
+  result = index.Query(AABB2<Point2>(Point2(-1, -1), Point2(11, 11)));
+  if (result != std::vector<uint32_t>{ 0, 1, 2, 3 })
+    throw runtime_error("Everything should be in a bounding box covering the index");
+  if (!index.Query(AABB2<Point2>(Point2(20, 20), Point2(30, 30))).empty())
+    throw runtime_error("A bounding box outside of the index should be empty");
+}
+
+void TestRadius() {
+  auto index = build();
+  auto result = index.Query(Point2(8.65f, 8.65f), 0.1f);
+  if (result != std::vector<uint32_t>{ 3 })
+    throw runtime_error("Unexpected radius query result");
+  result = index.Query(Point2(5.15f, 0.5f), 0.5f);
+  if (result != std::vector<uint32_t>{ 0 })
+    throw runtime_error("Unexpected radius query result");
+}
+
+void TestIncrementalBuild() {
+  auto index = build();
+  index.Add(4, std::vector<Point2>{ {8.6f, 8.6f}, {8.7f, 8.6f} });
+  index.Build();
+  if (index.Query(Point2(8.65f, 8.65f), 0.1f) != std::vector<uint32_t>{ 3, 4 })
+    throw runtime_error("A second build should keep what was already indexed");
+}
+
+void TestSerialize() {
+  auto index = build();
+  std::string buffer = index.Serialize();
+
+  // Aligned copy, like a memory mapped file would be
+  std::vector<uint64_t> aligned((buffer.size() + 7) / 8);
+  memcpy(aligned.data(), buffer.data(), buffer.size());
+  index_t mapped(reinterpret_cast<const char*>(aligned.data()), buffer.size());
+  if (mapped.cell_count() != index.cell_count())
+    throw runtime_error("Deserialized index should have the same cells");
+  AABB2<Point2> bbox(Point2(4.9f, 4.9f), Point2(5.3f, 5.3f));
+  if (mapped.Query(bbox) != index.Query(bbox))
+    throw runtime_error("Deserialized index should give the same results");
+
+  // Wrong payload type or truncated buffers should be rejected
+  try {
+    GridIndex<Point2, uint64_t>(reinterpret_cast<const char*>(aligned.data()), buffer.size());
+    throw logic_error("Wrong payload type should throw");
+  }
+  catch (const runtime_error&) { }
+  try {
+    index_t(reinterpret_cast<const char*>(aligned.data()), buffer.size() - 1);
+    throw logic_error("Truncated buffer should throw");
+  }
+  catch (const runtime_error&) { }
+}
+
+void TestLatLng() {
+  GridIndex<PointLL, uint32_t> index(Tiles<PointLL>(AABB2<PointLL>(PointLL(-180, -90), PointLL(180, 90)), 0.25f, 5));
+  index.Add(7, std::vector<PointLL>{ {-76.5f, 40.5f}, {-76.4f, 40.5f} });
+  index.Build();
+  // About 550m south of the line
+  if (index.Query(PointLL(-76.45f, 40.495f), 1000.f) != std::vector<uint32_t>{ 7 })
+    throw runtime_error("Expected the line within a kilometer");
+  if (!index.Query(PointLL(-76.45f, 40.4f), 1000.f).empty())
+    throw runtime_error("Expected nothing within a kilometer");
+}
+
+}
+
+int main() {
+  test::suite suite("gridindex");
+
+  suite.test(TEST_CASE(TestCell));
+  suite.test(TEST_CASE(TestBoundingBox));
+  suite.test(TEST_CASE(TestRadius));
+  suite.test(TEST_CASE(TestIncrementalBuild));
+  suite.test(TEST_CASE(TestSerialize));
+  suite.test(TEST_CASE(TestLatLng));
+
+  return suite.tear_down();
+}
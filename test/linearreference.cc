@@ -0,0 +1,120 @@
+#include "test.h"
+#include "valhalla/midgard/linearreference.h"
+#include "valhalla/midgard/pointll.h"
+#include "valhalla/midgard/util.h"
+
+#include <vector>
+#include <cmath>
+#include <tuple>
+
+using namespace std;
+using namespace valhalla::midgard;
+
+namespace {
+
+// A random walk about as long as a few edges, with a repeated vertex
+std::vector<PointLL> walk(size_t count) {
+  std::vector<PointLL> pts;
+  PointLL p(-76.5f, 40.5f);
+  for (size_t i = 0; i < count; ++i) {
+    if (i % 7 != 3)
+      p = PointLL(p.lng() + (rand01() - 0.3f) * 1e-3f, p.lat() + (rand01() - 0.3f) * 1e-3f);
+    pts.push_back(p);
+  }
+  return pts;
+}
+
+void TestMeasures() {
+  auto pts = walk(50);
+  LinearReference lr(pts);
+  if (lr.measures().size() != pts.size() || lr.measures().front() != 0.0)
+    throw runtime_error("There should be a measure for every vertex");
+  if (std::abs(lr.Length() - length(pts)) > 1e-3f * lr.Length())
+    throw runtime_error("Length should match the length of the shape");
+  for (size_t i = 1; i < pts.size(); ++i) {
+    if (lr.measures()[i] < lr.measures()[i - 1])
+      throw runtime_error("Measures should not decrease");
+  }
+}
+
+void TestPointAt() {
+  auto pts = walk(50);
+  LinearReference lr(pts);
+  if (!(lr.PointAt(-5.0f) == pts.front()) || !(lr.PointAt(lr.Length() + 5.0f) == pts.back()))
+    throw runtime_error("Measures should be clamped to the ends");
+  for (size_t i = 0; i < pts.size(); ++i) {
+    if (!(lr.PointAt(lr.measures()[i]) == pts[i]) && i % 7 != 3 && i + 1 != pts.size())
+      throw runtime_error("The point at the measure of a vertex should be the vertex");
+  }
+
+  // Points along the shape should be that far along it, to within the
+  // precision of a float longitude (about half a meter)
+  for (float m = 0.0f; m < lr.Length(); m += lr.Length() / 37.0f) {
+    PointLL p = lr.PointAt(m);
+    int i = lr.Segment(m);
+    float along = lr.measures()[i] + pts[i].Distance(p);
+    if (std::abs(along - m) > 1.0f)
+      throw runtime_error("Point at a measure is not that far along");
+    if (lr.PointAt(lr.Project(p)).Distance(p) > 1.0f)
+      throw runtime_error("Projecting the point at a measure should give the point back");
+  }
+}
+
+void TestHeadings() {
+  for (size_t count = 2; count < 30; count += 3) {
+    auto pts = walk(count);
+    LinearReference lr(pts);
+    for (float dist = 0.0f; dist < lr.Length() * 1.2f; dist += lr.Length() / 11.0f) {
+      if (std::abs(lr.HeadingAlong(dist) - PointLL::HeadingAlongPolyline(pts, dist)) > 1e-2f)
+        throw runtime_error("HeadingAlong should match HeadingAlongPolyline");
+      if (std::abs(lr.HeadingAtEnd(dist) - PointLL::HeadingAtEndOfPolyline(pts, dist)) > 1e-2f)
+        throw runtime_error("HeadingAtEnd should match HeadingAtEndOfPolyline");
+    }
+  }
+
+  // The heading of the segment at a measure, zero length segments skipped
+  LinearReference lr({ { -76.5f, 40.5f }, { -76.5f, 40.5f }, { -76.5f, 40.6f },
+                       { -76.4f, 40.6f }, { -76.4f, 40.6f } });
+  if (std::abs(lr.HeadingAt(-1.0f)) > 1e-3f || std::abs(lr.HeadingAt(100.0f)) > 1e-3f)
+    throw runtime_error("First segment heads north");
+  if (std::abs(lr.HeadingAt(lr.Length()) - 90.0f) > 0.1f || lr.Segment(lr.Length()) != 2)
+    throw runtime_error("Last segment with a length heads east");
+  if (LinearReference({}).Segment(0.0f) != -1 || LinearReference({}).HeadingAt(0.0f) != 0.0f)
+    throw runtime_error("Empty shapes have no segments");
+}
+
+void TestSubstring() {
+  auto pts = walk(50);
+  LinearReference lr(pts);
+  float from = lr.measures()[10] + 1.0f, to = lr.measures()[20] - 1.0f;
+  auto part = lr.Substring(from, to);
+  size_t between = 0;
+  for (size_t i = 11; i < 20; ++i)
+    between += pts[i] == pts[i - 1] ? 0 : 1;
+  if (part.size() != between + 2)
+    throw runtime_error("Substring should hold the vertices between the measures");
+  if (!(part.front() == lr.PointAt(from)) || !(part.back() == lr.PointAt(to)))
+    throw runtime_error("Substring should start and end at the measures");
+  if (std::abs(length(part) - (to - from)) > 1.0f)
+    throw runtime_error("Substring should be as long as the measures are apart");
+
+  // Whole shape, less any repeated vertices, and degenerate parts
+  auto whole = lr.Substring(0.0f, lr.Length());
+  if (!(whole.front() == pts.front()) || !(whole.back() == pts.back()))
+    throw runtime_error("Whole substring should match the shape");
+  if (lr.Substring(5.0f, 5.0f).size() != 2 || !lr.Substring(6.0f, 5.0f).empty())
+    throw runtime_error("Degenerate substrings are a point or empty");
+}
+
+}
+
+int main() {
+  test::suite suite("linearreference");
+
+  suite.test(TEST_CASE(TestMeasures));
+  suite.test(TEST_CASE(TestPointAt));
+  suite.test(TEST_CASE(TestHeadings));
+  suite.test(TEST_CASE(TestSubstring));
+
+  return suite.tear_down();
+}
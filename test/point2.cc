@@ -3,6 +3,8 @@
 #include "test.h"
 
 #include <vector>
+#include <cstring>
+#include <type_traits>
 
 #include "valhalla/midgard/vector2.h"
 
@@ -141,6 +143,24 @@ void TestWithinConvexPolygon() {
   TryWithinConvexPolygon(pts, Point2( 1.0f,-3.5f), false);
 }
 
+void TestLayout() {
+  static_assert(sizeof(Point2) == 2 * sizeof(float), "Point2 should be two floats");
+  static_assert(std::is_trivially_copyable<Point2>::value, "Point2 should be trivially copyable");
+  static_assert(std::is_standard_layout<Point2>::value, "Point2 should be standard layout");
+  static_assert(!Point2::IsSpherical(), "Point2 should be planar");
+
+  // Copy a shape byte for byte
+  std::vector<Point2> a{ {1.0f, 2.0f}, {3.0f, 4.0f} }, b(2);
+  memcpy(b.data(), a.data(), a.size() * sizeof(Point2));
+  if (a != b)
+    throw runtime_error("Copying the bytes of a shape should copy the shape");
+
+  // Pair compatibility
+  std::pair<float, float> p = Point2(5.0f, 6.0f);
+  if (Point2(p) != Point2(5.0f, 6.0f) || !(Point2(1.0f, 9.0f) < Point2(2.0f, 0.0f)))
+    throw runtime_error("Point2 should convert to and compare like a pair");
+}
+
 }
 
 int main() {
@@ -173,5 +193,8 @@ int main() {
   // Test if within polygon
   suite.test(TEST_CASE(TestWithinConvexPolygon));
 
+  // Memory layout
+  suite.test(TEST_CASE(TestLayout));
+
   return suite.tear_down();
 }
@@ -1,6 +1,11 @@
 #include "midgard/pointll.h"
 #include "midgard/constants.h"
+#include "midgard/distanceapproximator.h"
+#include "midgard/vector2.h"
+#include "midgard/util.h"
 #include <cmath>
+#include <limits>
+#include <type_traits>
 
 #include "test.h"
 
@@ -190,6 +195,164 @@ void TestClosestPoint() {
   TryClosestPoint(pts, PointLL(15.0f, 4.0f), PointLL(12.0f, 0.0f), 3);
 }
 
+// The original one segment at a time ClosestPoint
+std::tuple<PointLL, float, int> ReferenceClosestPoint(const PointLL& pt, const std::vector<PointLL>& pts) {
+  PointLL closest;
+  int idx = -1;
+  float mindist = std::numeric_limits<float>::max();
+  if (pts.size() == 1)
+    return std::make_tuple(pts.front(), pt.DistanceSquared(pts.front()), 0);
+  DistanceApproximator approx(pt);
+  bool beyond_end = true;
+  for (size_t index = 0; index < pts.size() - 1; ++index) {
+    Vector2 v1(pts[index], pts[index + 1]);
+    if (v1.x() == 0.0f && v1.y() == 0.0f)
+      continue;
+    Vector2 v2(pts[index], pt);
+    float dot = v1.Dot(v2);
+    if (dot <= 0.0f) {
+      beyond_end = false;
+      float dist = approx.DistanceSquared(pts[index]);
+      if (dist < mindist) {
+        mindist = dist;
+        closest = pts[index];
+        idx = index;
+      }
+      continue;
+    }
+    float comp = dot / v1.Dot(v1);
+    if (comp >= 1.0f)
+      beyond_end = true;
+    else {
+      beyond_end = false;
+      PointLL projpt = pts[index] + v1 * comp;
+      float dist = approx.DistanceSquared(projpt);
+      if (dist < mindist) {
+        mindist = dist;
+        closest = projpt;
+        idx = index;
+      }
+    }
+  }
+  if (beyond_end) {
+    float dist = approx.DistanceSquared(pts.back());
+    if (dist < mindist) {
+      mindist = dist;
+      closest = pts.back();
+      idx = pts.size() - 2;
+    }
+  }
+  return std::make_tuple(closest, mindist, idx);
+}
+
+void TestClosestPointMatchesReference() {
+  // Random walks of every size up to a few vector widths, with repeated vertices
+  for (size_t count = 1; count < 40; ++count) {
+    std::vector<PointLL> pts;
+    PointLL p(-76.5f, 40.5f);
+    for (size_t i = 0; i < count; ++i) {
+      if (i % 5 != 2)
+        p = PointLL(p.lng() + (rand01() - 0.5f) * .01f, p.lat() + (rand01() - 0.5f) * .01f);
+      pts.push_back(p);
+    }
+    std::vector<PointLL> targets;
+    for (int i = 0; i < 37; ++i)
+      targets.emplace_back(-76.5f + (rand01() - 0.5f) * .04f, 40.5f + (rand01() - 0.5f) * .04f);
+
+    auto all = PointLL::ClosestPoints(targets, pts);
+    if (all.size() != targets.size())
+      throw runtime_error("Expected a result per target");
+    for (size_t i = 0; i < targets.size(); ++i) {
+      auto expected = ReferenceClosestPoint(targets[i], pts);
+      auto got = targets[i].ClosestPoint(pts);
+      if (std::get<0>(got) != std::get<0>(expected) || std::get<1>(got) != std::get<1>(expected) ||
+          std::get<2>(got) != std::get<2>(expected))
+        throw runtime_error("ClosestPoint does not match the reference");
+      if (std::get<0>(all[i]) != std::get<0>(expected) || std::get<1>(all[i]) != std::get<1>(expected) ||
+          std::get<2>(all[i]) != std::get<2>(expected))
+        throw runtime_error("ClosestPoints does not match the reference");
+    }
+  }
+}
+
+// Haversine in double on the sphere PointLL::Distance uses
+double ReferenceDistance(const PointLL& a, const PointLL& b) {
+  double r = M_PI / 180.0;
+  double sa = sin((b.lat() - static_cast<double>(a.lat())) * r / 2);
+  double sb = sin((b.lng() - static_cast<double>(a.lng())) * r / 2);
+  double h = sa * sa + cos(a.lat() * r) * cos(b.lat() * r) * sb * sb;
+  return 2 * asin(sqrt(std::min(h, 1.0))) * kRadEarthMeters;
+}
+
+void TryDistances(const float maxlat, const double relative) {
+  // Pairs of points from centimeters to hundreds of kilometers apart
+  std::vector<PointLL> pts;
+  for (int i = 0; i < 20000; ++i) {
+    PointLL a((rand01() - 0.5f) * 360.f, (rand01() - 0.5f) * 2.f * maxlat);
+    float length = powf(10.f, -7.f + 7.f * rand01()), angle = rand01() * 2.f * kPi;
+    float lat = std::max(-maxlat, std::min(maxlat, a.lat() + length * sinf(angle)));
+    pts.push_back(a);
+    pts.emplace_back(a.lng() + length * cosf(angle), lat);
+  }
+  auto distances = PointLL::Distances(pts);
+  if (distances.size() != pts.size() - 1)
+    throw logic_error("Expected a distance per pair of consecutive points");
+  for (size_t i = 0; i < pts.size(); i += 2) {
+    double expected = ReferenceDistance(pts[i], pts[i + 1]);
+    if (fabs(distances[i] - expected) > relative * expected)
+      throw logic_error("Distances is off the spherical distance by more than the error bound");
+    if (fabs(distances[i] - pts[i].Distance(pts[i + 1])) > 5e-6 * expected + 1.0)
+      throw logic_error("Distances is off PointLL::Distance by more than the error bound");
+  }
+}
+
+void TestDistances() {
+  TryDistances(60.f, 5e-7);
+  TryDistances(85.f, 5e-6);
+
+  // Same points, antimeridian crossing and poles
+  std::vector<PointLL> pts{ { 10.f, 10.f }, { 10.f, 10.f }, { 179.9f, 0.f }, { -179.9f, 0.f },
+                            { 0.f, 90.f }, { 0.f, 90.f }, { 90.f, 89.f }, { -90.f, 89.f } };
+  auto distances = PointLL::Distances(pts);
+  for (size_t i = 0; i < distances.size(); ++i) {
+    double expected = ReferenceDistance(pts[i], pts[i + 1]);
+    if (fabs(distances[i] - expected) > 1e-4 * expected)
+      throw logic_error("Distances is off the spherical distance");
+  }
+  if (distances[0] != 0.f || distances[4] != 0.f)
+    throw logic_error("The distance between equal points should be 0");
+  if (distances[2] > 30000.f)
+    throw logic_error("Distances should take the short way across the antimeridian");
+
+  // Every size, each pair gets the same distance wherever it falls in a vector
+  std::vector<PointLL> walk;
+  PointLL p(-76.5f, 40.5f);
+  for (size_t i = 0; i < 40; ++i) {
+    p = PointLL(p.lng() + (rand01() - 0.5f) * .01f, p.lat() + (rand01() - 0.5f) * .01f);
+    walk.push_back(p);
+  }
+  distances = PointLL::Distances(walk);
+  for (size_t count = 0; count < walk.size(); ++count) {
+    for (size_t offset = 0; offset + count <= walk.size() && offset < 10; ++offset) {
+      std::vector<PointLL> part(walk.begin() + offset, walk.begin() + offset + count);
+      auto part_distances = PointLL::Distances(part);
+      auto measures = PointLL::CumulativeDistances(part);
+      if (part_distances.size() != (count < 2 ? 0 : count - 1) || measures.size() != count)
+        throw logic_error("Wrong number of distances");
+      double d = 0.0;
+      for (size_t i = 0; i < part_distances.size(); ++i) {
+        if (part_distances[i] != distances[offset + i])
+          throw logic_error("Distances should not depend on the position of the pair");
+        if (measures[i] != d)
+          throw logic_error("CumulativeDistances should be the prefix sums of Distances");
+        d += part_distances[i];
+      }
+      if (count > 0 && measures.back() != d)
+        throw logic_error("CumulativeDistances should end at the total length");
+    }
+  }
+}
+
 void TryWithinConvexPolygon(const std::vector<PointLL>& pts, const PointLL&p,
                             const bool res) {
   if (p.WithinConvexPolygon(pts) != res)
@@ -259,6 +422,18 @@ void TestMidPoint() {
     throw std::logic_error("Wrong mid point");
 }
 
+void TestLayout() {
+  static_assert(sizeof(PointLL) == 2 * sizeof(float), "PointLL should not carry anything but lng,lat");
+  static_assert(std::is_trivially_copyable<PointLL>::value, "PointLL should be trivially copyable");
+  static_assert(std::is_standard_layout<PointLL>::value, "PointLL should be standard layout");
+  static_assert(PointLL::IsSpherical(), "PointLL should be spherical");
+
+  // Converting from Point2 keeps lng,lat
+  PointLL ll = Point2(-76.5f, 40.5f);
+  if (ll.lng() != -76.5f || ll.lat() != 40.5f)
+    throw std::logic_error("Conversion from Point2 should keep lng,lat");
+}
+
 }
 
 int main(void) {
@@ -274,6 +449,9 @@ int main(void) {
   suite.test(TEST_CASE(TestHeadingAtEndOfPolyline));
 
   suite.test(TEST_CASE(TestClosestPoint));
+  suite.test(TEST_CASE(TestClosestPointMatchesReference));
+
+  suite.test(TEST_CASE(TestDistances));
 
   // Test if within polygon
   suite.test(TEST_CASE(TestWithinConvexPolygon));
@@ -281,6 +459,9 @@ int main(void) {
   // Test midpoint
   suite.test(TEST_CASE(TestMidPoint));
 
+  // Memory layout
+  suite.test(TEST_CASE(TestLayout));
+
   //TODO: many more!
 
   return suite.tear_down();
@@ -3,8 +3,17 @@
 #include "test.h"
 
 #include <vector>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <string>
 
 #include "valhalla/midgard/point2.h"
+#include "valhalla/midgard/pointll.h"
+#include "valhalla/midgard/linesegment2.h"
+#include "valhalla/midgard/util.h"
+#include "valhalla/midgard/distanceapproximator.h"
+#include "valhalla/midgard/constants.h"
 
 using namespace std;
 using namespace valhalla::midgard;
@@ -45,6 +54,175 @@ void TestGeneralizeAndLength() {
   TryGeneralizeAndLength(pl, 100.0f, 79.0569f);
 }
 
+// The recursive Douglas-Peucker that Generalize used to be
+template <class coord_t>
+void ReferenceDouglasPeucker(const std::vector<coord_t>& pts, const uint32_t i, const uint32_t j,
+                             const float t2, std::vector<coord_t>& genpts) {
+  uint32_t index = 0;
+  float maxdist = 0.0f;
+  coord_t tmp;
+  LineSegment2<coord_t> v(pts[i], pts[j]);
+  for (uint32_t k = i + 1; k < j; k++) {
+    float d2 = v.DistanceSquared(pts[k], tmp);
+    if (d2 > maxdist) {
+      maxdist = d2;
+      index = k;
+    }
+  }
+  if (maxdist > t2) {
+    ReferenceDouglasPeucker(pts, i, index, t2, genpts);
+    ReferenceDouglasPeucker(pts, index, j, t2, genpts);
+  }
+  else {
+    if (genpts.empty() || !(pts[i] == genpts.back()))
+      genpts.push_back(pts[i]);
+    if (!(pts[j] == genpts.back()))
+      genpts.push_back(pts[j]);
+  }
+}
+
+// A random walk with some repeated vertices
+template <class coord_t>
+std::vector<coord_t> walk(size_t count, float step) {
+  std::vector<coord_t> pts;
+  coord_t p(-76.5f, 40.5f);
+  for (size_t i = 0; i < count; ++i) {
+    if (i % 7 != 3)
+      p = coord_t(p.first + (rand01() - 0.5f) * step, p.second + (rand01() - 0.5f) * step);
+    pts.push_back(p);
+  }
+  return pts;
+}
+
+template <class coord_t>
+void TryGeneralize(const std::vector<coord_t>& pts, const std::vector<float>& tolerances) {
+  Polyline2<coord_t> pl(const_cast<std::vector<coord_t>&>(pts));
+  auto significance = pl.Significance();
+  for (float t : tolerances) {
+    std::vector<coord_t> expected;
+    ReferenceDouglasPeucker(pts, 0, pts.size() - 1, t * t, expected);
+
+    Polyline2<coord_t> generalized(const_cast<std::vector<coord_t>&>(pts));
+    generalized.Generalize(t);
+    if (generalized.pts() != expected)
+      throw runtime_error("Generalize should match the recursive Douglas-Peucker");
+    if (pl.GeneralizedPolyline(t).pts() != expected)
+      throw runtime_error("GeneralizedPolyline should match the recursive Douglas-Peucker");
+
+    Polyline2<coord_t> filtered(const_cast<std::vector<coord_t>&>(pts));
+    filtered.Generalize(t, significance);
+    if (filtered.pts() != expected || pl.GeneralizedPolyline(t, significance).pts() != expected)
+      throw runtime_error("Generalizing by significance should match Douglas-Peucker");
+  }
+}
+
+void TestGeneralizeBySignificance() {
+  for (size_t count = 1; count < 200; count += 13) {
+    TryGeneralize(walk<Point2>(count, 1.f), { 0.f, .01f, .1f, .3f, 1.f, 10.f });
+    TryGeneralize(walk<PointLL>(count, .001f), { 0.f, 1.f, 5.f, 20.f, 100.f, 1000.f });
+  }
+
+  // A zigzag: every vertex is equally far from the chord so every split is
+  // next to the start of the range and the recursion would be as deep as
+  // the shape is long
+  std::vector<Point2> pts;
+  for (int i = 0; i < 5000; ++i)
+    pts.emplace_back(i, i % 2);
+  Polyline2<Point2> pl(pts);
+  auto significance = pl.Significance();
+  if (significance.front() != std::numeric_limits<float>::infinity() ||
+      significance.back() != std::numeric_limits<float>::infinity())
+    throw runtime_error("End points should always be kept");
+  if (pl.Generalize(0.f) != pts.size() || pl.Generalize(1e6f) != 2)
+    throw runtime_error("Generalizing a zigzag is wrong");
+
+  Polyline2<Point2> mismatched(pts);
+  try {
+    mismatched.Generalize(1.f, std::vector<float>(3));
+    throw runtime_error("Mismatched significance should throw");
+  } catch (const std::runtime_error& e) {
+    if (std::string(e.what()) == "Mismatched significance should throw")
+      throw;
+  }
+}
+
+// Visvalingam-Whyatt the slow way, recomputing every area after each
+// removal, down to a number of vertices
+template <class coord_t>
+std::vector<coord_t> ReferenceVisvalingamWhyatt(std::vector<coord_t> pts, const uint32_t count) {
+  // Areas in the units Polyline2 uses
+  auto area = [](const coord_t& a, const coord_t& b, const coord_t& c) {
+    float sx = coord_t::IsSpherical() ? DistanceApproximator::MetersPerLngDegree(b.y()) : 1.0f;
+    float sy = coord_t::IsSpherical() ? kMetersPerDegreeLat : 1.0f;
+    float abx = (b.x() - a.x()) * sx, aby = (b.y() - a.y()) * sy;
+    float acx = (c.x() - a.x()) * sx, acy = (c.y() - a.y()) * sy;
+    return std::abs(abx * acy - aby * acx) * 0.5f;
+  };
+  std::vector<float> floor(pts.size(), 0.0f);
+  while (pts.size() > count && pts.size() > 2) {
+    uint32_t smallest = 1;
+    float min_area = std::numeric_limits<float>::infinity();
+    for (uint32_t i = 1; i + 1 < pts.size(); ++i) {
+      float a = std::max(area(pts[i - 1], pts[i], pts[i + 1]), floor[i]);
+      if (a < min_area) {
+        min_area = a;
+        smallest = i;
+      }
+    }
+    // The neighbors can't drop below the area just removed
+    floor[smallest - 1] = std::max(floor[smallest - 1], min_area);
+    floor[smallest + 1] = std::max(floor[smallest + 1], min_area);
+    pts.erase(pts.begin() + smallest);
+    floor.erase(floor.begin() + smallest);
+  }
+  return pts;
+}
+
+template <class coord_t>
+void TryVisvalingamWhyatt(const std::vector<coord_t>& pts) {
+  Polyline2<coord_t> pl(const_cast<std::vector<coord_t>&>(pts));
+  auto areas = pl.EffectiveAreas();
+  if (areas.size() != pts.size() || (!pts.empty() && (areas.front() != std::numeric_limits<float>::infinity() ||
+      areas.back() != std::numeric_limits<float>::infinity())))
+    throw runtime_error("End points should always be kept");
+
+  for (uint32_t count = 2; count <= pts.size(); count += 3) {
+    Polyline2<coord_t> generalized(const_cast<std::vector<coord_t>&>(pts));
+    if (generalized.GeneralizeToCount(count) != count ||
+        generalized.pts() != ReferenceVisvalingamWhyatt(pts, count))
+      throw runtime_error("GeneralizeToCount should match Visvalingam-Whyatt");
+  }
+
+  // An area tolerance keeps the vertices whose effective area reaches it
+  for (uint32_t k = 1; k + 1 < pts.size(); k += 5) {
+    Polyline2<coord_t> generalized(const_cast<std::vector<coord_t>&>(pts));
+    generalized.GeneralizeByArea(areas[k]);
+    std::vector<coord_t> expected;
+    for (uint32_t i = 0; i < pts.size(); ++i) {
+      if (areas[i] >= areas[k])
+        expected.push_back(pts[i]);
+    }
+    if (generalized.pts() != expected)
+      throw runtime_error("GeneralizeByArea should keep the vertices with enough area");
+  }
+}
+
+void TestVisvalingamWhyatt() {
+  for (size_t count = 0; count < 60; count += 7) {
+    TryVisvalingamWhyatt(walk<Point2>(count, 1.f));
+    TryVisvalingamWhyatt(walk<PointLL>(count, .001f));
+  }
+
+  // The small notch goes first, then the bigger one
+  std::vector<Point2> pts = { Point2(0.f, 0.f), Point2(1.f, 0.1f), Point2(2.f, 0.f),
+                              Point2(3.f, 2.f), Point2(4.f, 0.f) };
+  Polyline2<Point2> pl(pts);
+  if (pl.GeneralizeByArea(0.5f) != 4 || pl.pts()[1] != Point2(2.f, 0.f))
+    throw runtime_error("The smallest triangle should be removed");
+  if (pl.GeneralizeToCount(0) != 2 || pl.pts().back() != Point2(4.f, 0.f))
+    throw runtime_error("Only the end points should be left");
+}
+
 void TryClosestPoint(const Polyline2<Point2>& pl, const Point2& a, const Point2& b) {
 
   auto result = pl.ClosestPoint(a);
@@ -126,6 +304,8 @@ int main() {
 
   // Test Generalize
   suite.test(TEST_CASE(TestGeneralizeAndLength));
+  suite.test(TEST_CASE(TestGeneralizeBySignificance));
+  suite.test(TEST_CASE(TestVisvalingamWhyatt));
 
   // Test distance of a point to a line segment
   suite.test(TEST_CASE(TestClosestPoint));
@@ -0,0 +1,163 @@
+#include "test.h"
+#include "valhalla/midgard/polylinesoa.h"
+#include "valhalla/midgard/polyline2.h"
+#include "valhalla/midgard/linesegment2.h"
+#include "valhalla/midgard/point2.h"
+#include "valhalla/midgard/pointll.h"
+#include "valhalla/midgard/util.h"
+
+#include <vector>
+#include <cmath>
+#include <string>
+
+using namespace std;
+using namespace valhalla::midgard;
+
+namespace {
+
+// A random walk with some repeated vertices, sizes that aren't a multiple
+// of any vector width
+template <class coord_t>
+std::vector<coord_t> walk(size_t count, float step) {
+  std::vector<coord_t> pts;
+  coord_t p(-76.5f, 40.5f);
+  for (size_t i = 0; i < count; ++i) {
+    if (i % 7 != 3)
+      p = coord_t(p.first + (rand01() - 0.5f) * step, p.second + (rand01() - 0.5f) * step);
+    pts.push_back(p);
+  }
+  return pts;
+}
+
+template <class coord_t>
+void TryClosestPoint(const std::vector<coord_t>& pts, const coord_t& pt) {
+  auto expected = pt.ClosestPoint(pts);
+  auto got = PolylineSoA<coord_t>(pts).ClosestPoint(pt);
+  if (pts.empty())
+    return;
+  if (std::get<0>(got) != std::get<0>(expected) || std::get<1>(got) != std::get<1>(expected) ||
+      std::get<2>(got) != std::get<2>(expected))
+    throw runtime_error("ClosestPoint does not match for " + std::to_string(pts.size()) + " points");
+}
+
+void TestClosestPoint() {
+  for (size_t count = 0; count < 40; ++count) {
+    auto pts = walk<Point2>(count, 1.f);
+    auto lls = walk<PointLL>(count, .01f);
+    for (int i = 0; i < 20; ++i) {
+      TryClosestPoint(pts, Point2(-76.5f + (rand01() - 0.5f) * 4.f, 40.5f + (rand01() - 0.5f) * 4.f));
+      TryClosestPoint(lls, PointLL(-76.5f + (rand01() - 0.5f) * .04f, 40.5f + (rand01() - 0.5f) * .04f));
+    }
+  }
+}
+
+void TestLength() {
+  for (size_t count = 2; count < 100; count += 7) {
+    auto pts = walk<Point2>(count, 1.f);
+    float expected = Polyline2<Point2>(pts).Length();
+    float got = PolylineSoA<Point2>(pts).Length();
+    if (std::abs(got - expected) > expected * 1e-5f)
+      throw runtime_error("Length does not match");
+
+    // Spherical length is approximated
+    auto lls = walk<PointLL>(count, .01f);
+    expected = Polyline2<PointLL>(lls).Length();
+    got = PolylineSoA<PointLL>(lls).Length();
+    if (std::abs(got - expected) > expected * 1e-3f)
+      throw runtime_error("Spherical length is off by more than 0.1%");
+  }
+  if (PolylineSoA<Point2>().Length() != 0.f || PolylineSoA<Point2>({ Point2(1.f, 1.f) }).Length() != 0.f)
+    throw runtime_error("Polylines without segments should have no length");
+}
+
+void TestBoundingBox() {
+  for (size_t count = 1; count < 40; ++count) {
+    auto pts = walk<Point2>(count, 1.f);
+    if (!(PolylineSoA<Point2>(pts).BoundingBox() == AABB2<Point2>(pts)))
+      throw runtime_error("BoundingBox does not match");
+  }
+}
+
+void TestDistancesToSegment() {
+  auto pts = walk<Point2>(37, 1.f);
+  PolylineSoA<Point2> soa(pts);
+  LineSegment2<Point2> segment(pts[2], pts[30]);
+  std::vector<float> d2(pts.size() - 5);
+  soa.DistancesToSegment(pts[2], pts[30], 3, pts.size() - 2, d2.data());
+  Point2 closest;
+  for (size_t k = 3; k < pts.size() - 2; ++k) {
+    if (d2[k - 3] != segment.DistanceSquared(pts[k], closest))
+      throw runtime_error("Segment distance does not match");
+  }
+
+  // Spherical distances approximate the cosine
+  auto lls = walk<PointLL>(37, .01f);
+  PolylineSoA<PointLL> soall(lls);
+  LineSegment2<PointLL> llsegment(lls[0], lls[36]);
+  d2.resize(lls.size());
+  soall.DistancesToSegment(lls[0], lls[36], 0, lls.size(), d2.data());
+  PointLL llclosest;
+  for (size_t k = 0; k < lls.size(); ++k) {
+    float expected = llsegment.DistanceSquared(lls[k], llclosest);
+    if (std::abs(d2[k] - expected) > expected * 1e-4f + 1e-3f)
+      throw runtime_error("Spherical segment distance is off");
+  }
+}
+
+void TestFarthestFromSegment() {
+  auto pts = walk<Point2>(45, 1.f);
+  PolylineSoA<Point2> soa(pts);
+  for (uint32_t i = 0; i < pts.size(); i += 5) {
+    for (uint32_t j = i + 1; j < pts.size(); j += 3) {
+      // What Douglas-Peucker does
+      uint32_t index = 0;
+      float maxdist = 0.f;
+      Point2 tmp;
+      LineSegment2<Point2> v(pts[i], pts[j]);
+      for (uint32_t k = i + 1; k < j; ++k) {
+        float d2 = v.DistanceSquared(pts[k], tmp);
+        if (d2 > maxdist) {
+          maxdist = d2;
+          index = k;
+        }
+      }
+      auto farthest = soa.FarthestFromSegment(i, j);
+      if (farthest.first != index || farthest.second != maxdist)
+        throw runtime_error("FarthestFromSegment does not match");
+    }
+  }
+}
+
+void TestConversion() {
+  auto pts = walk<PointLL>(13, .01f);
+  PolylineSoA<PointLL> soa(pts);
+  if (soa.size() != pts.size() || soa.pts() != pts || soa.ToPolyline2().pts() != pts)
+    throw runtime_error("Conversion should round trip");
+  if (soa.x()[5] != pts[5].lng() || soa.y()[5] != pts[5].lat())
+    throw runtime_error("Arrays should hold lng and lat");
+
+  // Add skips repeated end points like Polyline2
+  PolylineSoA<PointLL> added;
+  for (const auto& p : pts)
+    added.Add(p);
+  Polyline2<PointLL> polyline;
+  for (const auto& p : pts)
+    polyline.Add(p);
+  if (added.pts() != polyline.pts())
+    throw runtime_error("Add should skip repeated points");
+}
+
+}
+
+int main() {
+  test::suite suite("polylinesoa");
+
+  suite.test(TEST_CASE(TestClosestPoint));
+  suite.test(TEST_CASE(TestLength));
+  suite.test(TEST_CASE(TestBoundingBox));
+  suite.test(TEST_CASE(TestDistancesToSegment));
+  suite.test(TEST_CASE(TestFarthestFromSegment));
+  suite.test(TEST_CASE(TestConversion));
+
+  return suite.tear_down();
+}
@@ -0,0 +1,85 @@
+#include "test.h"
+#include "valhalla/midgard/preparedpolyline.h"
+#include "valhalla/midgard/point2.h"
+#include "valhalla/midgard/pointll.h"
+#include "valhalla/midgard/aabb2.h"
+#include "valhalla/midgard/util.h"
+
+#include <vector>
+#include <string>
+
+using namespace std;
+using namespace valhalla::midgard;
+
+namespace {
+
+// A random walk with some repeated vertices
+template <class coord_t>
+std::vector<coord_t> walk(size_t count, float step) {
+  std::vector<coord_t> pts;
+  coord_t p(-76.5f, 40.5f);
+  for (size_t i = 0; i < count; ++i) {
+    if (i % 7 != 3)
+      p = coord_t(p.first + (rand01() - 0.5f) * step, p.second + (rand01() - 0.5f) * step);
+    pts.push_back(p);
+  }
+  return pts;
+}
+
+template <class coord_t>
+void TryClosestPoint(const PreparedPolyline<coord_t>& prepared, const coord_t& pt) {
+  auto expected = pt.ClosestPoint(prepared.pts());
+  auto got = prepared.ClosestPoint(pt);
+  if (prepared.pts().empty())
+    return;
+  if (std::get<0>(got) != std::get<0>(expected) || std::get<1>(got) != std::get<1>(expected) ||
+      std::get<2>(got) != std::get<2>(expected))
+    throw runtime_error("ClosestPoint does not match for " + std::to_string(prepared.pts().size()) + " points");
+}
+
+void TestClosestPoint() {
+  for (size_t count = 0; count < 300; count += (count < 40 ? 1 : 37)) {
+    PreparedPolyline<Point2> pts(walk<Point2>(count, 1.f));
+    PreparedPolyline<PointLL> lls(walk<PointLL>(count, .01f));
+    for (int i = 0; i < 20; ++i) {
+      TryClosestPoint(pts, Point2(-76.5f + (rand01() - 0.5f) * 8.f, 40.5f + (rand01() - 0.5f) * 8.f));
+      TryClosestPoint(lls, PointLL(-76.5f + (rand01() - 0.5f) * .08f, 40.5f + (rand01() - 0.5f) * .08f));
+    }
+  }
+}
+
+void TestClosestPointOnShape() {
+  // Targets on vertices and segments are where ties and rounding show up
+  auto lls = walk<PointLL>(2000, .001f);
+  PreparedPolyline<PointLL> prepared(lls);
+  for (size_t i = 0; i + 1 < lls.size(); i += 3) {
+    TryClosestPoint(prepared, lls[i]);
+    TryClosestPoint(prepared, lls[i].MidPoint(lls[i + 1]));
+  }
+
+  // A shape that doubles back on itself has many equally close segments
+  std::vector<Point2> back = { Point2(0.f, 0.f), Point2(10.f, 0.f), Point2(0.f, 0.f), Point2(10.f, 0.f) };
+  for (int i = 0; i < 5; ++i)
+    back.insert(back.end(), back.begin(), back.begin() + 4);
+  PreparedPolyline<Point2> prepared_back(back);
+  for (float x = -1.f; x < 11.f; x += .5f)
+    TryClosestPoint(prepared_back, Point2(x, 1.f));
+}
+
+void TestBoundingBox() {
+  auto pts = walk<Point2>(100, 1.f);
+  if (!(PreparedPolyline<Point2>(pts).BoundingBox() == AABB2<Point2>(pts)))
+    throw runtime_error("BoundingBox does not match");
+}
+
+}
+
+int main() {
+  test::suite suite("preparedpolyline");
+
+  suite.test(TEST_CASE(TestClosestPoint));
+  suite.test(TEST_CASE(TestClosestPointOnShape));
+  suite.test(TEST_CASE(TestBoundingBox));
+
+  return suite.tear_down();
+}
@@ -0,0 +1,113 @@
+#include "test.h"
+#include "valhalla/midgard/shapebatch.h"
+#include "valhalla/midgard/pointll.h"
+#include "valhalla/midgard/util.h"
+
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+
+using namespace std;
+using namespace valhalla::midgard;
+
+namespace {
+
+// Shapes of random walks of different lengths, some of them empty
+std::vector<std::vector<PointLL> > shapes(size_t count) {
+  std::vector<std::vector<PointLL> > shapes;
+  for (size_t s = 0; s < count; ++s) {
+    std::vector<PointLL> pts;
+    PointLL p(-76.5f + rand01(), 40.5f + rand01());
+    for (size_t i = 0, n = (s % 11 == 5) ? 0 : s % 1000; i < n; ++i) {
+      p = PointLL(p.lng() + (rand01() - 0.5f) * 1e-2f, p.lat() + (rand01() - 0.5f) * 1e-2f);
+      pts.push_back(p);
+    }
+    shapes.push_back(pts);
+  }
+  return shapes;
+}
+
+void TestEncode() {
+  auto points = shapes(300);
+  for (unsigned int threads : {1, 2, 3, 8}) {
+    auto encoded = encode_shapes(points, 6, threads);
+    if (encoded.size() != points.size() || encoded.offsets.back() != encoded.data.size())
+      throw runtime_error("Wrong number of shapes or offsets");
+    for (size_t i = 0; i < points.size(); ++i) {
+      if (encoded.str(i) != encode(points[i]))
+        throw runtime_error("Each shape should be encoded as encode does with " +
+                            std::to_string(threads) + " threads");
+      if (encoded.shape(i).size() != points[i].size())
+        throw runtime_error("Wrong number of points in the range over a shape");
+    }
+  }
+
+  auto five = encode_shapes(points, 5, 2);
+  if (five.precision != 5 || five.str(299) != encode(points[299], 5))
+    throw runtime_error("Shapes should be encoded with 5 digits");
+
+  auto none = encode_shapes({});
+  if (none.size() != 0 || !none.data.empty())
+    throw runtime_error("No shapes should encode to nothing");
+}
+
+void TestDecode() {
+  auto points = shapes(300);
+  std::vector<std::string> strings;
+  for (const auto& shape : points)
+    strings.push_back(encode(shape));
+  for (unsigned int threads : {1, 2, 3, 8}) {
+    auto from_strings = decode_shapes(strings, 6, threads);
+    auto from_batch = decode_shapes(encode_shapes(points, 6, threads), threads);
+    for (const auto& decoded : {from_strings, from_batch}) {
+      if (decoded.size() != points.size() || decoded.offsets.back() != decoded.points.size())
+        throw runtime_error("Wrong number of shapes or offsets");
+      for (size_t i = 0; i < points.size(); ++i) {
+        auto expected = decode<std::vector<PointLL> >(strings[i]);
+        if (!std::equal(expected.begin(), expected.end(), decoded.begin(i)) ||
+            decoded.end(i) - decoded.begin(i) != static_cast<ptrdiff_t>(expected.size()))
+          throw runtime_error("Each shape should be decoded as decode does with " +
+                              std::to_string(threads) + " threads");
+      }
+    }
+  }
+
+  auto none = decode_shapes(std::vector<std::string>());
+  if (none.size() != 0 || !none.points.empty())
+    throw runtime_error("No shapes should decode to no points");
+}
+
+void TestInvalid() {
+  auto points = shapes(300);
+  std::vector<std::string> strings;
+  for (const auto& shape : points)
+    strings.push_back(encode(shape));
+  // A bad shape in the middle is found whichever thread decodes it
+  strings[150].pop_back();
+  for (unsigned int threads : {1, 4}) {
+    bool threw = false;
+    try { decode_shapes(strings, 6, threads); } catch (const std::runtime_error&) { threw = true; }
+    if (!threw)
+      throw runtime_error("A truncated shape should throw");
+  }
+
+  bool threw = false;
+  try { encode_shapes(points, 8); } catch (const std::runtime_error&) { threw = true; }
+  if (!threw)
+    throw runtime_error("An unsupported precision should throw");
+}
+
+}
+
+int main() {
+  test::suite suite("shapebatch");
+
+  suite.test(TEST_CASE(TestEncode));
+
+  suite.test(TEST_CASE(TestDecode));
+
+  suite.test(TEST_CASE(TestInvalid));
+
+  return suite.tear_down();
+}
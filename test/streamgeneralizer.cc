@@ -0,0 +1,114 @@
+#include "test.h"
+#include "valhalla/midgard/streamgeneralizer.h"
+#include "valhalla/midgard/linesegment2.h"
+#include "valhalla/midgard/point2.h"
+#include "valhalla/midgard/pointll.h"
+#include "valhalla/midgard/util.h"
+
+#include <vector>
+
+using namespace std;
+using namespace valhalla::midgard;
+
+namespace {
+
+// A random walk with some repeated vertices
+template <class coord_t>
+std::vector<coord_t> walk(size_t count, float step) {
+  std::vector<coord_t> pts;
+  coord_t p(-76.5f, 40.5f);
+  for (size_t i = 0; i < count; ++i) {
+    if (i % 7 != 3)
+      p = coord_t(p.first + (rand01() - 0.3f) * step, p.second + (rand01() - 0.3f) * step);
+    pts.push_back(p);
+  }
+  return pts;
+}
+
+template <class coord_t>
+std::vector<coord_t> Generalize(StreamGeneralizer<coord_t>& generalizer, const std::vector<coord_t>& pts,
+                                const uint32_t capacity) {
+  std::vector<coord_t> out;
+  coord_t p;
+  for (const auto& pt : pts) {
+    if (generalizer.Add(pt, p))
+      out.push_back(p);
+    if (generalizer.size() > capacity)
+      throw runtime_error("The window should not grow past its capacity");
+  }
+  if (generalizer.Finish(p))
+    out.push_back(p);
+  return out;
+}
+
+template <class coord_t>
+void TryGeneralize(const std::vector<coord_t>& pts, const float t, const uint32_t capacity) {
+  StreamGeneralizer<coord_t> generalizer(t, capacity);
+  auto out = Generalize(generalizer, pts, capacity);
+  if (pts.empty()) {
+    if (!out.empty())
+      throw runtime_error("Nothing in should give nothing out");
+    return;
+  }
+  if (out.front() != pts.front() || out.back() != pts.back())
+    throw runtime_error("End points should be kept");
+
+  // Output points are input points in order and every input point between
+  // two of them is within the tolerance of the segment between them
+  size_t k = 0;
+  coord_t tmp;
+  for (size_t i = 1; i < out.size(); ++i) {
+    LineSegment2<coord_t> segment(out[i - 1], out[i]);
+    size_t start = k;
+    while (k < pts.size() && pts[k] != out[i]) {
+      if (segment.DistanceSquared(pts[k], tmp) > t * t)
+        throw runtime_error("Dropped point is out of tolerance");
+      ++k;
+    }
+    if (k == pts.size())
+      throw runtime_error("Output points should be input points in order");
+    if (k - start > capacity + 1)
+      throw runtime_error("Output lags the input by more than the capacity");
+  }
+
+  // Can be used again for the next polyline
+  if (Generalize(generalizer, pts, capacity) != out)
+    throw runtime_error("Generalizer should reset after Finish");
+}
+
+void TestGeneralize() {
+  for (size_t count = 0; count < 200; count += 11) {
+    for (uint32_t capacity : { 1, 4, 32 }) {
+      TryGeneralize(walk<Point2>(count, 1.f), .5f, capacity);
+      TryGeneralize(walk<PointLL>(count, .001f), 10.f, capacity);
+    }
+  }
+}
+
+void TestStraightLine() {
+  // A straight line goes down to its ends, as long as the window holds it
+  std::vector<Point2> pts;
+  for (int i = 0; i < 100; ++i)
+    pts.emplace_back(i, 2 * i);
+  StreamGeneralizer<Point2> generalizer(.01f, 1000);
+  auto out = Generalize(generalizer, pts, 1000);
+  if (out.size() != 2)
+    throw runtime_error("Straight line should be generalized to its end points");
+
+  // A window smaller than the line bounds the lag
+  StreamGeneralizer<Point2> small(.01f, 10);
+  out = Generalize(small, pts, 10);
+  if (out.size() != 11)
+    throw runtime_error("Full windows should be output");
+}
+
+}
+
+int main() {
+  test::suite suite("streamgeneralizer");
+
+  suite.test(TEST_CASE(TestGeneralize));
+  suite.test(TEST_CASE(TestStraightLine));
+
+  return suite.tear_down();
+}
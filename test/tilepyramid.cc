@@ -0,0 +1,138 @@
+#include "test.h"
+#include "valhalla/midgard/tilepyramid.h"
+#include "valhalla/midgard/aabb2.h"
+#include "valhalla/midgard/pointll.h"
+
+#include <list>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+using namespace valhalla::midgard;
+
+namespace {
+
+using pyramid_t = TilePyramid<PointLL>;
+
+pyramid_t world() {
+  return pyramid_t(AABB2<PointLL>(PointLL(-180, -90), PointLL(180, 90)), { 4.0f, 1.0f, 0.25f });
+}
+
+void TestPacking() {
+  int32_t id = pyramid_t::Id(2, 756425);
+  if (pyramid_t::Level(id) != 2 || pyramid_t::TileId(id) != 756425)
+    throw runtime_error("Packed id did not unpack to its level and tile id");
+  if (pyramid_t::Id(1, -1) != -1)
+    throw runtime_error("Packing an invalid tile id should be invalid");
+}
+
+void TestBadLevels() {
+  try {
+    pyramid_t(AABB2<PointLL>(PointLL(-180, -90), PointLL(180, 90)), { 4.0f, 3.0f });
+    throw logic_error("Levels that don't subdivide evenly should throw");
+  }
+  catch (const runtime_error&) { }
+
+  // 648 million 0.01 degree tiles don't fit in a packed Id, 162 million 0.02
+  // degree ones do
+  try {
+    pyramid_t(AABB2<PointLL>(PointLL(-180, -90), PointLL(180, 90)), { 1.0f, 0.01f });
+    throw logic_error("Levels with too many tiles to pack should throw");
+  }
+  catch (const runtime_error&) { }
+  pyramid_t fine(AABB2<PointLL>(PointLL(-180, -90), PointLL(180, 90)), { 1.0f, 0.02f });
+  if (fine.TileId(PointLL(179.99f, 89.99f), 1) < 0)
+    throw runtime_error("The last tile of the finest level should have a valid Id");
+
+  // Ids and levels the pyramid doesn't have
+  auto pyramid = world();
+  int32_t beyond = pyramid_t::Id(5, 0);
+  if (pyramid.Parent(beyond) != -1 || pyramid.Ancestor(beyond, 0) != -1 ||
+      !pyramid.Children(beyond).empty())
+    throw runtime_error("A level the pyramid doesn't have should have no relatives");
+  try {
+    pyramid.tiles(3);
+    throw logic_error("A level the pyramid doesn't have should throw");
+  }
+  catch (const out_of_range&) { }
+}
+
+void TestAncestors() {
+  auto pyramid = world();
+  // Every level should agree with computing the tile directly from the point
+  for (const auto& ll : { PointLL(-76.5f, 40.5f), PointLL(179.9f, -89.9f), PointLL(0.1f, 0.1f) }) {
+    int32_t finest = pyramid.TileId(ll, 2);
+    if (pyramid.Parent(finest) != pyramid.TileId(ll, 1))
+      throw runtime_error("Parent does not contain the point");
+    if (pyramid.Ancestor(finest, 0) != pyramid.TileId(ll, 0))
+      throw runtime_error("Ancestor does not contain the point");
+    if (pyramid.Ancestor(finest, 2) != finest)
+      throw runtime_error("Ancestor on the same level should be itself");
+  }
+  if (pyramid.Parent(pyramid.TileId(PointLL(0, 0), 0)) != -1)
+    throw runtime_error("The coarsest level should have no parent");
+  if (pyramid.Ancestor(pyramid.TileId(PointLL(0, 0), 1), 2) != -1)
+    throw runtime_error("A finer level should not be an ancestor");
+}
+
+void TestChildren() {
+  auto pyramid = world();
+  int32_t id = pyramid.TileId(PointLL(-76.5f, 40.5f), 0);
+  auto children = pyramid.Children(id);
+  if (children.size() != 16)
+    throw runtime_error("Expected 16 children");
+  for (const auto child : children) {
+    if (pyramid.Parent(child) != id)
+      throw runtime_error("Child does not have the right parent");
+  }
+  if (!pyramid.Children(pyramid.TileId(PointLL(0, 0), 2)).empty())
+    throw runtime_error("The finest level should have no children");
+}
+
+void TestCover() {
+  auto pyramid = world();
+  AABB2<PointLL> bbox(PointLL(-99.5f, 30.5f), PointLL(-90.5f, 39.5f));
+  auto cover = pyramid.Cover(bbox);
+
+  // Same tiles as each level's own TileList
+  for (uint32_t level = 0; level < pyramid.levels(); ++level) {
+    Tiles<PointLL> tiles = pyramid.tiles(level);
+    auto expected = tiles.TileList(bbox);
+    std::sort(expected.begin(), expected.end());
+    std::vector<int32_t> got;
+    for (const auto id : cover) {
+      if (pyramid_t::Level(id) == level)
+        got.push_back(pyramid_t::TileId(id));
+    }
+    if (got != expected)
+      throw runtime_error("Cover of level " + std::to_string(level) + " does not match its TileList");
+  }
+
+  // A linestring cover has to contain the ancestors of every tile it crosses
+  std::list<PointLL> line{ {-76.5f, 40.5f}, {-73.2f, 41.7f} };
+  auto line_cover = pyramid.Cover(line);
+  for (const auto& ll : line) {
+    for (uint32_t level = 0; level < pyramid.levels(); ++level) {
+      if (std::find(line_cover.begin(), line_cover.end(), pyramid.TileId(ll, level)) == line_cover.end())
+        throw runtime_error("Linestring cover is missing a tile");
+    }
+  }
+  if (!std::is_sorted(line_cover.begin(), line_cover.end(), [](int32_t a, int32_t b) {
+        return pyramid_t::Level(a) < pyramid_t::Level(b) ||
+              (pyramid_t::Level(a) == pyramid_t::Level(b) && pyramid_t::TileId(a) < pyramid_t::TileId(b)); }))
+    throw runtime_error("Linestring cover should be in level then tile order");
+}
+
+}
+
+int main() {
+  test::suite suite("tilepyramid");
+
+  suite.test(TEST_CASE(TestPacking));
+  suite.test(TEST_CASE(TestBadLevels));
+  suite.test(TEST_CASE(TestAncestors));
+  suite.test(TEST_CASE(TestChildren));
+  suite.test(TEST_CASE(TestCover));
+
+  return suite.tear_down();
+}
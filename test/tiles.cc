@@ -2,7 +2,10 @@
 #include "valhalla/midgard/tiles.h"
 #include "valhalla/midgard/aabb2.h"
 #include "valhalla/midgard/pointll.h"
+#include "valhalla/midgard/util.h"
+#include "valhalla/midgard/distanceapproximator.h"
 #include <iostream>
+#include <cmath>
 
 using namespace std;
 using namespace valhalla::midgard;
@@ -119,6 +122,180 @@ void TileList() {
   }
 }
 
+void TestCurveIndex() {
+  // Round trip every tile through each ordering curve on a non square grid
+  for (auto order : { kRowMajor, kMorton, kHilbert }) {
+    Tiles<PointLL> tiles(AABB2<PointLL>(PointLL(-180, -90), PointLL(180, 90)), 4, 1, order);
+    std::unordered_set<uint64_t> indices;
+    for (int32_t tileid = 0; tileid < static_cast<int32_t>(tiles.TileCount()); ++tileid) {
+      uint64_t index = tiles.CurveIndex(tileid);
+      if (!indices.insert(index).second)
+        throw std::runtime_error("Curve index is not unique");
+      if (tiles.TileIdFromCurveIndex(index) != tileid)
+        throw std::runtime_error("Curve index did not round trip to tile Id");
+    }
+  }
+
+  // Known morton values: columns use the even bits, rows the odd bits
+  Tiles<Point2> morton(AABB2<Point2>(0, 0, 8, 8), 1, 1, kMorton);
+  if (morton.CurveIndex(morton.TileId(1, 0)) != 1 ||
+      morton.CurveIndex(morton.TileId(0, 1)) != 2 ||
+      morton.CurveIndex(morton.TileId(3, 3)) != 15 ||
+      morton.CurveIndex(morton.TileId(4, 0)) != 16)
+    throw std::runtime_error("Unexpected morton curve index");
+
+  // Indices outside of the tiling system are invalid
+  Tiles<Point2> wide(AABB2<Point2>(0, 0, 8, 2), 1, 1, kMorton);
+  if (wide.TileIdFromCurveIndex(2) == -1 || wide.TileIdFromCurveIndex(8) != -1)
+    throw std::runtime_error("Morton index outside of the tiles should be invalid");
+  wide.set_tile_order(kHilbert);
+  if (wide.TileIdFromCurveIndex(64) != -1)
+    throw std::runtime_error("Hilbert index outside of the curve should be invalid");
+
+  // Consecutive hilbert indices are always adjacent tiles
+  Tiles<Point2> hilbert(AABB2<Point2>(0, 0, 16, 16), 1, 1, kHilbert);
+  auto last = hilbert.GetRowColumn(hilbert.TileIdFromCurveIndex(0));
+  for (uint64_t index = 1; index < hilbert.TileCount(); ++index) {
+    auto rc = hilbert.GetRowColumn(hilbert.TileIdFromCurveIndex(index));
+    if (std::abs(rc.first - last.first) + std::abs(rc.second - last.second) != 1)
+      throw std::runtime_error("Consecutive hilbert tiles should be neighbors");
+    last = rc;
+  }
+}
+
+void TestTileListOrder() {
+  AABB2<PointLL> bbox(PointLL(-99.5f, 30.5f), PointLL(-90.5f, 39.5f));
+  for (auto order : { kMorton, kHilbert }) {
+    Tiles<PointLL> tiles(AABB2<PointLL>(PointLL(-180, -90), PointLL(180, 90)), 1, 1, order);
+    std::vector<int32_t> tilelist = tiles.TileList(bbox);
+    if (tilelist.size() != 100)
+      throw std::runtime_error("Wrong number of tiles in ordered TileList");
+    for (size_t i = 1; i < tilelist.size(); ++i) {
+      if (tiles.CurveIndex(tilelist[i - 1]) >= tiles.CurveIndex(tilelist[i]))
+        throw std::runtime_error("TileList is not in curve order");
+    }
+  }
+
+  // Intersected tiles come back along the curve too. Which tiles the line
+  // touches where it passes through their corners depends on rounding, so
+  // only the order is checked
+  Tiles<Point2> t(AABB2<Point2>{-5,-5,5,5}, 2.5, 5, kHilbert);
+  auto intersected = t.Intersect(std::list<Point2>{ {-4.9,-4.9}, {4.9,4.9} });
+  auto ids = t.OrderedTileIds(intersected);
+  if (ids.size() != intersected.size() || ids.size() < 4)
+    throw std::runtime_error("Wrong number of intersected tiles");
+  for (size_t i = 0; i < ids.size(); ++i) {
+    if (intersected.find(ids[i]) == intersected.end() ||
+        (i > 0 && t.CurveIndex(ids[i - 1]) >= t.CurveIndex(ids[i])))
+      throw std::runtime_error("Intersected tiles are not in curve order");
+  }
+}
+
+void TestBatchTileIds() {
+  // Random points (some outside) plus points right on tile boundaries
+  std::vector<PointLL> pts;
+  for (int i = 0; i < 10000; ++i)
+    pts.emplace_back(rand01() * 362.0f - 181.0f, rand01() * 182.0f - 91.0f);
+  for (float lng = -180.0f; lng <= 180.0f; lng += 0.25f)
+    pts.emplace_back(lng, lng * 0.5f);
+  pts.emplace_back(180.0f, 90.0f);
+  pts.emplace_back(-180.0f, -90.0f);
+
+  for (auto size : { 4.0f, 1.0f, 0.25f, 0.33f }) {
+    Tiles<PointLL> tiles(AABB2<PointLL>(PointLL(-180, -90), PointLL(180, 90)), size, 5);
+    std::vector<int32_t> tileids;
+    std::vector<unsigned short> subdivisions;
+    tiles.TileIds(pts, tileids, &subdivisions);
+    if (tileids.size() != pts.size() || subdivisions.size() != pts.size())
+      throw std::runtime_error("Wrong number of batch tile ids");
+    for (size_t i = 0; i < pts.size(); ++i) {
+      if (tileids[i] != tiles.TileId(pts[i]))
+        throw std::runtime_error("Batch tile id does not match TileId");
+      if (subdivisions[i] >= 25 || (tileids[i] == -1 && subdivisions[i] != 0))
+        throw std::runtime_error("Batch subdivision out of range");
+    }
+  }
+
+  // Check the subdivisions in a simple grid, including the scalar remainder
+  Tiles<Point2> grid(AABB2<Point2>(0, 0, 10, 10), 2, 4);
+  float ys[] = { 5.9f, 0.1f, 10.0f, 11.0f, 5.9f };
+  float xs[] = { 3.3f, 0.1f, 10.0f, 1.0f, 3.3f };
+  int32_t tileids[5];
+  unsigned short subdivisions[5];
+  grid.TileIds(ys, xs, 5, tileids, subdivisions);
+  if (tileids[0] != 11 || tileids[1] != 0 || tileids[2] != 24 || tileids[3] != -1 || tileids[4] != 11)
+    throw std::runtime_error("Unexpected batch tile ids");
+  if (subdivisions[0] != 14 || subdivisions[1] != 0 || subdivisions[2] != 15 ||
+      subdivisions[3] != 0 || subdivisions[4] != 14)
+    throw std::runtime_error("Unexpected batch subdivisions");
+}
+
+template <class coord_t>
+void TryClosestFirst(const Tiles<coord_t>& tiles, const coord_t& seed, const bool subdivisions) {
+  auto next = tiles.ClosestFirst(seed, subdivisions);
+  std::unordered_set<uint64_t> seen;
+  float last = 0.f;
+  while (true) {
+    auto cell = next();
+    if (std::get<0>(cell) == -1)
+      break;
+    // No repeats and never getting closer
+    if (!seen.insert(static_cast<uint64_t>(std::get<0>(cell)) << 16 | std::get<1>(cell)).second)
+      throw std::runtime_error("ClosestFirst visited a cell twice");
+    if (std::get<2>(cell) < last)
+      throw std::runtime_error("ClosestFirst distances should never decrease");
+    last = std::get<2>(cell);
+  }
+  size_t cells = tiles.TileCount();
+  if (subdivisions)
+    cells *= tiles.nsubdivisions() * tiles.nsubdivisions();
+  if (seen.size() != cells)
+    throw std::runtime_error("ClosestFirst did not visit every cell");
+}
+
+void TestClosestFirst() {
+  // First tile contains the seed and is at distance 0, diagonals come before
+  // tiles 2 away
+  Tiles<Point2> grid(AABB2<Point2>(0, 0, 10, 10), 1, 3);
+  auto next = grid.ClosestFirst(Point2(4.5f, 4.5f));
+  auto first = next();
+  if (std::get<0>(first) != grid.TileId(4, 4) || std::get<2>(first) != 0.f)
+    throw std::runtime_error("ClosestFirst should start in the tile with the seed");
+  for (int i = 0; i < 8; ++i) {
+    auto rc = grid.GetRowColumn(std::get<0>(next()));
+    if (std::abs(rc.first - 4) > 1 || std::abs(rc.second - 4) > 1)
+      throw std::runtime_error("ClosestFirst should visit the 8 neighbors next");
+  }
+  auto ring = next();
+  if (!equal(std::get<2>(ring), 1.5f))
+    throw std::runtime_error("Wrong distance to the next ring of tiles");
+
+  // Seeds inside and outside, tiles and subdivisions
+  for (auto subdivisions : { false, true }) {
+    TryClosestFirst(grid, Point2(4.5f, 4.5f), subdivisions);
+    TryClosestFirst(grid, Point2(-3.f, 12.f), subdivisions);
+  }
+
+  // Lat,lng distances are in meters
+  Tiles<PointLL> tiles(AABB2<PointLL>(PointLL(-80, 40), PointLL(-70, 45)), 1, 4);
+  TryClosestFirst(tiles, PointLL(-76.5f, 40.5f), true);
+  PointLL seed(-76.5f, 40.5f);
+  auto ll_next = tiles.ClosestFirst(seed);
+  ll_next();
+  // Half a degree of longitude to the east and west is closer than half a
+  // degree of latitude to the north
+  float expected = 0.5f * DistanceApproximator::MetersPerLngDegree(40.5f);
+  for (const auto& ll : { PointLL(-77.5f, 40.5f), PointLL(-75.5f, 40.5f) }) {
+    auto neighbor = ll_next();
+    if (std::get<0>(neighbor) != tiles.TileId(ll) || std::abs(std::get<2>(neighbor) - expected) > 1.f)
+      throw std::runtime_error("Unexpected distance to the east or west neighbor");
+  }
+  auto north = ll_next();
+  if (std::get<0>(north) != tiles.TileId(PointLL(-76.5f, 41.5f)) ||
+      std::abs(std::get<2>(north) - 0.5f * kMetersPerDegreeLat) > 1.f)
+    throw std::runtime_error("Unexpected distance to the north neighbor");
+}
+
 using intersect_t = std::unordered_map<int32_t, std::unordered_set<unsigned short> >;
 void assert_answer(const Tiles<Point2>& g, const std::list<Point2>& l, const intersect_t& expected) {
   auto answer = g.Intersect(l);
@@ -216,6 +393,94 @@ void test_random_circle() {
   //TODO:
 }
 */
+
+void TestSplit() {
+  Tiles<Point2> grid(AABB2<Point2>(0, 0, 4, 4), 1);
+  std::vector<TilePiece> pieces;
+  std::vector<Point2> points;
+  std::vector<uint32_t> segments;
+
+  // Across 2 tile edges, turn, then up across another
+  grid.Split({ { .5f, .5f }, { 2.5f, .5f }, { 2.5f, 1.5f } }, pieces, points, segments);
+  std::vector<Point2> expected = { { .5f, .5f }, { 1.f, .5f }, { 1.f, .5f }, { 2.f, .5f },
+                                   { 2.f, .5f }, { 2.5f, .5f }, { 2.5f, 1.f }, { 2.5f, 1.f },
+                                   { 2.5f, 1.5f } };
+  if (pieces.size() != 4 || points != expected ||
+      segments != std::vector<uint32_t>{ 0, 0, 0, 0, 0, 1, 1, 1, 1 })
+    throw std::runtime_error("Split pieces are wrong");
+  std::vector<int32_t> tiles = { grid.TileId(0, 0), grid.TileId(1, 0), grid.TileId(2, 0), grid.TileId(2, 1) };
+  std::vector<uint32_t> ends = { 2, 4, 7, 9 };
+  for (size_t p = 0; p < pieces.size(); ++p) {
+    if (pieces[p].tileid != tiles[p] || pieces[p].end != ends[p] || pieces[p].begin != (p ? ends[p - 1] : 0))
+      throw std::runtime_error("Split piece has the wrong tile or points");
+  }
+
+  // Through a corner goes straight to the diagonal tile
+  grid.Split({ { .5f, .5f }, { 1.5f, 1.5f } }, pieces, points, segments);
+  if (pieces.size() != 2 || pieces[1].tileid != grid.TileId(1, 1) || points[1] != Point2(1.f, 1.f))
+    throw std::runtime_error("Split through a corner is wrong");
+
+  // Shapes between a point on the max edges and one within a float ulp of
+  // them, which the division rounds onto the edge, either way round
+  for (auto size : { 0.1f, 0.25f, 0.3f, 1.0f }) {
+    Tiles<PointLL> world(AABB2<PointLL>(PointLL(-180, -90), PointLL(180, 90)), size);
+    const float below_x = std::nextafter(180.f, 0.f), below_y = std::nextafter(90.f, 0.f);
+    std::vector<PointLL> ll_points;
+    for (const auto& shape : { std::vector<PointLL>{ { below_x, 0.f }, { 180.f, 0.f } },
+                               std::vector<PointLL>{ { 179.99998f, 0.f }, { 180.f, 0.f } },
+                               std::vector<PointLL>{ { 0.f, below_y }, { 0.f, 90.f } },
+                               std::vector<PointLL>{ { below_x, below_y }, { 180.f, 90.f } } }) {
+      for (const auto& ordered : { shape, std::vector<PointLL>(shape.rbegin(), shape.rend()) }) {
+        world.Split(ordered, pieces, ll_points, segments);
+        if (pieces.size() != 1 || pieces[0].tileid != world.TileId(shape[1]) ||
+            ll_points != ordered)
+          throw std::runtime_error("Split of a shape at the max edge should be one piece in the last tile");
+      }
+    }
+  }
+
+  // Parts outside the tiles are left out
+  grid.Split({ { -1.f, .5f }, { .5f, .5f }, { .5f, -3.f } }, pieces, points, segments);
+  if (pieces.size() != 1 || points != std::vector<Point2>{ { 0.f, .5f }, { .5f, .5f }, { .5f, 0.f } })
+    throw std::runtime_error("Split should leave out what is outside the tiles");
+
+  // Random shapes: the pieces in each tile cover what clipping the shape to
+  // the tile does
+  for (int i = 0; i < 50; ++i) {
+    std::vector<Point2> shape;
+    for (int k = 0; k < 20; ++k)
+      shape.emplace_back(rand01() * 6.f - 1.f, rand01() * 6.f - 1.f);
+    grid.Split(shape, pieces, points, segments);
+    std::unordered_map<int32_t, float> lengths;
+    for (const auto& piece : pieces) {
+      auto bounds = grid.TileBounds(piece.tileid);
+      if (piece.end - piece.begin < 2)
+        throw std::runtime_error("Pieces should have a length");
+      for (uint32_t k = piece.begin; k < piece.end; ++k) {
+        if (points[k].x() < bounds.minx() - 1e-5f || points[k].x() > bounds.maxx() + 1e-5f ||
+            points[k].y() < bounds.miny() - 1e-5f || points[k].y() > bounds.maxy() + 1e-5f)
+          throw std::runtime_error("Piece is outside its tile");
+        if (k > piece.begin) {
+          lengths[piece.tileid] += points[k].Distance(points[k - 1]);
+          if (segments[k] < segments[k - 1])
+            throw std::runtime_error("Segment indices should not decrease");
+        }
+      }
+    }
+    std::vector<Point2> parts;
+    std::vector<uint32_t> offsets;
+    for (int32_t t = 0; t < static_cast<int32_t>(grid.TileCount()); ++t) {
+      grid.TileBounds(t).ClipParts(shape, parts, offsets);
+      float length = 0.f;
+      for (size_t p = 0; p + 1 < offsets.size(); ++p) {
+        for (uint32_t k = offsets[p] + 1; k < offsets[p + 1]; ++k)
+          length += parts[k].Distance(parts[k - 1]);
+      }
+      if (std::abs(length - lengths[t]) > 1e-3f)
+        throw std::runtime_error("Pieces in a tile should match clipping to the tile");
+    }
+  }
+}
 }
 
 int main() {
@@ -234,6 +499,19 @@ int main() {
   suite.test(TEST_CASE(TileList));
 
   suite.test(TEST_CASE(test_intersect_linestring));
+
+  // Test space filling curve tile orders
+  suite.test(TEST_CASE(TestCurveIndex));
+  suite.test(TEST_CASE(TestTileListOrder));
+
+  // Test batch conversion of points to tile ids
+  suite.test(TEST_CASE(TestBatchTileIds));
+
+  // Test visiting tiles in order of distance
+  suite.test(TEST_CASE(TestClosestFirst));
+
+  // Test splitting shapes into tiles
+  suite.test(TEST_CASE(TestSplit));
   /*suite.test(TEST_CASE(test_intersect_circle));
   suite.test(TEST_CASE(test_random_linestring));
   suite.test(TEST_CASE(test_random_circle));*/
@@ -4,6 +4,9 @@
 #include "midgard/constants.h"
 
 #include <list>
+#include <vector>
+#include <cmath>
+#include <algorithm>
 
 using namespace valhalla::midgard;
 
@@ -140,6 +143,66 @@ void TestResample() {
   }
 }
 
+// The arc interpolation resample_spherical_polyline used to do, with the
+// running position kept in double rather than rounded to a PointLL
+std::vector<PointLL> ReferenceResample(const std::vector<PointLL>& polyline, double resolution) {
+  const double rad_per_deg = M_PI / 180.0;
+  std::vector<PointLL> resampled{ polyline.front() };
+  resolution /= 6378160.187;
+  double remaining = resolution;
+  double lng = polyline.front().lng() * rad_per_deg, lat = polyline.front().lat() * rad_per_deg;
+  for (size_t i = 1; i < polyline.size(); ++i) {
+    double lng2 = polyline[i].lng() * rad_per_deg, lat2 = polyline[i].lat() * rad_per_deg;
+    double d = acos(sin(lat) * sin(lat2) + cos(lat) * cos(lat2) * cos(lng - lng2));
+    while (d > remaining) {
+      double sd = sin(d), a = sin(d - remaining) / sd, b = sin(remaining) / sd;
+      double x = a * cos(lat) * cos(lng) + b * cos(lat2) * cos(lng2);
+      double y = a * cos(lat) * sin(lng) + b * cos(lat2) * sin(lng2);
+      double z = a * sin(lat) + b * sin(lat2);
+      lng = atan2(y, x);
+      lat = atan2(z, sqrt(x * x + y * y));
+      resampled.emplace_back(lng / rad_per_deg, lat / rad_per_deg);
+      d -= remaining;
+      remaining = resolution;
+    }
+    remaining -= d;
+    lng = lng2;
+    lat = lat2;
+  }
+  return resampled;
+}
+
+void TestResampleMatchesReference() {
+  for (int trial = 0; trial < 50; ++trial) {
+    // Random walks with segments of about 10 m and 100 m
+    std::vector<PointLL> shape;
+    PointLL p(-76.5f + rand01(), 40.5f + rand01());
+    float step = trial % 2 ? 1e-3f : 1e-4f;
+    for (int i = 0; i < 50; ++i) {
+      p = PointLL(p.lng() + (rand01() - 0.5f) * step, p.lat() + (rand01() - 0.5f) * step);
+      shape.push_back(p);
+    }
+    for (double resolution : { 1.0, 7.0, 30.0 }) {
+      auto expected = ReferenceResample(shape, resolution);
+      auto resampled = resample_spherical_polyline(shape, resolution);
+      auto listed = resample_spherical_polyline(std::list<PointLL>(shape.begin(), shape.end()),
+                                                resolution);
+      if (!std::equal(resampled.begin(), resampled.end(), listed.begin()))
+        throw std::runtime_error("Resampling a list should give the same points");
+
+      // A point can come and go where the length is a multiple of the resolution
+      if (std::abs(static_cast<int>(resampled.size()) - static_cast<int>(expected.size())) > 1)
+        throw std::runtime_error("Resampling gave the wrong number of points");
+      for (size_t i = 0; i < std::min(resampled.size(), expected.size()); ++i) {
+        // Both are rounded to float, they can land an ulp apart
+        if (std::abs(resampled[i].lng() - expected[i].lng()) > 1e-5f ||
+            std::abs(resampled[i].lat() - expected[i].lat()) > 1e-5f)
+          throw std::runtime_error("Resampled point is not where the arc interpolation puts it");
+      }
+    }
+  }
+}
+
 void TestIterable() {
   int a[] = {1,2,3,4,5};
   char b[] = {'a','b','c','d','e'};
@@ -190,6 +253,7 @@ int main() {
   suite.test(TEST_CASE(TestClamp));
 
   suite.test(TEST_CASE(TestResample));
+  suite.test(TEST_CASE(TestResampleMatchesReference));
 
   suite.test(TEST_CASE(TestIterable));
 
@@ -2,6 +2,7 @@
 #define VALHALLA_MIDGARD_AABB2_H_
 
 #include <vector>
+#include <cstdint>
 #include <valhalla/midgard/linesegment2.h>
 
 namespace valhalla {
@@ -168,6 +169,35 @@ class AABB2 {
    */
   uint32_t Clip(std::vector<coord_t>& pts, const bool closed) const;
 
+  /**
+   * Clips the input set of vertices to the specified boundary without
+   * allocating once the scratch list has grown to the size of the output.
+   * Each vertex goes through the four edges in a single pass, the output
+   * is built in scratch and then swapped with pts. Polylines come out the
+   * same as with per edge passes, polygons are the same polygon but may
+   * start at a different vertex.
+   * @param    pts      In/Out. List of points in the polyline/polygon.
+   *                    After clipping this list is clipped to the boundary.
+   * @param    closed   Is the shape closed?
+   * @param    scratch  Scratch list, holds the input vertices afterwards.
+   * @return   Returns the number of vertices in the clipped shape.
+   */
+  uint32_t Clip(std::vector<coord_t>& pts, const bool closed, std::vector<coord_t>& scratch) const;
+
+  /**
+   * Clips an open polyline to the boundary and keeps each stretch inside
+   * the boundary as its own part rather than joining them along the
+   * boundary like Clip does. Each segment is clipped with Liang-Barsky.
+   * Points on the boundary are inside.
+   * @param   pts      List of points in the polyline.
+   * @param   parts    Output, the points of all parts one after the other.
+   * @param   offsets  Output, the index in parts of the first point of each
+   *                   part followed by the number of points in parts.
+   * @return  Returns the number of parts.
+   */
+  uint32_t ClipParts(const std::vector<coord_t>& pts, std::vector<coord_t>& parts,
+                     std::vector<uint32_t>& offsets) const;
+
   /**
    * Intersects the segment formed by u,v with the bounding box
    *
@@ -208,17 +238,37 @@ class AABB2 {
   x_t maxx_;
   y_t maxy_;
 
+  // Where a vertex is in the clipping pipeline for one edge
+  struct ClipStage {
+    coord_t first;
+    coord_t prev;
+    bool started;
+  };
+
+  /**
+   * Passes a vertex through the clipping pipeline, starting at an edge.
+   * Vertices that come out past the last edge are added to the output.
+   * @param  edge    Edge to clip against.
+   * @param  v       Vertex.
+   * @param  closed  True if the vertices form a polygon.
+   * @param  stages  State of each edge.
+   * @param  vout    Output vertices.
+   */
+  void ClipVertex(const uint32_t edge, const coord_t& v, const bool closed,
+                  ClipStage* stages, std::vector<coord_t>& vout) const;
+
   /**
-   * Clips the polyline/polygon against a single edge.
+   * Clips the segment from v1 to v2 against a single edge and passes what
+   * is inside on to the next edge.
    * @param  edge    Edge to clip against.
+   * @param  v1      Start of the segment.
+   * @param  v2      End of the segment.
    * @param  closed  True if the vertices form a polygon.
-   * @param  vin     List of input vertices.
+   * @param  stages  State of each edge.
    * @param  vout    Output vertices.
-   * @return  Returns the number of vertices after clipping. The list
-   *          of vertices is in vout.
    */
-  uint32_t ClipAgainstEdge(const ClipEdge edge, const bool closed,
-            const std::vector<coord_t>& vin, std::vector<coord_t>& vout) const;
+  void ClipSegment(const uint32_t edge, const coord_t& v1, const coord_t& v2, const bool closed,
+                   ClipStage* stages, std::vector<coord_t>& vout) const;
 
   /**
    * Finds the intersection of the segment from insidept to outsidept with the
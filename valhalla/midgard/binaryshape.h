@@ -0,0 +1,309 @@
+#ifndef VALHALLA_MIDGARD_BINARYSHAPE_H_
+#define VALHALLA_MIDGARD_BINARYSHAPE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <valhalla/midgard/encoded.h>
+
+namespace valhalla {
+namespace midgard {
+
+/**
+ * Binary shape format, a denser alternative to the text of an encoded
+ * polyline for traffic between services. The coordinates are the same
+ * integers the text holds, so converting between the two is lossless:
+ *
+ *   1 byte   the decimal digits kept (bits 0-3) and whether the offsets are
+ *            second order (bit 4), the other bits are 0
+ *   LEB128   the number of points
+ *   LEB128   per point the zig zag encoded latitude then longitude offset
+ *
+ * LEB128 keeps 7 bits per byte where the text keeps 5, so offsets of more
+ * than 10 bits take fewer bytes. First order offsets are from the previous
+ * point, second order ones are from where the previous offset would have put
+ * the point, which are much smaller on smooth curves densified at a steady
+ * spacing.
+ */
+namespace binary {
+
+//bits of the first byte
+constexpr uint8_t kPrecisionMask = 0x0f;
+constexpr uint8_t kSecondOrder = 0x10;
+
+//an unsigned number takes at most 5 bytes
+constexpr size_t kMaxNumberBytes = 5;
+constexpr size_t kMaxPointBytes = 2 * kMaxNumberBytes;
+
+//zig zag a signed number so small magnitudes are small either way
+inline uint32_t zigzag(const int number) {
+  uint32_t value = static_cast<uint32_t>(number) << 1;
+  return number < 0 ? ~value : value;
+}
+
+//write an unsigned number as 7 bit groups, lowest first, with the 0x80 bit
+//set on all but the last. all the groups are spread into the bytes of one
+//word at once, which is stored whole. 8 bytes after out have to be writable
+inline char* write(const uint32_t value, char* out) {
+  uint64_t x = value;
+  x = (x & 0x7f) | ((x & 0x3f80) << 1) | ((x & 0x1fc000) << 2) | ((x & 0xfe00000) << 3) |
+      ((x & 0xf0000000) << 4);
+  size_t bytes = (32 - __builtin_clz(value | 1) + 6) / 7;
+  x |= 0x8080808080ull & ((uint64_t(1) << (8 * (bytes - 1))) - 1);
+  encoding::store_bytes(x, out);
+  return out + bytes;
+}
+
+//read an unsigned number a byte at a time and advance p past it, end is the
+//end of the bytes
+inline uint32_t read(const char*& p, const char* end) {
+  uint32_t value = 0;
+  for (size_t shift = 0; shift < 7 * kMaxNumberBytes; shift += 7) {
+    if (p == end)
+      throw std::runtime_error("Binary shape is truncated");
+    uint8_t byte = static_cast<uint8_t>(*p++);
+    value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+    if (byte < 0x80)
+      return value;
+  }
+  throw std::runtime_error("Binary shape has a number that is too long");
+}
+
+//the groups of a number of the given length from the 8 bytes at p, gathered
+//from one word rather than a byte at a time
+inline uint32_t gather(const char* p, const size_t bytes) {
+  uint64_t x = encoding::load_bytes(p) & 0x7f7f7f7f7full & ((uint64_t(1) << (8 * bytes)) - 1);
+  //squeeze the 7 bit groups together, 2 per 16 bits then 4 per 32 then all
+  x = (x & 0x007f007f007full) | ((x & 0x7f007f007f00ull) >> 1);
+  x = (x & 0x00003fff00003fffull) | ((x & 0x3fff00003fff0000ull) >> 2);
+  x = (x & 0xfffffff) | ((x >> 32) << 28);
+  return static_cast<uint32_t>(x);
+}
+
+//a bit for each of the 64 bytes at p that ends a number, ie doesn't have the
+//0x80 bit, so the ends of the numbers in a block are known without walking
+//their bytes
+inline uint64_t last_bytes(const char* p) {
+  uint64_t ends = 0;
+#if defined(__SSE2__)
+  for (int i = 0; i < 4; ++i) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i * 16));
+    ends |= static_cast<uint64_t>(static_cast<uint16_t>(~_mm_movemask_epi8(bytes))) << (i * 16);
+  }
+#else
+  //gather the 0x80 bit of each byte of a word into its lowest 8 bits
+  for (int i = 0; i < 8; ++i) {
+    uint64_t last = (~encoding::load_bytes(p + i * 8) >> 7) & 0x0101010101010101ull;
+    ends |= ((last * 0x0102040810204080ull) >> 56) << (i * 8);
+  }
+#endif
+  return ends;
+}
+
+//the first byte and the number of points, p is advanced past them
+inline size_t read_header(const char*& p, const char* end, int& precision, bool& second_order) {
+  if (p == end)
+    throw std::runtime_error("Binary shape is truncated");
+  uint8_t flags = static_cast<uint8_t>(*p++);
+  if ((flags & ~(kPrecisionMask | kSecondOrder)) != 0)
+    throw std::runtime_error("Binary shape has an unknown format");
+  precision = flags & kPrecisionMask;
+  encoding::scale(precision);
+  second_order = (flags & kSecondOrder) != 0;
+  size_t count = read(p, end);
+  //every point takes at least 2 bytes
+  if (count > static_cast<size_t>(end - p) / 2)
+    throw std::runtime_error("Binary shape is truncated");
+  return count;
+}
+
+//write the first byte and the number of points
+inline void write_header(std::string& output, const size_t count, const int precision,
+                         const bool second_order) {
+  encoding::scale(precision);
+  output.push_back(static_cast<char>(precision | (second_order ? kSecondOrder : 0)));
+  char bytes[kMaxNumberBytes + sizeof(uint64_t)];
+  output.append(bytes, write(static_cast<uint32_t>(count), bytes));
+}
+
+//writes points given as scaled integers after the header, with room made for
+//the expected number of points at 2 bytes a number. the string is grown when
+//a point might not fit and finish trims it to the bytes written
+struct writer_t {
+  std::string& output;
+  size_t size;
+  bool second_order;
+  int last_lon, last_lat, last_dlon, last_dlat;
+
+  writer_t(std::string& output, const size_t count, const bool second_order)
+    : output(output), size(output.size()), second_order(second_order), last_lon(0),
+      last_lat(0), last_dlon(0), last_dlat(0) {
+    output.resize(size + count * 4);
+  }
+  void operator()(const int lon, const int lat) {
+    if (size + kMaxPointBytes + sizeof(uint64_t) > output.size())
+      output.resize(output.size() * 2 + kMaxPointBytes + sizeof(uint64_t));
+    int dlon = encoding::subtract(lon, last_lon), dlat = encoding::subtract(lat, last_lat);
+    char* out = &output[size];
+    if (second_order) {
+      out = write(zigzag(encoding::subtract(dlat, last_dlat)), out);
+      out = write(zigzag(encoding::subtract(dlon, last_dlon)), out);
+    } else {
+      out = write(zigzag(dlat), out);
+      out = write(zigzag(dlon), out);
+    }
+    size = out - output.data();
+    last_lon = lon;
+    last_lat = lat;
+    last_dlon = dlon;
+    last_dlat = dlat;
+  }
+  void finish() {
+    output.resize(size);
+  }
+};
+
+//read count points, calling the sink with each lon,lat pair of scaled
+//integers. every byte has to be used. the bytes are done in blocks of 64, as
+//decode_points does the text, with the ends of all numbers in a block found
+//at once and each number gathered from the word at its start
+template <class sink_t>
+void read_points(const char* p, const char* end, const size_t count, const bool second_order,
+                 sink_t sink) {
+  int lon = 0, lat = 0, dlon = 0, dlat = 0, a = 0;
+  size_t numbers = 0;
+  //the number being read starts here
+  const char* start = p;
+  //blocks are read in place while a number starting at the end of one can be
+  //read as a whole word, then the rest from the number being read is copied
+  //to a buffer with room to read past it. the padding is never the end of a
+  //number. it is one loop rather than two so the state stays in registers
+  char tail[2 * 64 + sizeof(uint64_t)];
+  const char* base = p;
+  const char* limit = end;
+  bool in_place = true;
+  while (true) {
+    if (in_place && limit - base < static_cast<ptrdiff_t>(64 + sizeof(uint64_t))) {
+      if (base - start > static_cast<ptrdiff_t>(kMaxNumberBytes))
+        throw std::runtime_error("Binary shape has a number that is too long");
+      std::memset(tail, 0x80, sizeof(tail));
+      std::memcpy(tail, start, end - start);
+      limit = tail + (end - start);
+      base = start = tail;
+      in_place = false;
+    }
+    if (base >= limit)
+      break;
+    for (uint64_t ends = last_bytes(base); ends != 0; ends &= ends - 1) {
+      const char* stop = base + __builtin_ctzll(ends) + 1;
+      size_t bytes = stop - start;
+      if (bytes > kMaxNumberBytes)
+        throw std::runtime_error("Binary shape has a number that is too long");
+      if (numbers == 2 * count)
+        throw std::runtime_error("Binary shape has bytes past its last point");
+      int number = encoding::unzigzag(gather(start, bytes));
+      start = stop;
+      //latitude first then longitude
+      if (numbers++ & 1) {
+        if (second_order) {
+          dlat = encoding::add(dlat, a);
+          dlon = encoding::add(dlon, number);
+        } else {
+          dlat = a;
+          dlon = number;
+        }
+        lat = encoding::add(lat, dlat);
+        lon = encoding::add(lon, dlon);
+        sink(lon, lat);
+      } else {
+        a = number;
+      }
+    }
+    base += 64;
+  }
+  if (start != limit || numbers != 2 * count)
+    throw std::runtime_error("Binary shape is truncated");
+}
+
+}
+
+/**
+ * Encode a container of points into the binary shape format
+ *
+ * @param points        the list of points to encode, anything with first
+ *                      (lng) and second (lat) members and a size
+ * @param precision     the decimal digits to keep
+ * @param second_order  whether to store second order offsets, which are
+ *                      smaller for smooth, evenly spaced shapes
+ * @return bytes        the binary shape
+ */
+template <class container_t>
+std::string encode_binary(const container_t& points, const int precision = kPolylinePrecision,
+                          const bool second_order = false) {
+  const double factor = encoding::scale(precision);
+  std::string output;
+  binary::write_header(output, points.size(), precision, second_order);
+  binary::writer_t writer(output, points.size(), second_order);
+  for (const auto& p : points)
+    writer(encoding::floor_int(static_cast<double>(p.first) * factor),
+           encoding::floor_int(static_cast<double>(p.second) * factor));
+  writer.finish();
+  return output;
+}
+
+/**
+ * Decode a binary shape into a container of points
+ *
+ * @param bytes    the binary shape
+ * @return points  the container of points, anything with emplace_back and a
+ *                 value_type with first_type and second_type
+ * @throws std::runtime_error if the bytes are not a binary shape
+ */
+template <class container_t>
+container_t decode_binary(const std::string& bytes) {
+  typedef typename container_t::value_type point_t;
+  const char* p = bytes.data();
+  const char* end = p + bytes.size();
+  int precision;
+  bool second_order;
+  size_t count = binary::read_header(p, end, precision, second_order);
+  const double inverse = 1.0 / encoding::scale(precision);
+  container_t output;
+  encoding::reserve(output, count, 0);
+  binary::read_points(p, end, count, second_order, [&output, inverse](const int lon, const int lat) {
+    output.emplace_back(encoding::unscale<typename point_t::first_type>(lon, inverse),
+                        encoding::unscale<typename point_t::second_type>(lat, inverse));
+  });
+  return output;
+}
+
+/**
+ * Convert an encoded polyline to the binary shape format without loss, the
+ * integers of the text are copied rather than decoded to points
+ *
+ * @param encoded       the encoded polyline
+ * @param precision     the decimal digits the polyline kept
+ * @param second_order  whether to store second order offsets
+ * @return bytes        the binary shape
+ * @throws std::runtime_error if the string is not an encoded polyline
+ */
+std::string encoded_to_binary(const std::string& encoded, const int precision = kPolylinePrecision,
+                              const bool second_order = false);
+
+/**
+ * Convert a binary shape to an encoded polyline without loss, at the
+ * precision the shape was encoded with
+ *
+ * @param bytes    the binary shape
+ * @return string  the encoded polyline
+ * @throws std::runtime_error if the bytes are not a binary shape
+ */
+std::string binary_to_encoded(const std::string& bytes);
+
+}
+}
+
+#endif  // VALHALLA_MIDGARD_BINARYSHAPE_H_
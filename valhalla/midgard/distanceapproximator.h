@@ -3,6 +3,7 @@
 #define VALHALLA_MIDGARD_DISTANCEAPPROXIMATOR_H_
 
 #include <math.h>
+#include <vector>
 
 #include <valhalla/midgard/pointll.h>
 
@@ -54,6 +55,17 @@ class DistanceApproximator
    */
   float DistanceSquared(const PointLL& ll) const;
 
+  /**
+   * Approximates the squared distance between each of a list of points and
+   * the current test point, several points at a time. Gives the same
+   * results as calling DistanceSquared for each point. Useful when many
+   * candidates are scored against one point (nearest neighbor searches).
+   * @param   pts   List of lat,lng points.
+   * @param   d2    Output, squared distance in meters of each point. Resized
+   *                to the number of points so it can be reused across calls.
+   */
+  void DistanceSquared(const std::vector<PointLL>& pts, std::vector<float>& d2) const;
+
   /**
    * Approximates arc distance between 2 lat,lng positions using meters per
    * latitude and longitude degree.  Uses the mid latitude of the 2 positions
@@ -69,6 +81,11 @@ class DistanceApproximator
    * latitude.  While the number of meters per degree of latitude is
    * constant, the number of meters per degree of longitude varies: it has
    * a maximum at the equator and lessens as latitude approaches the poles.
+   * The cosine of the latitude comes from a polynomial rather than cosf, its
+   * absolute error is below 2e-7 (2 cm per degree of longitude).
+   * Latitudes outside of [-90, 90] are clamped to it and NaN counts as 90,
+   * so the result is always between about 0 and the meters per degree of
+   * latitude.
    * @param   lat   Latitude in degrees
    * @return  Returns the number of meters per degree of longitude
    */
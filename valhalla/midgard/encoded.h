@@ -0,0 +1,421 @@
+#ifndef VALHALLA_MIDGARD_ENCODED_H_
+#define VALHALLA_MIDGARD_ENCODED_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <valhalla/midgard/pointll.h>
+
+namespace valhalla {
+namespace midgard {
+
+// Decimal digits kept by default, Google's encoding keeps 5
+constexpr int kPolylinePrecision = 6;
+
+/**
+ * Count the points in an encoded polyline, validating it along the way. The
+ * string can only hold characters of the encoding's alphabet and must end
+ * with the last byte of a latitude, longitude pair. This is exact, when an
+ * upper bound will do there are never more than encoded.size() / 2 points
+ *
+ * @param encoded   the encoded points
+ * @return count    the number of points
+ * @throws std::runtime_error if the string is not an encoded polyline
+ */
+size_t decoded_size(const std::string& encoded);
+
+/**
+ * Count the points in polyline encoded bytes, see above
+ *
+ * @param encoded   the encoded points
+ * @param length    the number of bytes
+ * @return count    the number of points
+ * @throws std::runtime_error if the bytes are not an encoded polyline
+ */
+size_t decoded_size(const char* encoded, const size_t length);
+
+//the kernels shared by the encoders and decoders below
+namespace encoding {
+
+//the factor a coordinate is scaled by to keep this many decimal digits.
+//coordinates have to fit in 32 bits so at most 7 digits are kept
+inline double scale(const int precision) {
+  static const double scales[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7 };
+  if (precision < 0 || precision > 7)
+    throw std::runtime_error("Polyline precision has to be from 0 to 7 digits");
+  return scales[precision];
+}
+
+//8 bytes of an encoded string in the order they are in memory, the kernels
+//below treat the first byte as the lowest one
+inline uint64_t load_bytes(const char* p) {
+  uint64_t x;
+  std::memcpy(&x, p, sizeof(x));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  x = __builtin_bswap64(x);
+#endif
+  return x;
+}
+inline void store_bytes(uint64_t x, char* p) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  x = __builtin_bswap64(x);
+#endif
+  std::memcpy(p, &x, sizeof(x));
+}
+
+//a number takes at most 7 bytes and the kernels read and write 8 at a time
+constexpr size_t kMaxNumberBytes = 7;
+constexpr size_t kMaxPointBytes = 2 * kMaxNumberBytes + 1;
+
+//write a number as 5 bit chunks, lowest first, with the 0x20 bit set on all
+//but the last and 63 added to all of them. rather than a loop whose length
+//depends on the number all the chunks are spread into the bytes of one word
+//at once, which is stored whole. returns the end of the number, 8 bytes
+//after out have to be writable
+inline char* serialize(const int number, char* out) {
+  //move the bits left 1 position and flip all the bits if it was a negative number
+  uint32_t value = static_cast<uint32_t>(number) << 1;
+  value = number < 0 ? ~value : value;
+  uint64_t x = value;
+  x = (x & 0x1f) | ((x & 0x3e0) << 3) | ((x & 0x7c00) << 6) | ((x & 0xf8000) << 9) |
+      ((x & 0x1f00000) << 12) | ((x & 0x3e000000) << 15) | ((x & 0xc0000000) << 18);
+  //the number of chunks, at least one even for 0
+  size_t bytes = (32 - __builtin_clz(value | 1) + 4) / 5;
+  x |= 0x2020202020202020ull & ((uint64_t(1) << (8 * (bytes - 1))) - 1);
+  store_bytes(x + 0x3f3f3f3f3f3f3f3full, out);
+  return out + bytes;
+}
+
+//the chunks of a number of the given length from the 8 bytes at p, the
+//chunks are gathered from one word rather than a byte at a time
+inline uint32_t deserialize(const char* p, const size_t bytes) {
+  //validated bytes are at least 63 so nothing borrows
+  uint64_t x = load_bytes(p) - 0x3f3f3f3f3f3f3f3full;
+  x &= 0x1f1f1f1f1f1f1f1full & ((uint64_t(1) << (8 * bytes)) - 1);
+  //squeeze the 5 bit chunks together, 2 chunks per 16 bits then 4 per 32 then all
+  x = (x & 0x001f001f001f001full) | ((x & 0x1f001f001f001f00ull) >> 3);
+  x = (x & 0x000003ff000003ffull) | ((x & 0x03ff000003ff0000ull) >> 6);
+  x = (x & 0xfffff) | ((x >> 32) << 20);
+  return static_cast<uint32_t>(x);
+}
+
+//a bit for each of the 64 bytes at p that is the last chunk of a number, ie
+//whose value after taking away 63 doesn't have the 0x20 bit. done for a
+//block at a time the ends of the numbers in it are known without walking
+//their bytes
+inline uint64_t last_chunks(const char* p) {
+  uint64_t ends = 0;
+#if defined(__SSE2__)
+  const __m128i limit = _mm_set1_epi8(63 + 0x20);
+  for (int i = 0; i < 4; ++i) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i * 16));
+    ends |= static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmplt_epi8(bytes, limit))) << (i * 16);
+  }
+#else
+  //gather the 0x20 bit of each byte of a word into its lowest 8 bits
+  for (int i = 0; i < 8; ++i) {
+    uint64_t last = (~(load_bytes(p + i * 8) - 0x3f3f3f3f3f3f3f3full) >> 5) & 0x0101010101010101ull;
+    ends |= ((last * 0x0102040810204080ull) >> 56) << (i * 8);
+  }
+#endif
+  return ends;
+}
+
+//floor of a value that fits in an int, without calling floor which isn't an
+//instruction before SSE4.1
+inline int floor_int(const double value) {
+  int truncated = static_cast<int>(value);
+  return truncated - (value < truncated);
+}
+
+//undo the left shift from serialize or the bit flipping
+inline int unzigzag(const uint32_t value) {
+  return static_cast<int>(value & 1 ? ~(value >> 1) : (value >> 1));
+}
+
+//offsets wrap around rather than overflow, so with 7 digits points more than
+//half the world apart still round trip
+inline int add(const int a, const int b) {
+  return static_cast<int>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b));
+}
+inline int subtract(const int a, const int b) {
+  return static_cast<int>(static_cast<uint32_t>(a) - static_cast<uint32_t>(b));
+}
+
+//encode the points in a range into a buffer, which gives out room for a
+//point at a time: room() is where the next point goes, with space for
+//kMaxPointBytes and the word written past the last byte, and used(end)
+//takes the end of the point
+template <class iterator_t, class buffer_t>
+void encode_points(iterator_t begin, const iterator_t end, const int precision, buffer_t& buffer) {
+  const double factor = scale(precision);
+  //this is an offset encoding so we remember the last point we saw
+  int last_lon = 0, last_lat = 0;
+  for (; begin != end; ++begin) {
+    //shift the decimal point to the right and truncate
+    int lon = floor_int(static_cast<double>(begin->first) * factor);
+    int lat = floor_int(static_cast<double>(begin->second) * factor);
+    //encode each coordinate, lat first for some reason
+    char* out = serialize(subtract(lat, last_lat), buffer.room());
+    buffer.used(serialize(subtract(lon, last_lon), out));
+    //remember the last one we encountered
+    last_lon = lon;
+    last_lat = lat;
+  }
+}
+
+//a buffer for encode_points that writes straight into a string, growing it
+//when a point might not fit
+struct string_buffer_t {
+  std::string& output;
+  size_t size;
+  char* room() {
+    if (size + kMaxPointBytes + sizeof(uint64_t) > output.size())
+      output.resize(output.size() * 2 + kMaxPointBytes + sizeof(uint64_t));
+    return &output[size];
+  }
+  void used(const char* end) {
+    size = end - output.data();
+  }
+};
+
+//a buffer for encode_points that copies each point to an output iterator
+template <class output_t>
+struct iterator_buffer_t {
+  output_t& out;
+  char bytes[kMaxPointBytes + sizeof(uint64_t)];
+  char* room() {
+    return bytes;
+  }
+  void used(const char* end) {
+    out = std::copy(static_cast<const char*>(bytes), end, out);
+  }
+};
+
+//turn the numbers of an encoded polyline that has already been validated back
+//into coordinates, calling the sink with each lon,lat pair of scaled integers.
+//the string is done in blocks of 64 bytes, the ends of all numbers in a block
+//are found at once and each number is gathered from the word at its start
+template <class sink_t>
+void decode_points(const char* p, const char* end, sink_t sink) {
+  int last_lon = 0, last_lat = 0;
+  bool lat_done = false;
+  //the number being read starts here
+  const char* start = p;
+  auto block = [&](const char* base, uint64_t ends) {
+    for (; ends != 0; ends &= ends - 1) {
+      const char* stop = base + __builtin_ctzll(ends) + 1;
+      size_t bytes = stop - start;
+      if (bytes > kMaxNumberBytes)
+        throw std::runtime_error("Encoded polyline has a number that is too long");
+      int number = unzigzag(deserialize(start, bytes));
+      start = stop;
+      //decode the coordinates, lat first for some reason
+      if (lat_done) {
+        last_lon = add(last_lon, number);
+        sink(last_lon, last_lat);
+      } else {
+        last_lat = add(last_lat, number);
+      }
+      lat_done = !lat_done;
+    }
+  };
+
+  //blocks whose numbers can be read in place, a number starting at the end of
+  //one is read as a whole word
+  const char* base = p;
+  for (; end - base >= static_cast<ptrdiff_t>(64 + sizeof(uint64_t)); base += 64)
+    block(base, last_chunks(base));
+  if (base - start > static_cast<ptrdiff_t>(kMaxNumberBytes))
+    throw std::runtime_error("Encoded polyline has a number that is too long");
+
+  //the rest of the string from the number being read is copied to a buffer
+  //with room to read past it. the padding is never the end of a number
+  char tail[2 * 64 + sizeof(uint64_t)];
+  std::memset(tail, 63 + 0x20, sizeof(tail));
+  std::memcpy(tail, start, end - start);
+  const char* tail_end = tail + (end - start);
+  start = tail;
+  for (base = tail; base < tail_end; base += 64)
+    block(base, last_chunks(base));
+}
+
+//shift the decimal point back to the left
+template <class T>
+T unscale(const int value, const double inverse) {
+  return static_cast<T>(static_cast<double>(value) * inverse);
+}
+
+//reserve room in containers that have a reserve
+template <class container_t>
+auto reserve(container_t& container, const size_t size, int) -> decltype(container.reserve(size), void()) {
+  container.reserve(size);
+}
+template <class container_t>
+void reserve(container_t&, const size_t, long) {
+}
+
+}
+
+/**
+ * Polyline encode a container of points into a string
+ * Note: newer versions of this algorithm allow one to specify a zoom level
+ * which allows displaying simplified versions of the encoded linestring
+ *
+ * @param points    the list of points to encode, anything with first (lng)
+ *                  and second (lat) members
+ * @param precision the decimal digits to keep, 6 or 5 for Google's encoding
+ * @return string   the encoded container of points
+ */
+template<class container_t>
+std::string encode(const container_t& points, const int precision = kPolylinePrecision) {
+  //a place to keep the output, its written through a pointer and grown when a
+  //point might not fit. unless the shape is very course you should probably
+  //only need about 3 bytes per coord, which is 6 bytes with 2 coords, so we
+  //overshoot to 8 just in case
+  std::string output(points.size() * 8, '\0');
+  encoding::string_buffer_t buffer{ output, 0 };
+  encoding::encode_points(points.begin(), points.end(), precision, buffer);
+  output.resize(buffer.size);
+  return output;
+}
+
+/**
+ * Polyline encode a range of points into an output iterator of characters,
+ * for example a back inserter of a container other than a string
+ *
+ * @param begin     the first point to encode
+ * @param end       past the last point to encode
+ * @param out       where to write the characters
+ * @param precision the decimal digits to keep, 6 or 5 for Google's encoding
+ * @return out      past the last character written
+ */
+template <class iterator_t, class output_t>
+output_t encode_into(const iterator_t begin, const iterator_t end, output_t out,
+                     const int precision = kPolylinePrecision) {
+  encoding::iterator_buffer_t<output_t> buffer{ out, {} };
+  encoding::encode_points(begin, end, precision, buffer);
+  return out;
+}
+
+/**
+ * Polyline decode a string into a container of points
+ *
+ * @param encoded   the encoded points
+ * @param precision the decimal digits that were kept
+ * @return points   the container of points, anything with emplace_back and
+ *                  a value_type with first_type and second_type
+ * @throws std::runtime_error if the string is not an encoded polyline
+ */
+template<class container_t>
+container_t decode(const std::string& encoded, const int precision = kPolylinePrecision) {
+  typedef typename container_t::value_type point_t;
+  const double inverse = 1.0 / encoding::scale(precision);
+  container_t output;
+  encoding::reserve(output, decoded_size(encoded), 0);
+  encoding::decode_points(encoded.data(), encoded.data() + encoded.size(),
+                          [&output, inverse](const int lon, const int lat) {
+    output.emplace_back(encoding::unscale<typename point_t::first_type>(lon, inverse),
+                        encoding::unscale<typename point_t::second_type>(lat, inverse));
+  });
+  return output;
+}
+
+/**
+ * Polyline decode a string into an output iterator of points, for example a
+ * back inserter of an arena backed container, without a container between
+ *
+ * @param encoded   the encoded points
+ * @param out       where to write the points, point_t(lng, lat) each
+ * @param precision the decimal digits that were kept
+ * @return out      past the last point written
+ * @throws std::runtime_error if the string is not an encoded polyline
+ */
+template <class point_t = PointLL, class output_t>
+output_t decode_into(const std::string& encoded, output_t out,
+                     const int precision = kPolylinePrecision) {
+  const double inverse = 1.0 / encoding::scale(precision);
+  decoded_size(encoded);
+  encoding::decode_points(encoded.data(), encoded.data() + encoded.size(),
+                          [&out, inverse](const int lon, const int lat) {
+    *out = point_t(encoding::unscale<typename point_t::first_type>(lon, inverse),
+                   encoding::unscale<typename point_t::second_type>(lat, inverse));
+    ++out;
+  });
+  return out;
+}
+
+/**
+ * Polyline decode a string calling a function with each point
+ *
+ * @param encoded   the encoded points
+ * @param sink      called with the longitude and latitude of each point as
+ *                  doubles, in order
+ * @param precision the decimal digits that were kept
+ * @throws std::runtime_error if the string is not an encoded polyline
+ */
+template <class sink_t>
+void decode_each(const std::string& encoded, sink_t sink, const int precision = kPolylinePrecision) {
+  const double inverse = 1.0 / encoding::scale(precision);
+  decoded_size(encoded);
+  encoding::decode_points(encoded.data(), encoded.data() + encoded.size(),
+                          [&sink, inverse](const int lon, const int lat) {
+    sink(encoding::unscale<double>(lon, inverse), encoding::unscale<double>(lat, inverse));
+  });
+}
+
+/**
+ * Polyline decode a string into a vector of points, replacing its contents.
+ * The vector's memory is reused so decoding many polylines into the same
+ * vector only allocates when one is larger than any before it
+ *
+ * @param encoded   the encoded points
+ * @param points    the vector to decode into
+ * @param precision the decimal digits that were kept
+ * @throws std::runtime_error if the string is not an encoded polyline
+ */
+void decode(const std::string& encoded, std::vector<PointLL>& points,
+            const int precision = kPolylinePrecision);
+
+/**
+ * Polyline decode a string into a buffer of points
+ *
+ * @param encoded   the encoded points
+ * @param points    the buffer to decode into
+ * @param capacity  the number of points the buffer holds
+ * @param precision the decimal digits that were kept
+ * @return count    the number of points decoded
+ * @throws std::runtime_error if the string is not an encoded polyline or
+ *                            has more points than the buffer holds
+ */
+size_t decode(const std::string& encoded, PointLL* points, const size_t capacity,
+              const int precision = kPolylinePrecision);
+
+/**
+ * Polyline decode a string into separate buffers of longitudes and latitudes
+ *
+ * @param encoded   the encoded points
+ * @param lngs      the buffer to decode the longitudes into
+ * @param lats      the buffer to decode the latitudes into
+ * @param capacity  the number of values each buffer holds
+ * @param precision the decimal digits that were kept
+ * @return count    the number of points decoded
+ * @throws std::runtime_error if the string is not an encoded polyline or
+ *                            has more points than the buffers hold
+ */
+size_t decode(const std::string& encoded, float* lngs, float* lats, const size_t capacity,
+              const int precision = kPolylinePrecision);
+
+}
+}
+
+#endif  // VALHALLA_MIDGARD_ENCODED_H_
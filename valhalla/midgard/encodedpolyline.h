@@ -0,0 +1,193 @@
+#ifndef VALHALLA_MIDGARD_ENCODEDPOLYLINE_H_
+#define VALHALLA_MIDGARD_ENCODEDPOLYLINE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+
+#include <valhalla/midgard/pointll.h>
+#include <valhalla/midgard/aabb2.h>
+#include <valhalla/midgard/encoded.h>
+
+namespace valhalla {
+namespace midgard {
+
+/**
+ * Polyline encoded string read in place. Points are decoded one at a time as
+ * the range is iterated so asking for the first point, the bounding box or
+ * the length of a shape needs no container of its points. The string is
+ * validated once on construction (see decoded_size in util.h), after which
+ * iterating cannot read past it. The range does not copy the string, which
+ * has to outlive it. Points are identical to those decode<> gives.
+ */
+class EncodedPolyline {
+ public:
+  /**
+   * Iterator over the points, decoding each when it is reached. Dereferencing
+   * gives the point by value as there is no point in memory to refer to.
+   */
+  class const_iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef PointLL value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const PointLL* pointer;
+    typedef PointLL reference;
+
+    const_iterator()
+      : current_(nullptr), next_(nullptr), end_(nullptr), inverse_(0.0), lng_(0), lat_(0) { }
+    const_iterator(const char* begin, const char* end, const double inverse)
+      : current_(begin), next_(begin), end_(end), inverse_(inverse), lng_(0), lat_(0) {
+      read();
+    }
+
+    PointLL operator*() const {
+      return PointLL(encoding::unscale<float>(lng_, inverse_),
+                     encoding::unscale<float>(lat_, inverse_));
+    }
+    const_iterator& operator++() {
+      current_ = next_;
+      read();
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator copy(*this);
+      ++*this;
+      return copy;
+    }
+    bool operator==(const const_iterator& other) const {
+      return current_ == other.current_;
+    }
+    bool operator!=(const const_iterator& other) const {
+      return current_ != other.current_;
+    }
+
+    // Coordinates of the current point as the encoded integers, scaled by
+    // 10 to the precision
+    int32_t lng_scaled() const { return lng_; }
+    int32_t lat_scaled() const { return lat_; }
+
+   protected:
+    // Decode the point starting at next_ unless the end was reached
+    void read() {
+      if (next_ != end_) {
+        lat_ = encoding::add(lat_, number());
+        lng_ = encoding::add(lng_, number());
+      }
+    }
+
+    // Decode one zig zag encoded offset, 5 bits per byte
+    int32_t number() {
+      uint32_t result = 0;
+      int byte, shift = 0;
+      do {
+        byte = static_cast<int>(*next_++) - 63;
+        result |= static_cast<uint32_t>(byte & 0x1f) << shift;
+        shift += 5;
+      } while (byte >= 0x20);
+      return static_cast<int32_t>(result & 1 ? ~(result >> 1) : (result >> 1));
+    }
+
+    // Bytes of the current point, of the next one and the end of the string
+    const char* current_;
+    const char* next_;
+    const char* end_;
+
+    // One over the scale of the integers
+    double inverse_;
+
+    // Current point
+    int32_t lng_;
+    int32_t lat_;
+  };
+
+  /**
+   * Constructor given an encoded string.
+   * @param  encoded    Polyline encoded string, it is not copied.
+   * @param  precision  Decimal digits that were kept.
+   * @throws std::runtime_error if the string is not an encoded polyline
+   */
+  explicit EncodedPolyline(const std::string& encoded,
+                           const int precision = kPolylinePrecision);
+
+  /**
+   * Constructor given encoded bytes, for example part of a larger buffer.
+   * @param  encoded    Polyline encoded bytes, they are not copied.
+   * @param  length     Number of bytes.
+   * @param  precision  Decimal digits that were kept.
+   * @throws std::runtime_error if the bytes are not an encoded polyline
+   */
+  EncodedPolyline(const char* encoded, const size_t length,
+                  const int precision = kPolylinePrecision);
+
+  /**
+   * Gets an iterator to the first point.
+   */
+  const_iterator begin() const;
+
+  /**
+   * Gets an iterator past the last point.
+   */
+  const_iterator end() const;
+
+  /**
+   * Gets the number of points, counted when the string was validated.
+   * @return  Returns the number of points.
+   */
+  size_t size() const;
+
+  /**
+   * Whether there are no points.
+   */
+  bool empty() const;
+
+  /**
+   * Gets the first point, decoding only it. The range must not be empty.
+   * @return  Returns the first point.
+   */
+  PointLL front() const;
+
+  /**
+   * Gets the last point. Points are stored as offsets to the one before so
+   * every offset is summed, but none is converted to a point.
+   * @return  Returns the last point.
+   */
+  PointLL back() const;
+
+  /**
+   * Gets the point at an index, decoding the points up to it.
+   * @param   i  Index of the point.
+   * @return  Returns the point.
+   * @throws std::out_of_range if there is no point at the index
+   */
+  PointLL at(const size_t i) const;
+
+  /**
+   * Gets the bounding box of the points. The box is computed on the
+   * integers of the encoding and converted once.
+   * @return  Returns the bounding box, all zeros if there are no points.
+   */
+  AABB2<PointLL> BoundingBox() const;
+
+  /**
+   * Gets the length of the polyline in meters, the same as length() of the
+   * decoded points.
+   * @return  Returns the length.
+   */
+  float Length() const;
+
+ protected:
+  // Encoded bytes and the number of points they hold
+  const char* begin_;
+  const char* end_;
+  size_t size_;
+
+  // One over the scale of the integers
+  double inverse_;
+};
+
+}
+}
+
+#endif  // VALHALLA_MIDGARD_ENCODEDPOLYLINE_H_
@@ -0,0 +1,118 @@
+#ifndef VALHALLA_MIDGARD_GEODISTANCE_H_
+#define VALHALLA_MIDGARD_GEODISTANCE_H_
+
+#include <cstdint>
+
+#include <valhalla/midgard/pointll.h>
+
+namespace valhalla {
+namespace midgard {
+
+/**
+ * Tiers of distance computation, from the cheapest to the most accurate.
+ */
+enum class DistanceTier : uint8_t {
+  kPlanar = 0,       // Flat earth with the ellipsoid's scales at the mid latitude
+  kSpherical = 1,    // Great circle on the sphere PointLL::Distance uses
+  kEllipsoidal = 2   // Geodesic on the WGS84 ellipsoid (Vincenty)
+};
+
+/**
+ * Distance in meters between two lat,lng positions in one of several tiers
+ * of accuracy, each with a bound on its error to the geodesic distance on
+ * the WGS84 ellipsoid. Call sites state how much error they can take and
+ * the cheapest tier that meets it is used rather than picking between
+ * DistanceApproximator and PointLL::Distance by hand.
+ *
+ * The error envelopes, all relative to the WGS84 geodesic distance d:
+ *   kPlanar       1e-6 d + ((dlat^2 + dlng^2) / 6) d with the deltas in
+ *                 radians, the error of treating the earth as flat grows
+ *                 with the square of the span. About 1e-6 d below 1 km,
+ *                 5e-5 d at 1 degree of span.
+ *   kSpherical    7e-3 d, the sphere has a single radius while the
+ *                 ellipsoid's radius of curvature is from 0.7% smaller (north
+ *                 south at the equator) to 0.3% larger (at the poles).
+ *   kEllipsoidal  1 mm, for points that are not nearly antipodal. Those get
+ *                 the spherical distance and so its envelope.
+ */
+class GeoDistance {
+ public:
+  /**
+   * Planar distance, the pythagorean theorem with the meridian and prime
+   * vertical radii of curvature of the ellipsoid at the mid latitude. This
+   * is DistanceApproximator's approximation with the ellipsoid's scales in
+   * place of a sphere's. Longitude deltas are wrapped so positions across
+   * 180 degrees longitude take the short way.
+   * @param  a  First position.
+   * @param  b  Second position.
+   * @return  Returns the distance in meters.
+   */
+  static double Planar(const PointLL& a, const PointLL& b);
+
+  /**
+   * Great circle distance on the sphere PointLL::Distance uses, computed
+   * with the haversine formula in double so short distances keep their
+   * precision.
+   * @param  a  First position.
+   * @param  b  Second position.
+   * @return  Returns the distance in meters.
+   */
+  static double Spherical(const PointLL& a, const PointLL& b);
+
+  /**
+   * Geodesic distance on the WGS84 ellipsoid using Vincenty's inverse
+   * formula. Vincenty does not converge for nearly antipodal points (within
+   * about half a degree of the antipode), those fall back to Spherical.
+   * @param  a  First position.
+   * @param  b  Second position.
+   * @return  Returns the distance in meters.
+   */
+  static double Ellipsoidal(const PointLL& a, const PointLL& b);
+
+  /**
+   * Distance computed in the given tier.
+   * @param  a     First position.
+   * @param  b     Second position.
+   * @param  tier  Tier to compute the distance in.
+   * @return  Returns the distance in meters.
+   */
+  static double Distance(const PointLL& a, const PointLL& b, const DistanceTier tier);
+
+  /**
+   * Distance computed in the cheapest tier whose error bound for these
+   * positions is within the tolerance. Nearly antipodal points have no
+   * ellipsoidal distance, if the spherical one is not within the tolerance
+   * it is returned anyway as the spherical tier.
+   * @param  a          First position.
+   * @param  b          Second position.
+   * @param  tolerance  Largest acceptable error in meters.
+   * @param  tier       Optional, set to the tier that was used.
+   * @return  Returns the distance in meters.
+   */
+  static double Distance(const PointLL& a, const PointLL& b, const double tolerance,
+                         DistanceTier* tier = nullptr);
+
+  /**
+   * Bound on the error of a distance computed in a tier, see the envelopes
+   * above. The distance the tier gave is used in place of the true one.
+   * @param  a         First position.
+   * @param  b         Second position.
+   * @param  tier      Tier the distance was computed in.
+   * @param  distance  Distance the tier gave, in meters.
+   * @return  Returns the largest error in meters.
+   */
+  static double MaxError(const PointLL& a, const PointLL& b, const DistanceTier tier,
+                         const double distance);
+
+ protected:
+  // Error of the planar tier relative to the distance
+  static double PlanarRelativeError(const PointLL& a, const PointLL& b);
+
+  // Vincenty's distance, false if it does not converge
+  static bool Vincenty(const PointLL& a, const PointLL& b, double& distance);
+};
+
+}
+}
+
+#endif  // VALHALLA_MIDGARD_GEODISTANCE_H_
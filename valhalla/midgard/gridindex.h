@@ -0,0 +1,336 @@
+#ifndef VALHALLA_MIDGARD_GRIDINDEX_H_
+#define VALHALLA_MIDGARD_GRIDINDEX_H_
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <valhalla/midgard/aabb2.h>
+#include <valhalla/midgard/tiles.h>
+#include <valhalla/midgard/util.h>
+
+namespace valhalla {
+namespace midgard {
+
+/**
+ * A uniform grid spatial index over the subdivisions of a tiling system.
+ * Payloads (edge ids for example) are stored per subdivision ("cell") in
+ * flat CSR style arrays: a sorted array of the occupied cells, an array of
+ * offsets into the payload array for each of those cells and the payload
+ * array itself. Only occupied cells are stored so memory is proportional to
+ * the data rather than to the size of the tiling system.
+ *
+ * The arrays can be serialized to a single buffer and used in place, for
+ * example from a memory mapped file, without copying. For that reason the
+ * payload type must be trivially copyable. It also has to be less than and
+ * equality comparable so query results can be deduplicated.
+ */
+template <class coord_t, class payload_t>
+class GridIndex {
+  static_assert(std::is_trivially_copyable<payload_t>::value,
+                "GridIndex requires trivially copyable payloads");
+ public:
+  /**
+   * Constructor. The index is empty until Build is called.
+   * @param  tiles  Tiling system (with subdivisions) to index into.
+   */
+  GridIndex(const Tiles<coord_t>& tiles)
+    : tiles_(tiles), cells_(nullptr), offsets_(nullptr), payloads_(nullptr),
+      ncells_(0) {
+  }
+
+  /**
+   * Constructor from a serialized index. The buffer is used in place so it
+   * must outlive this object and be aligned to at least 8 bytes.
+   * @param  buffer  Serialized index (see Serialize).
+   * @param  size    Size of the buffer in bytes.
+   */
+  GridIndex(const char* buffer, const size_t size)
+    : tiles_(header(buffer, size).tiles()), cells_(nullptr), offsets_(nullptr),
+      payloads_(nullptr), ncells_(0) {
+    const header_t& h = header(buffer, size);
+    ncells_ = h.ncells;
+    if (size < h.size())
+      throw std::runtime_error("GridIndex buffer is too small for its contents");
+    cells_ = reinterpret_cast<const uint64_t*>(buffer + sizeof(header_t));
+    offsets_ = reinterpret_cast<const uint32_t*>(cells_ + ncells_);
+    payloads_ = reinterpret_cast<const payload_t*>(buffer + h.payload_offset());
+  }
+
+  GridIndex(const GridIndex& other) : tiles_(other.tiles_) {
+    *this = other;
+  }
+
+  GridIndex& operator=(const GridIndex& other) {
+    tiles_ = other.tiles_;
+    staged_ = other.staged_;
+    owned_cells_ = other.owned_cells_;
+    owned_offsets_ = other.owned_offsets_;
+    owned_payloads_ = other.owned_payloads_;
+    ncells_ = other.ncells_;
+    // Point at our own copy unless the other index refers to a buffer
+    bool owned = other.cells_ == other.owned_cells_.data();
+    cells_ = owned ? owned_cells_.data() : other.cells_;
+    offsets_ = owned ? owned_offsets_.data() : other.offsets_;
+    payloads_ = owned ? owned_payloads_.data() : other.payloads_;
+    return *this;
+  }
+
+  /**
+   * Get the tiling system this index is over.
+   * @return  Returns the tiles.
+   */
+  const Tiles<coord_t>& tiles() const {
+    return tiles_;
+  }
+
+  /**
+   * Stage a linestring to be added to the index. The linestring is
+   * rasterized into the cells it passes through. Nothing is queryable until
+   * Build is called.
+   * @param  payload     Payload to store in each cell the linestring touches.
+   * @param  linestring  List of points.
+   */
+  template <class container_t>
+  void Add(const payload_t& payload, const container_t& linestring) {
+    uint64_t cells_per_tile = sqr(static_cast<uint64_t>(tiles_.nsubdivisions()));
+    for (const auto& tile : tiles_.Intersect(linestring)) {
+      for (const auto subdivision : tile.second)
+        staged_.emplace_back(tile.first * cells_per_tile + subdivision, payload);
+    }
+  }
+
+  /**
+   * Build the flat arrays from everything staged so far (and whatever was
+   * already built). Duplicate payloads within a cell are removed.
+   */
+  void Build() {
+    // Keep what was already built
+    for (size_t i = 0; i < ncells_; ++i) {
+      for (uint32_t j = offsets_[i]; j < offsets_[i + 1]; ++j)
+        staged_.emplace_back(cells_[i], payloads_[j]);
+    }
+
+    // Group by cell
+    std::sort(staged_.begin(), staged_.end());
+    staged_.erase(std::unique(staged_.begin(), staged_.end()), staged_.end());
+
+    // Lay out the cells, their offsets and the payloads
+    owned_cells_.clear();
+    owned_offsets_.clear();
+    owned_payloads_.clear();
+    owned_payloads_.reserve(staged_.size());
+    for (const auto& entry : staged_) {
+      if (owned_cells_.empty() || owned_cells_.back() != entry.first) {
+        owned_cells_.push_back(entry.first);
+        owned_offsets_.push_back(owned_payloads_.size());
+      }
+      owned_payloads_.push_back(entry.second);
+    }
+    owned_offsets_.push_back(owned_payloads_.size());
+    staged_.clear();
+    staged_.shrink_to_fit();
+
+    cells_ = owned_cells_.data();
+    offsets_ = owned_offsets_.data();
+    payloads_ = owned_payloads_.data();
+    ncells_ = owned_cells_.size();
+  }
+
+  /**
+   * Get the number of occupied cells.
+   * @return  Returns the number of cells with at least one payload.
+   */
+  size_t cell_count() const {
+    return ncells_;
+  }
+
+  /**
+   * Get the payloads stored in a cell.
+   * @param  tileid       Tile Id.
+   * @param  subdivision  Subdivision within the tile.
+   * @return  Returns the payloads of the cell (empty if none).
+   */
+  iterable_t<const payload_t> Cell(const int32_t tileid, const unsigned short subdivision) const {
+    uint64_t key = tileid * sqr(static_cast<uint64_t>(tiles_.nsubdivisions())) + subdivision;
+    const uint64_t* cell = std::lower_bound(cells_, cells_ + ncells_, key);
+    if (cell == cells_ + ncells_ || *cell != key)
+      return iterable_t<const payload_t>(payloads_, size_t(0));
+    size_t i = cell - cells_;
+    return iterable_t<const payload_t>(payloads_ + offsets_[i], payloads_ + offsets_[i + 1]);
+  }
+
+  /**
+   * Get the payloads of all cells intersecting a bounding box.
+   * @param  boundingbox  Bounding box.
+   * @return  Returns the unique payloads, sorted.
+   */
+  std::vector<payload_t> Query(const AABB2<coord_t>& boundingbox) const {
+    std::vector<payload_t> result;
+    const auto bounds = tiles_.TileBounds();
+    if (ncells_ == 0 || !bounds.Intersects(boundingbox))
+      return result;
+
+    // Range of cells in the whole grid covered by the bounding box
+    int32_t nsub = tiles_.nsubdivisions();
+    float cellsize = tiles_.TileSize() / nsub;
+    auto cell_col = [&](float x) {
+      return clamp(static_cast<int32_t>((clamp<float>(x, bounds.minx(), bounds.maxx()) -
+                   bounds.minx()) / cellsize), 0, tiles_.ncolumns() * nsub - 1);
+    };
+    auto cell_row = [&](float y) {
+      return clamp(static_cast<int32_t>((clamp<float>(y, bounds.miny(), bounds.maxy()) -
+                   bounds.miny()) / cellsize), 0, tiles_.nrows() * nsub - 1);
+    };
+    int32_t mincol = cell_col(boundingbox.minx()), maxcol = cell_col(boundingbox.maxx());
+    int32_t minrow = cell_row(boundingbox.miny()), maxrow = cell_row(boundingbox.maxy());
+
+    // Walk the occupied cells of each tile in range
+    uint64_t cells_per_tile = sqr(static_cast<uint64_t>(nsub));
+    for (int32_t row = minrow / nsub; row <= maxrow / nsub; ++row) {
+      for (int32_t col = mincol / nsub; col <= maxcol / nsub; ++col) {
+        uint64_t first = tiles_.TileId(col, row) * cells_per_tile;
+        for (const uint64_t* cell = std::lower_bound(cells_, cells_ + ncells_, first);
+             cell != cells_ + ncells_ && *cell < first + cells_per_tile; ++cell) {
+          int32_t subdivision = *cell - first;
+          int32_t x = col * nsub + subdivision % nsub;
+          int32_t y = row * nsub + subdivision / nsub;
+          if (x < mincol || x > maxcol || y < minrow || y > maxrow)
+            continue;
+          size_t i = cell - cells_;
+          result.insert(result.end(), payloads_ + offsets_[i], payloads_ + offsets_[i + 1]);
+        }
+      }
+    }
+    return unique(result);
+  }
+
+  /**
+   * Get the payloads of all cells within a radius of a point. For PointLL
+   * the radius is in meters.
+   * @param  center  Center of the search.
+   * @param  radius  Search radius.
+   * @return  Returns the unique payloads, sorted.
+   */
+  std::vector<payload_t> Query(const coord_t& center, const float radius) const {
+    std::vector<payload_t> result;
+    if (ncells_ == 0)
+      return result;
+
+    // Visit cells closest first until they are too far away
+    auto next = tiles_.ClosestFirst(center, true);
+    while (true) {
+      auto cell = next();
+      if (std::get<0>(cell) == -1 || std::get<2>(cell) > radius)
+        break;
+      for (const auto& payload : Cell(std::get<0>(cell), std::get<1>(cell)))
+        result.push_back(payload);
+    }
+    return unique(result);
+  }
+
+  /**
+   * Serialize the index into a buffer which can be written to disk and later
+   * used in place with the buffer constructor.
+   * @return  Returns the serialized index.
+   */
+  std::string Serialize() const {
+    header_t h;
+    h.set(tiles_, ncells_, ncells_ ? offsets_[ncells_] : 0);
+    std::string buffer(h.size(), '\0');
+    std::memcpy(&buffer[0], &h, sizeof(h));
+    std::memcpy(&buffer[sizeof(h)], cells_, ncells_ * sizeof(uint64_t));
+    if (ncells_) {
+      std::memcpy(&buffer[sizeof(h) + ncells_ * sizeof(uint64_t)], offsets_,
+                  (ncells_ + 1) * sizeof(uint32_t));
+      std::memcpy(&buffer[h.payload_offset()], payloads_, h.npayloads * sizeof(payload_t));
+    }
+    return buffer;
+  }
+
+ protected:
+  // Fixed size header at the start of a serialized index
+  struct header_t {
+    uint64_t magic;
+    float minx, miny, maxx, maxy;
+    float tilesize;
+    uint32_t nsubdivisions;
+    uint32_t payload_size;
+    uint32_t ncells;
+    uint64_t npayloads;
+
+    static constexpr uint64_t kMagic = 0x5844495244494d47;  // "GMIDRIDX"
+
+    void set(const Tiles<coord_t>& tiles, uint32_t cells, uint64_t payloads) {
+      magic = kMagic;
+      auto bounds = tiles.TileBounds();
+      minx = bounds.minx();
+      miny = bounds.miny();
+      maxx = bounds.maxx();
+      maxy = bounds.maxy();
+      tilesize = tiles.TileSize();
+      nsubdivisions = tiles.nsubdivisions();
+      payload_size = sizeof(payload_t);
+      ncells = cells;
+      npayloads = payloads;
+    }
+
+    Tiles<coord_t> tiles() const {
+      return Tiles<coord_t>(AABB2<coord_t>(minx, miny, maxx, maxy), tilesize, nsubdivisions);
+    }
+
+    // Payloads start on an 8 byte boundary after the cells and offsets
+    size_t payload_offset() const {
+      size_t offset = sizeof(header_t) + ncells * sizeof(uint64_t) +
+                      (ncells ? ncells + 1 : 0) * sizeof(uint32_t);
+      return (offset + 7) & ~size_t(7);
+    }
+
+    size_t size() const {
+      return payload_offset() + npayloads * sizeof(payload_t);
+    }
+  };
+
+  static const header_t& header(const char* buffer, const size_t size) {
+    if (size < sizeof(header_t))
+      throw std::runtime_error("GridIndex buffer is too small for its header");
+    const header_t& h = *reinterpret_cast<const header_t*>(buffer);
+    if (h.magic != header_t::kMagic || h.payload_size != sizeof(payload_t))
+      throw std::runtime_error("GridIndex buffer is not an index of this payload type");
+    return h;
+  }
+
+  static std::vector<payload_t>& unique(std::vector<payload_t>& payloads) {
+    std::sort(payloads.begin(), payloads.end());
+    payloads.erase(std::unique(payloads.begin(), payloads.end()), payloads.end());
+    return payloads;
+  }
+
+  // Tiling system the cells belong to
+  Tiles<coord_t> tiles_;
+
+  // Cell, payload pairs waiting for Build
+  std::vector<std::pair<uint64_t, payload_t> > staged_;
+
+  // Flat arrays built by Build
+  std::vector<uint64_t> owned_cells_;
+  std::vector<uint32_t> owned_offsets_;
+  std::vector<payload_t> owned_payloads_;
+
+  // The arrays in use, either the ones above or a serialized buffer. Cells
+  // are keyed by tile Id * subdivisions^2 + subdivision
+  const uint64_t* cells_;
+  const uint32_t* offsets_;
+  const payload_t* payloads_;
+  size_t ncells_;
+};
+
+}
+}
+
+#endif  // VALHALLA_MIDGARD_GRIDINDEX_H_
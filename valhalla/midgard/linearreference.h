@@ -0,0 +1,126 @@
+#ifndef VALHALLA_MIDGARD_LINEARREFERENCE_H_
+#define VALHALLA_MIDGARD_LINEARREFERENCE_H_
+
+#include <vector>
+#include <cstdint>
+
+#include <valhalla/midgard/pointll.h>
+
+namespace valhalla {
+namespace midgard {
+
+/**
+ * Linear referencing along a polyline of lat,lng points. The distance from
+ * the start to every vertex (the measure of the vertex) is computed once
+ * with PointLL::Distance, the same way PointLL::HeadingAlongPolyline and
+ * length() do. Queries by measure then binary search the cumulative
+ * distances instead of walking the shape and recomputing every segment,
+ * which pays off as soon as a shape is queried more than once (guidance
+ * asks for several headings per edge for example).
+ *
+ * Measures are in meters from the start of the polyline. Measures before
+ * the start or past the end are clamped to the start or end. Points
+ * between vertices are interpolated linearly in lat,lng like
+ * PointLL::HeadingAlongPolyline does.
+ */
+class LinearReference {
+ public:
+  /**
+   * Constructor given a list of points. Computes the measure of each vertex.
+   * @param  pts  Polyline - list of lat,lng points.
+   */
+  LinearReference(const std::vector<PointLL>& pts);
+
+  /**
+   * Gets the list of points.
+   * @return  Returns the list of points.
+   */
+  const std::vector<PointLL>& pts() const;
+
+  /**
+   * Gets the measure of every vertex, the distance along the polyline from
+   * the start to the vertex. The first is 0 and the last is Length().
+   * @return  Returns the measures, one per vertex.
+   */
+  const std::vector<double>& measures() const;
+
+  /**
+   * Gets the length of the polyline.
+   * @return  Returns the length in meters.
+   */
+  float Length() const;
+
+  /**
+   * Find the segment the measure falls on, the segment i where the measure
+   * of vertex i is at most m and the measure of vertex i + 1 is more than
+   * m. Measures at or past the end give the last segment that has a length.
+   * @param  m  Measure in meters.
+   * @return  Returns the index of the segment or -1 if there are fewer than
+   *          2 points.
+   */
+  int Segment(const float m) const;
+
+  /**
+   * Get the point at a measure.
+   * @param  m  Measure in meters.
+   * @return  Returns the point at the measure.
+   */
+  PointLL PointAt(const float m) const;
+
+  /**
+   * Get the heading of the polyline at a measure, the heading of the
+   * segment the measure falls on.
+   * @param  m  Measure in meters.
+   * @return  Returns the heading in degrees, 0 if the polyline has no length.
+   */
+  float HeadingAt(const float m) const;
+
+  /**
+   * Calculate the heading from the start of the polyline to the point at
+   * a measure. Same as PointLL::HeadingAlongPolyline.
+   * @param  dist  Distance in meters from start to find heading to.
+   * @return  Returns the heading in degrees.
+   */
+  float HeadingAlong(const float dist) const;
+
+  /**
+   * Calculate the heading from the point at a distance from the end of the
+   * polyline to the end point. Same as PointLL::HeadingAtEndOfPolyline.
+   * @param  dist  Distance in meters from the end.
+   * @return  Returns the heading in degrees.
+   */
+  float HeadingAtEnd(const float dist) const;
+
+  /**
+   * Get the part of the polyline between two measures.
+   * @param  from  Measure of the start of the part.
+   * @param  to    Measure of the end of the part.
+   * @return  Returns the points at from and to with the vertices between
+   *          them. Empty if from is past to.
+   */
+  std::vector<PointLL> Substring(const float from, const float to) const;
+
+  /**
+   * Project a point onto the polyline: the measure of the closest point of
+   * the polyline to it (see PointLL::ClosestPoint).
+   * @param  pt  Point to project.
+   * @return  Returns the measure of the closest point in meters.
+   */
+  float Project(const PointLL& pt) const;
+
+ protected:
+  // Vertices of the polyline
+  std::vector<PointLL> pts_;
+
+  // Distance from the start to each vertex. Accumulated in double like the
+  // polyline walks in PointLL
+  std::vector<double> measures_;
+
+  // Interpolate along segment i at a measure on it
+  PointLL Interpolate(const int i, const double m) const;
+};
+
+}
+}
+
+#endif  // VALHALLA_MIDGARD_LINEARREFERENCE_H_
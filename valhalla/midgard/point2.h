@@ -13,21 +13,49 @@ class Vector2;
 
 /**
  * 2D Point (cartesian). float x,y components.
+ *
+ * Points are trivially copyable, standard layout and 8 bytes so containers
+ * of them can be copied with memcpy, stored in a sequence or memory mapped.
+ * There are no virtual methods, PointLL hides the methods whose behavior is
+ * spherical rather than overriding them. Templates pick between planar and
+ * spherical behavior at compile time using IsSpherical.
+ * The components keep the first and second names of the std::pair the
+ * class used to derive from.
  * @author David W. Nesbitt
  */
-class Point2 : public std::pair<float, float>{
+class Point2 {
 
  public:
+  using first_type = float;
+  using second_type = float;
 
   /**
-   * Use the constructors provided by pair
+   * Default constructor. Sets the point to 0,0.
    */
-  using std::pair<float, float>::pair;
+  constexpr Point2() : first(0.0f), second(0.0f) {
+  }
 
   /**
-   * Destructor
+   * Constructor with x,y components.
+   * @param  x  x coordinate.
+   * @param  y  y coordinate.
    */
-  virtual ~Point2();
+  constexpr Point2(const float x, const float y) : first(x), second(y) {
+  }
+
+  /**
+   * Constructor from a pair of x,y components.
+   * @param  p  Pair of x,y coordinates.
+   */
+  constexpr Point2(const std::pair<float, float>& p) : first(p.first), second(p.second) {
+  }
+
+  /**
+   * Conversion to a pair of x,y components.
+   */
+  operator std::pair<float, float>() const {
+    return std::make_pair(first, second);
+  }
 
   /**
    * Get the x component.
@@ -58,7 +86,7 @@ class Point2 : public std::pair<float, float>{
    * @param   x   x coordinate position.
    * @param   y   y coordinate position.
    */
-  virtual void Set(const float x, const float y);
+  void Set(const float x, const float y);
 
   /**
    * Equality approximation.
@@ -72,14 +100,14 @@ class Point2 : public std::pair<float, float>{
    * @param   p  Other point.
    * @return  Returns the distance squared between this point and p.
    */
-  virtual float DistanceSquared(const Point2& p) const;
+  float DistanceSquared(const Point2& p) const;
 
   /**
    * Get the distance from this point to point p.
    * @param   p  Other point.
    * @return  Returns the distance between this point and p.
    */
-  virtual float Distance(const Point2& p) const;
+  float Distance(const Point2& p) const;
 
   /**
    * Affine combination of this point with another point. 2 scalars are
@@ -137,7 +165,7 @@ class Point2 : public std::pair<float, float>{
    * @param  p2  End point of the segment.
    * @return  Returns true if this point is left of the segment.
    */
-  virtual bool IsLeft(const Point2& p1, const Point2& p2) const;
+  bool IsLeft(const Point2& p1, const Point2& p2) const;
 
   /**
    * Tests whether this point is within a convex polygon.
@@ -148,7 +176,7 @@ class Point2 : public std::pair<float, float>{
    *                  Last vertex is not equal to the first.
    * @return  Returns true if the point is within the polygon, false if not.
    */
-  virtual bool WithinConvexPolygon(const std::vector<Point2>& poly) const;
+  bool WithinConvexPolygon(const std::vector<Point2>& poly) const;
 
   /**
    * Handy for templated functions that use both Point2 or PointLL to know whether or not
@@ -156,11 +184,37 @@ class Point2 : public std::pair<float, float>{
    *
    * @return true if the system is spherical false if not
    */
-  static bool IsSpherical();
+  static constexpr bool IsSpherical() {
+    return false;
+  }
 
- protected:
+  // x and y components
+  float first;
+  float second;
 };
 
+/**
+ * Comparison operators. Like std::pair they compare x and then y.
+ */
+inline bool operator == (const Point2& a, const Point2& b) {
+  return a.first == b.first && a.second == b.second;
+}
+inline bool operator != (const Point2& a, const Point2& b) {
+  return !(a == b);
+}
+inline bool operator < (const Point2& a, const Point2& b) {
+  return a.first < b.first || (!(b.first < a.first) && a.second < b.second);
+}
+inline bool operator > (const Point2& a, const Point2& b) {
+  return b < a;
+}
+inline bool operator <= (const Point2& a, const Point2& b) {
+  return !(b < a);
+}
+inline bool operator >= (const Point2& a, const Point2& b) {
+  return !(a < b);
+}
+
 }
 }
 
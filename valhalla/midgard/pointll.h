@@ -15,10 +15,17 @@ namespace midgard {
 class PointLL : public Point2 {
  public:
   /**
-   * Use the constructors provided by pair
+   * Use the constructors provided by Point2
    */
   using Point2::Point2;
 
+  /**
+   * Conversion from a Point2 (lng,lat).
+   * @param  p  Point with x as longitude and y as latitude.
+   */
+  constexpr PointLL(const Point2& p) : Point2(p) {
+  }
+
   /**
    * Default constructor.  Sets latitude and longitude to INVALID.
    */
@@ -100,6 +107,42 @@ class PointLL : public Point2 {
    */
   std::tuple<PointLL, float, int> ClosestPoint(const std::vector<PointLL>& pts) const;
 
+  /**
+   * Finds the closest point on the supplied polyline to each of a list of
+   * points. Gives the same results as calling ClosestPoint for each point
+   * but scores several points at a time, useful when many points (GPS
+   * traces for example) are scored against one shape.
+   * @param  points  Points to find the closest points to.
+   * @param  pts     List of points on the polyline.
+   * @return  Returns a ClosestPoint tuple for each of the points.
+   */
+  static std::vector<std::tuple<PointLL, float, int> > ClosestPoints(
+      const std::vector<PointLL>& points, const std::vector<PointLL>& pts);
+
+  /**
+   * Calculates the distance in meters between each pair of consecutive
+   * points, several pairs at a time. Uses the haversine formula in float
+   * with polynomial approximations of the trig functions on the same sphere
+   * as Distance. The relative error to the exact spherical distance is
+   * under 5e-7 below 60 degrees of latitude and under 5e-6 below 85 degrees,
+   * growing toward the poles where cos(latitude) vanishes. Distance rounds
+   * its angles to float radians and is only good to about a meter, so the
+   * two differ by up to 5e-6 of the distance plus 1 meter.
+   * @param  pts  List of points.
+   * @return  Returns pts.size() - 1 distances, distance i is between point
+   *          i and point i + 1.
+   */
+  static std::vector<float> Distances(const std::vector<PointLL>& pts);
+
+  /**
+   * Calculates the distance in meters along a list of points to each point,
+   * the prefix sums of Distances. Sums are kept in double so the error of
+   * each measure is bounded by that of the distances it adds up.
+   * @param  pts  List of points.
+   * @return  Returns pts.size() measures, the first one is 0.
+   */
+  static std::vector<double> CumulativeDistances(const std::vector<PointLL>& pts);
+
   /**
    * Calculate the heading from the start of a polyline of lat,lng points to a
    * point at the specified distance from the start.
@@ -125,7 +168,7 @@ class PointLL : public Point2 {
    * @param  p2  End point of the segment.
    * @return  Returns true if this point is left of the segment.
    */
-  virtual bool IsLeft(const PointLL& p1, const PointLL& p2) const;
+  bool IsLeft(const PointLL& p1, const PointLL& p2) const;
 
   /**
    * Tests whether this point is within a convex polygon.
@@ -136,7 +179,7 @@ class PointLL : public Point2 {
    *                  Last vertex is not equal to the first.
    * @return  Returns true if the point is within the polygon, false if not.
    */
-  virtual bool WithinConvexPolygon(const std::vector<PointLL>& poly) const;
+  bool WithinConvexPolygon(const std::vector<PointLL>& poly) const;
 
   /**
    * Handy for templated functions that use both Point2 or PointLL to know whether or not
@@ -144,7 +187,9 @@ class PointLL : public Point2 {
    *
    * @return true if the system is spherical false if not
    */
-  static bool IsSpherical();
+  static constexpr bool IsSpherical() {
+    return true;
+  }
 };
 
 }
@@ -7,6 +7,8 @@
 #include <valhalla/midgard/linesegment2.h>
 
 #include <tuple>
+#include <vector>
+#include <utility>
 
 namespace valhalla {
 namespace midgard {
@@ -81,6 +83,64 @@ class Polyline2 {
    */
   Polyline2 GeneralizedPolyline(const float t);
 
+  /**
+   * Compute the significance of every vertex: the squared Douglas-Peucker
+   * tolerance at or above which Generalize drops the vertex. Every vertex
+   * is found with one full Douglas-Peucker pass, after that generalizing
+   * the same polyline at any number of tolerances is a linear filter (see
+   * the Generalize and GeneralizedPolyline overloads taking significance).
+   * The end points are never dropped and have infinite significance.
+   * @return  Returns the significance of each vertex.
+   */
+  std::vector<float> Significance() const;
+
+  /**
+   * Generalize this polyline using precomputed significance. Same result as
+   * Generalize(t), done in place without allocating.
+   * @param  t             Generalization tolerance.
+   * @param  significance  Significance of each vertex of this polyline.
+   * @return  Returns the number of points in the generalized polyline.
+   */
+  uint32_t Generalize(const float t, const std::vector<float>& significance);
+
+  /**
+   * Get a generalized polyline from this polyline using precomputed
+   * significance. Same result as GeneralizedPolyline(t).
+   * @param  t             Generalization tolerance.
+   * @param  significance  Significance of each vertex of this polyline.
+   * @return   Returns the generalized polyline.
+   */
+  Polyline2 GeneralizedPolyline(const float t, const std::vector<float>& significance) const;
+
+  /**
+   * Compute the effective area of every vertex with Visvalingam-Whyatt:
+   * vertices are removed one at a time, always the one forming the
+   * smallest triangle with its neighbors, and a vertex's effective area is
+   * the area of its triangle when it is removed (never less than that of
+   * any vertex removed before it). Areas are in square meters for PointLL.
+   * The end points are never removed and have infinite area.
+   * @return  Returns the effective area of each vertex.
+   */
+  std::vector<float> EffectiveAreas() const;
+
+  /**
+   * Generalize this polyline with Visvalingam-Whyatt, removing every vertex
+   * whose effective area is less than the tolerance. Runs in O(n log n) on
+   * any shape, unlike Douglas-Peucker.
+   * @param  area  Area tolerance (square meters for PointLL).
+   * @return  Returns the number of points in the generalized polyline.
+   */
+  uint32_t GeneralizeByArea(const float area);
+
+  /**
+   * Generalize this polyline with Visvalingam-Whyatt down to a number of
+   * vertices, removing the least significant vertices first. Useful to
+   * bound the size of a shape without trying tolerances.
+   * @param  count  Number of vertices to keep, at least 2.
+   * @return  Returns the number of points in the generalized polyline.
+   */
+  uint32_t GeneralizeToCount(const uint32_t count);
+
   /**
    * Clip this polyline to the specified bounding box.
    * @param box  Bounding box to clip this polyline to.
@@ -101,16 +161,39 @@ protected:
 
   /**
    * Douglass-Peucker generalization. Finds the vertex farthest from the
-   * segment between vertices i and j and checks if this distance exceeds
-   * the tolerance. If the distance is less than the tolerance the segment
-   * i,j is added to the output list of generalized vertices.
+   * segment between the end points and splits there while the distance
+   * exceeds the tolerance. Uses an explicit stack rather than recursion so
+   * long or pathological shapes can't overflow the call stack, and writes
+   * the generalized vertices over pts_ in place.
+   * @param  t2 Tolerance (squared)
+   */
+  void DouglasPeucker(const float t2);
+
+  /**
+   * Find the vertex strictly between vertices i and j farthest from the
+   * segment ViVj.
    * @param  i  Index of the first vertex.
    * @param  j  Index of the second vertex.
-   * @param  t2 Tolerance (squared)
-   * @param  genpts List of generalized vertices.
+   * @return  Returns the index of the farthest vertex and its squared
+   *          distance, 0 and 0 if no vertex is off the segment.
    */
-  void DouglasPeucker(const uint32_t i, const uint32_t j,
-                      const float t2, std::vector<coord_t>& genpts);
+  std::pair<uint32_t, float> Farthest(const uint32_t i, const uint32_t j) const;
+
+  /**
+   * Visvalingam-Whyatt. Removes vertices smallest effective area first
+   * while more than count vertices are left and the smallest effective
+   * area is less than the tolerance.
+   * @param  area     Area tolerance.
+   * @param  count    Number of vertices to stop at.
+   * @param  areas    Output, effective area of each vertex. Vertices that
+   *                  were not removed keep their last triangle area.
+   * @param  removed  Output, whether each vertex was removed.
+   */
+  void VisvalingamWhyatt(const float area, const uint32_t count, std::vector<float>& areas,
+                         std::vector<bool>& removed) const;
+
+  // Remove the vertices flagged as removed, in place
+  uint32_t Remove(const std::vector<bool>& removed);
 };
 
 }
@@ -0,0 +1,152 @@
+#ifndef VALHALLA_MIDGARD_POLYLINESOA_H_
+#define VALHALLA_MIDGARD_POLYLINESOA_H_
+
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <cstdint>
+
+#include <valhalla/midgard/point2.h>
+#include <valhalla/midgard/pointll.h>
+#include <valhalla/midgard/aabb2.h>
+#include <valhalla/midgard/polyline2.h>
+#include <valhalla/midgard/util.h>
+
+namespace valhalla {
+namespace midgard {
+
+/**
+ * 2-D polyline stored as a structure of arrays: one aligned array of x
+ * (longitude) values and one of y (latitude) values. This layout lets the
+ * hot loops (length, closest point, bounding box and segment distances)
+ * process several vertices per instruction with SSE2 or AVX2. This is a
+ * template class that works with Point2 (Euclidean x,y) or PointLL
+ * (latitude,longitude). Distances for PointLL are in meters, closest point
+ * and segment distances use the same approximation as DistanceApproximator.
+ *
+ * The arrays are padded past the last vertex with copies of it so the
+ * kernels never need a scalar remainder loop: the padding only forms zero
+ * length segments.
+ */
+template <class coord_t>
+class PolylineSoA {
+ public:
+  PolylineSoA();
+
+  /**
+   * Constructor given a list of points.
+   * @param  pts  List of points.
+   */
+  PolylineSoA(const std::vector<coord_t>& pts);
+
+  /**
+   * Gets the number of vertices.
+   * @return  Returns the number of vertices.
+   */
+  size_t size() const;
+
+  /**
+   * Gets the x (longitude) values.
+   * @return  Returns a pointer to size() x values.
+   */
+  const float* x() const;
+
+  /**
+   * Gets the y (latitude) values.
+   * @return  Returns a pointer to size() y values.
+   */
+  const float* y() const;
+
+  /**
+   * Gets a vertex.
+   * @param  i  Index of the vertex.
+   * @return  Returns the vertex.
+   */
+  coord_t at(const size_t i) const;
+
+  /**
+   * Add a point to the polyline. Like Polyline2::Add the point is not added
+   * if it is equal to the current endpoint.
+   * @param  p  Point to add to the polyline.
+   */
+  void Add(const coord_t& p);
+
+  /**
+   * Gets the list of points.
+   * @return  Returns the vertices as a list of points.
+   */
+  std::vector<coord_t> pts() const;
+
+  /**
+   * Gets the polyline as a Polyline2.
+   * @return  Returns a Polyline2 with the same vertices.
+   */
+  Polyline2<coord_t> ToPolyline2() const;
+
+  /**
+   * Finds the length of the polyline by accumulating the length of all
+   * segments. For PointLL each segment uses an equirectangular distance
+   * (scaled by the cosine of its mid latitude) on the same sphere as
+   * PointLL::Distance rather than the law of cosines so it can be
+   * vectorized. For road length segments the two agree to well within 0.1%.
+   * @return  Returns the length of the polyline.
+   */
+  float Length() const;
+
+  /**
+   * Finds the closest point to the supplied point as well as the distance
+   * squared to that point and the index of the segment where the closest
+   * point lies. Same results as coord_t::ClosestPoint.
+   * @param   pt  Point to find the closest point on the polyline to.
+   * @return  tuple of <Closest point along the polyline,
+   *                    Distance squared (meters) of the closest point,
+   *                    Index of the segment of the polyline which contains
+   *                      the closest point >
+   */
+  std::tuple<coord_t, float, int> ClosestPoint(const coord_t& pt) const;
+
+  /**
+   * Gets the bounding box of the polyline.
+   * @return  Returns the bounding box of the vertices.
+   */
+  AABB2<coord_t> BoundingBox() const;
+
+  /**
+   * Get the squared distance of a range of vertices to a segment, like
+   * LineSegment2::DistanceSquared does for one point.
+   * @param  a      Start of the segment.
+   * @param  b      End of the segment.
+   * @param  begin  Index of the first vertex.
+   * @param  end    Index one past the last vertex.
+   * @param  d2     Output, end - begin squared distances.
+   */
+  void DistancesToSegment(const coord_t& a, const coord_t& b, const size_t begin,
+                          const size_t end, float* d2) const;
+
+  /**
+   * Find the vertex strictly between vertices i and j that is farthest from
+   * the segment between them. This is the inner loop of Douglas-Peucker.
+   * @param  i  Index of the first vertex.
+   * @param  j  Index of the last vertex.
+   * @return  Returns the index of the farthest vertex and its squared
+   *          distance. The index is 0 and the distance 0 if no vertex is
+   *          off the segment.
+   */
+  std::pair<uint32_t, float> FarthestFromSegment(const uint32_t i, const uint32_t j) const;
+
+ protected:
+  // Fill the padding after the last vertex
+  void pad();
+
+  // Number of vertices
+  size_t size_;
+
+  // Vertex components, padded past size_ with copies of the last vertex
+  std::vector<float, aligned_allocator<float, 32> > x_;
+  std::vector<float, aligned_allocator<float, 32> > y_;
+};
+
+}
+}
+
+#endif  // VALHALLA_MIDGARD_POLYLINESOA_H_
@@ -0,0 +1,75 @@
+#ifndef VALHALLA_MIDGARD_PREPAREDPOLYLINE_H_
+#define VALHALLA_MIDGARD_PREPAREDPOLYLINE_H_
+
+#include <vector>
+#include <tuple>
+#include <cstdint>
+
+#include <valhalla/midgard/point2.h>
+#include <valhalla/midgard/pointll.h>
+#include <valhalla/midgard/aabb2.h>
+
+namespace valhalla {
+namespace midgard {
+
+/**
+ * Polyline prepared for repeated closest point queries, for example many
+ * GPS points matched against one long shape. The constructor groups the
+ * segments into small blocks and builds a binary hierarchy of bounding
+ * boxes over them once. A query then visits the boxes nearest first and
+ * skips every box that cannot hold a closer point than the best one found
+ * so far, so on long shapes only a handful of blocks are looked at instead
+ * of every segment. This is a template class that works with Point2
+ * (Euclidean x,y) or PointLL (latitude,longitude).
+ */
+template <class coord_t>
+class PreparedPolyline {
+ public:
+  /**
+   * Constructor given a list of points. Builds the box hierarchy.
+   * @param  pts  List of points.
+   */
+  PreparedPolyline(const std::vector<coord_t>& pts);
+
+  /**
+   * Gets the list of points.
+   * @return  Returns the list of points.
+   */
+  const std::vector<coord_t>& pts() const;
+
+  /**
+   * Gets the bounding box of the polyline.
+   * @return  Returns the bounding box of all vertices.
+   */
+  AABB2<coord_t> BoundingBox() const;
+
+  /**
+   * Finds the closest point to the supplied point as well as the distance
+   * squared to that point and the index of the segment where the closest
+   * point lies. Same results as coord_t::ClosestPoint, including ties which
+   * go to the lowest segment index.
+   * @param   pt  Point to find the closest point on the polyline to.
+   * @return  tuple of <Closest point along the polyline,
+   *                    Distance squared (meters) of the closest point,
+   *                    Index of the segment of the polyline which contains
+   *                      the closest point >
+   */
+  std::tuple<coord_t, float, int> ClosestPoint(const coord_t& pt) const;
+
+ protected:
+  // Vertices of the polyline
+  std::vector<coord_t> pts_;
+
+  // Number of leaf blocks, a power of 2
+  uint32_t leaves_;
+
+  // Implicit binary tree of boxes: node 1 is the root, node n has children
+  // 2n and 2n+1 and leaf l is node leaves_ + l. Leaves past the last block
+  // are empty (inverted) boxes
+  std::vector<AABB2<coord_t> > nodes_;
+};
+
+}
+}
+
+#endif  // VALHALLA_MIDGARD_PREPAREDPOLYLINE_H_
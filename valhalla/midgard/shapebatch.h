@@ -0,0 +1,127 @@
+#ifndef VALHALLA_MIDGARD_SHAPEBATCH_H_
+#define VALHALLA_MIDGARD_SHAPEBATCH_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <valhalla/midgard/pointll.h>
+#include <valhalla/midgard/encoded.h>
+#include <valhalla/midgard/encodedpolyline.h>
+
+namespace valhalla {
+namespace midgard {
+
+/**
+ * Many shapes polyline encoded into one buffer, as the shapes of a matrix or
+ * batch route response. The text of shape i is the bytes of data from
+ * offsets[i] to offsets[i + 1], there is no string per shape.
+ */
+struct EncodedShapes {
+  std::string data;
+  std::vector<size_t> offsets;
+  int precision;
+
+  EncodedShapes() : offsets(1, 0), precision(kPolylinePrecision) { }
+
+  /**
+   * Gets the number of shapes.
+   */
+  size_t size() const { return offsets.size() - 1; }
+
+  /**
+   * Gets the text of a shape, as a copy.
+   * @param   i  Index of the shape.
+   */
+  std::string str(const size_t i) const {
+    return data.substr(offsets[i], offsets[i + 1] - offsets[i]);
+  }
+
+  /**
+   * Gets the points of a shape as a range over the buffer, nothing is copied.
+   * @param   i  Index of the shape.
+   */
+  EncodedPolyline shape(const size_t i) const {
+    return EncodedPolyline(data.data() + offsets[i], offsets[i + 1] - offsets[i], precision);
+  }
+};
+
+/**
+ * Points of many shapes in one buffer. The points of shape i are those of
+ * points from offsets[i] to offsets[i + 1].
+ */
+struct DecodedShapes {
+  std::vector<PointLL> points;
+  std::vector<size_t> offsets;
+
+  DecodedShapes() : offsets(1, 0) { }
+
+  /**
+   * Gets the number of shapes.
+   */
+  size_t size() const { return offsets.size() - 1; }
+
+  /**
+   * Gets the first point of a shape, the shape has offsets[i + 1] -
+   * offsets[i] points.
+   * @param   i  Index of the shape.
+   */
+  const PointLL* begin(const size_t i) const { return points.data() + offsets[i]; }
+
+  /**
+   * Gets past the last point of a shape.
+   * @param   i  Index of the shape.
+   */
+  const PointLL* end(const size_t i) const { return points.data() + offsets[i + 1]; }
+};
+
+/**
+ * Polyline encode many shapes, split over threads. Every thread encodes a
+ * run of shapes with about the same number of points into a buffer of its
+ * own, which are then copied into one. The text of each shape is what
+ * encode gives.
+ *
+ * @param shapes     the shapes to encode
+ * @param precision  the decimal digits to keep
+ * @param threads    the most threads to use, counting the calling one. 1,
+ *                   the default, encodes on the calling thread, which suits a
+ *                   server already handling requests on every core. 0 is one
+ *                   per core. fewer are used for few points as starting a
+ *                   thread costs as much as encoding a few thousand of them
+ * @return shapes    the encoded shapes
+ */
+EncodedShapes encode_shapes(const std::vector<std::vector<PointLL> >& shapes,
+                            const int precision = kPolylinePrecision,
+                            const unsigned int threads = 1);
+
+/**
+ * Decode many encoded shapes, split over threads. The shapes are counted
+ * and validated first, so the points can be written straight to where
+ * they go. The points of each shape are what decode gives.
+ *
+ * @param shapes     the encoded shapes
+ * @param threads    the most threads to use, counting the calling one, 1 is
+ *                   the calling thread only and 0 is one per core
+ * @return shapes    the points of the shapes
+ * @throws std::runtime_error if a shape is not an encoded polyline
+ */
+DecodedShapes decode_shapes(const EncodedShapes& shapes, const unsigned int threads = 1);
+
+/**
+ * Decode many encoded shapes given as strings, split over threads.
+ *
+ * @param shapes     the encoded shapes
+ * @param precision  the decimal digits that were kept
+ * @param threads    the most threads to use, counting the calling one, 1 is
+ *                   the calling thread only and 0 is one per core
+ * @return shapes    the points of the shapes
+ * @throws std::runtime_error if a shape is not an encoded polyline
+ */
+DecodedShapes decode_shapes(const std::vector<std::string>& shapes,
+                            const int precision = kPolylinePrecision,
+                            const unsigned int threads = 1);
+
+}
+}
+
+#endif  // VALHALLA_MIDGARD_SHAPEBATCH_H_
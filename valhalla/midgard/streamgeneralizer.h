@@ -0,0 +1,83 @@
+#ifndef VALHALLA_MIDGARD_STREAMGENERALIZER_H_
+#define VALHALLA_MIDGARD_STREAMGENERALIZER_H_
+
+#include <vector>
+#include <cstdint>
+
+#include <valhalla/midgard/point2.h>
+#include <valhalla/midgard/pointll.h>
+
+namespace valhalla {
+namespace midgard {
+
+/**
+ * Generalizes a polyline whose points arrive one at a time, like a GPS trace
+ * being ingested, without holding on to the whole polyline. Uses an opening
+ * window: the points since the last output point (the anchor) are buffered
+ * and as long as all of them are within the tolerance of the segment from
+ * the anchor to the newest point the window keeps growing. Once a point
+ * falls outside, or the buffer is full, the point before the newest is
+ * output and becomes the new anchor.
+ *
+ * Every dropped point is within the tolerance of the output segment that
+ * spans it, with the same distances as Polyline2::Generalize. Memory is fixed
+ * by the buffer capacity and points are output at most that many points
+ * behind the input. Output is not the same as Douglas-Peucker on the whole
+ * polyline, which needs all the points up front.
+ *
+ * This is a template class that works with Point2 (Euclidean x,y) or
+ * PointLL (latitude,longitude).
+ */
+template <class coord_t>
+class StreamGeneralizer {
+ public:
+  /**
+   * Constructor.
+   * @param  t         Generalization tolerance.
+   * @param  capacity  Most points held between output points, at least 1.
+   */
+  StreamGeneralizer(const float t, const uint32_t capacity = 32);
+
+  /**
+   * Add the next point of the polyline. Points equal to the previous
+   * point are skipped.
+   * @param  p    Point to add.
+   * @param  out  Set to the point to output, if any.
+   * @return  Returns true if a point was output.
+   */
+  bool Add(const coord_t& p, coord_t& out);
+
+  /**
+   * End the polyline, output its last point and get ready for the next one.
+   * @param  out  Set to the last point, if any.
+   * @return  Returns true if a point was output.
+   */
+  bool Finish(coord_t& out);
+
+  /**
+   * Gets the number of points held back.
+   * @return  Returns the number of buffered points.
+   */
+  uint32_t size() const;
+
+ protected:
+  // Tolerance squared
+  float t2_;
+
+  // Most points held between output points
+  uint32_t capacity_;
+
+  // Whether there is an anchor, false until the first point
+  bool started_;
+
+  // Last output point
+  coord_t anchor_;
+
+  // Points since the anchor, never more than capacity_
+  std::vector<coord_t> window_;
+};
+
+}
+}
+
+#endif  // VALHALLA_MIDGARD_STREAMGENERALIZER_H_
@@ -0,0 +1,146 @@
+#ifndef VALHALLA_MIDGARD_TILEPYRAMID_H_
+#define VALHALLA_MIDGARD_TILEPYRAMID_H_
+
+#include <vector>
+#include <cstdint>
+
+#include <valhalla/midgard/aabb2.h>
+#include <valhalla/midgard/tiles.h>
+
+namespace valhalla {
+namespace midgard {
+
+/**
+ * A hierarchy of tiling systems sharing the same bounding box where each
+ * level subdivides the tiles of the level above it by an integer factor
+ * (for example 4 degree, 1 degree and 0.25 degree tiles). This is a template
+ * class that works with Point2 (Euclidean x,y) or PointLL (latitude,longitude).
+ *
+ * A level and a tile Id within that level are packed into a single Id with
+ * the level in the low kLevelBits bits and the tile Id above it. Since all
+ * levels share the same origin, moving between levels (parent, children,
+ * ancestors) only needs integer row and column arithmetic.
+ */
+template <class coord_t>
+class TilePyramid {
+ public:
+  // Number of bits used to store the level within a packed Id
+  static constexpr uint32_t kLevelBits = 3;
+  static constexpr uint32_t kMaxLevels = 1 << kLevelBits;
+
+  /**
+   * Constructor. Level 0 is the coarsest level. Each tile size must divide
+   * the tile size of the previous level an integer number of times, and no
+   * level can have more than 2^(31 - kLevelBits) tiles so that its packed
+   * Ids are positive.
+   * @param  bounds     Bounding box shared by all levels.
+   * @param  tilesizes  Tile size of each level from coarsest to finest.
+   * @param  subdivisions  Number of subdivisions within tiles of each level.
+   */
+  TilePyramid(const AABB2<coord_t>& bounds, const std::vector<float>& tilesizes,
+              const unsigned short subdivisions = 1);
+
+  /**
+   * Get the number of levels.
+   * @return  Returns the number of levels in the pyramid.
+   */
+  uint32_t levels() const;
+
+  /**
+   * Get the tiling system of a level.
+   * @param  level  Level.
+   * @return  Returns the tiles of the level.
+   * @throws std::out_of_range if the pyramid has no such level.
+   */
+  const Tiles<coord_t>& tiles(const uint32_t level) const;
+
+  /**
+   * Pack a level and tile Id into a single Id.
+   * @param  level   Level.
+   * @param  tileid  Tile Id within the level.
+   * @return  Returns the packed Id.
+   */
+  static int32_t Id(const uint32_t level, const int32_t tileid);
+
+  /**
+   * Get the level of a packed Id.
+   * @param  id  Packed Id.
+   * @return  Returns the level.
+   */
+  static uint32_t Level(const int32_t id);
+
+  /**
+   * Get the tile Id (within its level) of a packed Id.
+   * @param  id  Packed Id.
+   * @return  Returns the tile Id.
+   */
+  static int32_t TileId(const int32_t id);
+
+  /**
+   * Get the packed Id of the tile containing a coordinate at a level.
+   * @param  c      Coordinate / point.
+   * @param  level  Level.
+   * @return  Returns the packed Id or -1 if the coordinate is outside of
+   *          the pyramid bounds.
+   * @throws std::out_of_range if the pyramid has no such level.
+   */
+  int32_t TileId(const coord_t& c, const uint32_t level) const;
+
+  /**
+   * Get the parent of a tile (the tile on the level above containing it).
+   * @param  id  Packed Id.
+   * @return  Returns the packed Id of the parent or -1 if the tile is on
+   *          the coarsest level or is not a tile of the pyramid.
+   */
+  int32_t Parent(const int32_t id) const;
+
+  /**
+   * Get the ancestor of a tile on a coarser (or the same) level.
+   * @param  id     Packed Id.
+   * @param  level  Level of the ancestor.
+   * @return  Returns the packed Id of the ancestor or -1 if the level is
+   *          finer than the level of the tile or the tile is not a tile of
+   *          the pyramid.
+   */
+  int32_t Ancestor(const int32_t id, const uint32_t level) const;
+
+  /**
+   * Get the children of a tile (the tiles on the level below it covers).
+   * @param  id  Packed Id.
+   * @return  Returns the packed Ids of the children in row-major order.
+   *          Empty if the tile is on the finest level or is not a tile of
+   *          the pyramid.
+   */
+  std::vector<int32_t> Children(const int32_t id) const;
+
+  /**
+   * Get the tiles of every level that intersect a bounding box. The tile
+   * range is found once on the finest level and derived for the other
+   * levels using integer division.
+   * @param  boundingbox  Bounding box.
+   * @return  Returns packed Ids ordered by level and then by tile Id.
+   */
+  std::vector<int32_t> Cover(const AABB2<coord_t>& boundingbox) const;
+
+  /**
+   * Get the tiles of every level that a linestring intersects. The
+   * linestring is only rasterized on the finest level, coarser levels are
+   * found from the ancestors of those tiles.
+   * @param  linestring  The linestring.
+   * @return  Returns packed Ids ordered by level and then by tile Id.
+   */
+  template <class container_t>
+  std::vector<int32_t> Cover(const container_t& linestring) const;
+
+ protected:
+  // Tiling system of each level, from coarsest to finest
+  std::vector<Tiles<coord_t> > levels_;
+
+  // Number of tiles along one side of a level 0 tile at each level
+  std::vector<int32_t> scale_;
+};
+
+}
+}
+
+#endif  // VALHALLA_MIDGARD_TILEPYRAMID_H_
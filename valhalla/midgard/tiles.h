@@ -3,6 +3,9 @@
 #define VALHALLA_MIDGARD_TILES_H_
 
 #include <list>
+#include <vector>
+#include <tuple>
+#include <functional>
 #include <unordered_set>
 #include <unordered_map>
 #include <cstdint>
@@ -13,6 +16,22 @@
 namespace valhalla {
 namespace midgard {
 
+// Order in which tiles are laid out when sorting or listing them. Tile Ids
+// are always row-major, the curve orders only change the sequence tiles are
+// emitted in so that spatially adjacent tiles end up close to one another.
+enum TileOrder {
+  kRowMajor,
+  kMorton,
+  kHilbert
+};
+
+// Part of a shape within a single tile, see Tiles::Split
+struct TilePiece {
+  int32_t tileid;   // Tile the piece is in
+  uint32_t begin;   // Index of the first point of the piece
+  uint32_t end;     // Index one past the last point of the piece
+};
+
 /**
  * A class that provides a uniform (square) tiling system for a specified
  * bounding box and tile size. This is a template class that works with
@@ -33,10 +52,15 @@ class Tiles {
    * Constructor.  A bounding box and tile size is specified.
    * Sets class data members and computes the number of rows and columns
    * based on the bounding box and tile size.
-   * @param   bounds    Bounding box
-   * @param   tilesize  Tile size
+   * @param   bounds        Bounding box
+   * @param   tilesize      Tile size
+   * @param   subdivisions  Number of subdivisions along each side of a tile
+   * @param   order         Order in which TileList and OrderedTileIds
+   *                        emit tiles.
    */
-  Tiles(const AABB2<coord_t>& bounds, const float tilesize, const unsigned short subdivisions = 1);
+  Tiles(const AABB2<coord_t>& bounds, const float tilesize,
+        const unsigned short subdivisions = 1,
+        const TileOrder order = kRowMajor);
 
   /**
    * Get the tile size.
@@ -44,6 +68,24 @@ class Tiles {
    */
   float TileSize() const;
 
+  /**
+   * Get the number of subdivisions along each side of a tile.
+   * @return  Returns the number of subdivisions.
+   */
+  unsigned short nsubdivisions() const;
+
+  /**
+   * Get the order in which tiles are emitted.
+   * @return  Returns the tile order.
+   */
+  TileOrder tile_order() const;
+
+  /**
+   * Set the order in which tiles are emitted.
+   * @param  order  Tile order.
+   */
+  void set_tile_order(const TileOrder order);
+
   /**
    * Get the number of rows in the tiling system.
    * @return  Returns the number of rows.
@@ -95,6 +137,33 @@ class Tiles {
    */
   int32_t TileId(const float y, const float x) const;
 
+  /**
+   * Convert arrays of y,x coordinates into tile Ids and, optionally, the
+   * index of the subdivision within the tile each point falls in. Uses SSE2
+   * (or AVX2 when compiled for it) kernels that multiply by the reciprocal of
+   * the tile size, correcting lanes that land near a tile boundary, so the
+   * tile Ids are exactly the same as calling TileId on each point.
+   * @param  ys            Array of y (or lat) coordinates.
+   * @param  xs            Array of x (or lng) coordinates.
+   * @param  count         Number of coordinates.
+   * @param  tileids       Output array of count tile Ids. -1 for points
+   *                       outside of the tiling system.
+   * @param  subdivisions  Optional output array of count subdivision
+   *                       indices. 0 for points outside of the tiling system.
+   */
+  void TileIds(const float* ys, const float* xs, const size_t count,
+               int32_t* tileids, unsigned short* subdivisions = nullptr) const;
+
+  /**
+   * Convert a list of points into tile Ids and, optionally, the index of the
+   * subdivision within the tile each point falls in. See above.
+   * @param  pts           List of points.
+   * @param  tileids       Output. Tile Id of each point.
+   * @param  subdivisions  Optional output. Subdivision of each point.
+   */
+  void TileIds(const std::vector<coord_t>& pts, std::vector<int32_t>& tileids,
+               std::vector<unsigned short>* subdivisions = nullptr) const;
+
   /**
    * Get the tile Id given the row Id and column Id.
    * @param  col  Tile column.
@@ -110,6 +179,41 @@ class Tiles {
    */
   std::pair<int32_t, int32_t> GetRowColumn(const int32_t tileid) const;
 
+  /**
+   * Get the position of a tile along the space filling curve of the tile
+   * order. For the Morton and Hilbert orders the curve covers the smallest
+   * power of 2 square that contains all rows and columns, so indices are
+   * sparse when the tiling system is not square or a power of 2 wide.
+   * @param  tileid  Tile Id (row-major).
+   * @return  Returns the curve index. For kRowMajor this is the tile Id.
+   */
+  uint64_t CurveIndex(const int32_t tileid) const;
+
+  /**
+   * Get the tile Id (row-major) at a position along the space filling
+   * curve of the tile order.
+   * @param  index  Curve index.
+   * @return  Returns the tile Id. Returns -1 if the curve index lies outside
+   *          of the tiling system.
+   */
+  int32_t TileIdFromCurveIndex(const uint64_t index) const;
+
+  /**
+   * Sort a list of tile Ids by their position along the tile order curve.
+   * Does nothing if the tile order is kRowMajor.
+   * @param  tileids  In/Out. List of tile Ids.
+   */
+  void SortTileIds(std::vector<int32_t>& tileids) const;
+
+  /**
+   * Get the tile Ids of an intersection result in tile order. For kRowMajor
+   * the tile Ids are sorted by increasing Id.
+   * @param  intersection  Result of one of the Intersect methods.
+   * @return  Returns the list of intersected tile Ids.
+   */
+  std::vector<int32_t> OrderedTileIds(const std::unordered_map<int32_t,
+                             std::unordered_set<unsigned short> >& intersection) const;
+
   /**
    * Get a maximum tileid given a bounds and a tile size.
    * @param bound       the region for which to compute the maximum tile id
@@ -219,12 +323,31 @@ class Tiles {
    * Get the list of tiles that lie within the specified bounding box.
    * The method finds the center tile and spirals out by finding neighbors
    * and recursively checking if tile is inside and checking/adding
-   * neighboring tiles
+   * neighboring tiles. If a Morton or Hilbert tile order is set the list
+   * is sorted along that curve.
    * @param  boundingbox  Bounding box
-   * @param  maxTiles  Maximum number of tiles to find.
    */
   const std::vector<int32_t>& TileList(const AABB2<coord_t>& boundingbox);
 
+  /**
+   * Get a function that visits the tiles (or the subdivisions of the tiles)
+   * in order of increasing distance from a seed point, diagonal neighbors
+   * included. Each call returns the next tile Id, the subdivision index
+   * (0 when not visiting subdivisions) and the minimum distance from the
+   * seed to anywhere within it. For PointLL the distance is in meters using
+   * a DistanceApproximator at the seed, the same metric PointLL::ClosestPoint
+   * uses, so a search can stop as soon as its best candidate is closer than
+   * the distance returned. Once everything has been visited the returned
+   * tile Id is -1. The function refers to this object so it must not
+   * outlive it.
+   * @param  seed          Point to measure distances from. May be outside
+   *                       of the tiling system.
+   * @param  subdivisions  If true visit subdivisions rather than whole tiles.
+   * @return  Returns the function yielding <tile Id, subdivision, distance>.
+   */
+  std::function<std::tuple<int32_t, unsigned short, float>()> ClosestFirst(
+                    const coord_t& seed, const bool subdivisions = false) const;
+
   /**
    * Color a "connectivity map" starting with a sparse map of uncolored tiles.
    * Any 2 tiles that have a connected path between them will have the same
@@ -242,6 +365,28 @@ class Tiles {
   template <class container_t>
   std::unordered_map<int32_t, std::unordered_set<unsigned short> > Intersect(const container_t& linestring) const;
 
+  /**
+   * Split a shape into the pieces that fall within each tile, walking the
+   * shape once. Each segment steps from tile to tile across the tile edges
+   * it crosses, so the work is linear in the number of points and edge
+   * crossings rather than shape size times tiles. Like Intersect, segments
+   * are straight lines in x,y (lng,lat). Parts of the shape outside the
+   * tiling system bounds are left out.
+   * @param  shape     Shape to split.
+   * @param  pieces    Output, the tile and range of points of each piece in
+   *                   the order they occur along the shape. A shape that
+   *                   leaves a tile and comes back has more than one piece
+   *                   in that tile.
+   * @param  points    Output, the points of all pieces one after the other.
+   *                   Pieces start and end at the points where the shape
+   *                   crosses tile edges, which lie exactly on the edges.
+   * @param  segments  Output, for each point the index of the shape segment
+   *                   it is on. Shape vertices are on the segment they
+   *                   start, the last vertex on the last segment.
+   */
+  void Split(const std::vector<coord_t>& shape, std::vector<TilePiece>& pieces,
+             std::vector<coord_t>& points, std::vector<uint32_t>& segments) const;
+
   /**
    * Intersect a circle with the tiles to see which tiles and sub cells it intersects
    * @param center  the center of the circle
@@ -257,6 +402,10 @@ class Tiles {
   // Tile size.  Tiles are square (equal y and x size).
   float tilesize_;
 
+  // Reciprocals of the tile and subdivision sizes, used by the batch TileIds
+  float inv_tilesize_;
+  float inv_subdivision_size_;
+
   // Number of rows ( y or latitude)
   int32_t nrows_;
 
@@ -268,6 +417,12 @@ class Tiles {
 
   float subdivision_size_;
 
+  // Order in which tiles are emitted
+  TileOrder tile_order_;
+
+  // Power of 2 side length of the square covered by the ordering curve
+  uint32_t curve_size_;
+
   // Tile list - populated by the TileList method.
   std::vector<int32_t> tilelist_;
 };
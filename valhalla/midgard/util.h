@@ -10,8 +10,12 @@
 #include <unordered_set>
 #include <memory>
 #include <limits>
+#include <cstdlib>
+#include <new>
+#include <vector>
 
 #include <valhalla/midgard/pointll.h>
+#include <valhalla/midgard/encoded.h>
 
 
 namespace valhalla {
@@ -84,26 +88,6 @@ float length(const container_t& pts) {
  return length;
 }
 
-/**
- * Polyline encode a container of points into a string
- * Note: newer versions of this algorithm allow one to specify a zoom level
- * which allows displaying simplified versions of the encoded linestring
- *
- * @param points    the list of points to encode
- * @return string   the encoded container of points
- */
-template<class container_t>
-std::string encode(const container_t& points);
-
-/**
- * Polyline decode a string into a container of points
- *
- * @param string    the encoded points
- * @return points   the container of points
- */
-template<class container_t>
-container_t decode(const std::string& encoded);
-
 //useful in converting from one iteratable map to another
 //for example: ToMap<boost::property_tree::ptree, std::unordered_map<std::string, std::string> >(some_ptree)
 /*
@@ -157,6 +141,39 @@ std::unique_ptr<T> make_unique(Args&&... args) {
   return std::unique_ptr<T>{new T{std::forward<Args>(args)...}};
 }
 
+/**
+ * Allocator returning memory aligned to the given number of bytes, for
+ * containers whose data is loaded with aligned SIMD instructions.
+ */
+template <class T, size_t alignment>
+struct aligned_allocator {
+  using value_type = T;
+  template <class U>
+  struct rebind { using other = aligned_allocator<U, alignment>; };
+
+  aligned_allocator() = default;
+  template <class U>
+  aligned_allocator(const aligned_allocator<U, alignment>&) { }
+
+  T* allocate(const size_t n) {
+    void* p = nullptr;
+    if (posix_memalign(&p, alignment, n * sizeof(T)) != 0)
+      throw std::bad_alloc();
+    return static_cast<T*>(p);
+  }
+  void deallocate(T* p, size_t) {
+    free(p);
+  }
+};
+template <class T, class U, size_t alignment>
+bool operator==(const aligned_allocator<T, alignment>&, const aligned_allocator<U, alignment>&) {
+  return true;
+}
+template <class T, class U, size_t alignment>
+bool operator!=(const aligned_allocator<T, alignment>&, const aligned_allocator<U, alignment>&) {
+  return false;
+}
+
 /* circular range clamp
  */
 template <class T>